@@ -5,6 +5,11 @@
 
 #include <mpi.h>
 #include <string.h>
+#include <stdio.h>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <new>
 
 /* Comm Routines */
 
@@ -52,6 +57,1456 @@
    non-coherent load/store opcodes?
 */
 
+/*
+   Hybrid exchange (-hybrid, needs MPI_THREAD_MULTIPLE).  When the
+   routines below are called by every thread of a ParRun team, the
+   message slots are dealt out round robin and each thread posts,
+   packs, sends and waits for its own messages.  The summing and
+   overwriting unpacks (CommSBN, CommSyncPosVel) touch nodes that
+   several messages share, so there each thread waits for its own
+   receives and, after a barrier, applies all messages to its own range
+   of node planes in the usual message order: the result is the same as
+   with the funneled exchange.  Without -hybrid or -tpack (below), or
+   outside a ParRun region, the routines are called by a single thread
+   as before.
+*/
+
+/* Number of threads making MPI calls in this exchange */
+static inline Int_t CommTeamSize(Domain& domain)
+{
+   return domain.commHybrid() ? ParTeamSize() : 1 ;
+}
+
+/* Number of threads packing and unpacking in this exchange */
+static inline Int_t CommPackTeamSize(Domain& domain)
+{
+   return (domain.commHybrid() || domain.commTeamPack()) ? ParTeamSize() : 1 ;
+}
+
+/* True if this thread handles message slot msg */
+static inline bool CommOwnsMsg(Index_t msg, Int_t team)
+{
+   return Int_t(msg % team) == ParThreadId() ;
+}
+
+/* The messages of CommSend in the order it posts them, as the
+ * direction (col, row, plane) of the neighbor.  Messages to higher
+ * ranks are only sent with doSend. */
+static const Int_t s_commSendDir[26][3] = {
+   {  0,  0, -1 }, {  0,  0,  1 }, {  0, -1,  0 },
+   {  0,  1,  0 }, { -1,  0,  0 }, {  1,  0,  0 },
+   { -1, -1,  0 }, {  0, -1, -1 }, { -1,  0, -1 },
+   {  1,  1,  0 }, {  0,  1,  1 }, {  1,  0,  1 },
+   { -1,  1,  0 }, {  0, -1,  1 }, { -1,  0,  1 },
+   {  1, -1,  0 }, {  0,  1, -1 }, {  1,  0, -1 },
+   { -1, -1, -1 }, { -1, -1,  1 }, {  1, -1, -1 }, {  1, -1,  1 },
+   { -1,  1, -1 }, { -1,  1,  1 }, {  1,  1, -1 }, {  1,  1,  1 }
+} ;
+
+/*
+   Team packing (-tpack).  The whole ParRun team enters the exchange
+   routines but only thread 0 talks to MPI, so MPI_THREAD_FUNNELED is
+   enough.  Thread 0 picks the buffers of the six faces and the team
+   packs them together, each thread a range of lines of every face;
+   thread 0 posts them after a barrier and packs the edges and corners
+   alone.  Only the faces are threaded: an edge is one line and a
+   corner a single value per field, too little to split.  For the
+   unpacks thread 0 waits for everything and the team then splits the
+   node planes as with -hybrid.
+
+   The face kernels below answer the questions above as follows.  A
+   face is a set of lines: for case (a) and (b) the values of a line
+   are contiguous, so the line loops vectorize, and for case (c) they
+   are dx apart.  The message layout is unchanged (fields packed
+   tightly, one after the other) and threads split a face by lines,
+   which keeps the lines of different threads in different cache lines
+   of the field arrays except at the ends.  The case (c) loads touch
+   one value per cache line, so their lines are prefetched ahead with
+   the non-temporal locality hint.  These are prefetch hints, not
+   non-temporal loads (the compiler has none for ordinary write-back
+   memory); the hint only keeps the column out of the outer cache
+   levels it would otherwise evict.
+*/
+
+/* Distance, in values, of the case (c) prefetches */
+#define COMM_PREFETCH_DIST 8
+
+#if defined(__GNUC__)
+#define COMM_PREFETCH_NTA(addr, rw) __builtin_prefetch((addr), (rw), 0)
+#else
+#define COMM_PREFETCH_NTA(addr, rw)
+#endif
+
+static bool s_commPrefetch = true ;   // the case (c) prefetches, see -packbench
+
+/* The prefetched lines end COMM_PREFETCH_DIST values before the end of
+ * the line, so no address past the line is formed; the last values are
+ * copied by a tail loop without prefetches. */
+static inline Index_t CommPrefetchEnd(Index_t len)
+{
+   return (len > COMM_PREFETCH_DIST) ? len - COMM_PREFETCH_DIST : 0 ;
+}
+
+/* Packs lines i0..i1-1 of a face of one field.  Line i of the field
+ * starts at field[i*stride] and its len values are step apart; line i
+ * of the buffer starts at buf[i*len]. */
+static inline void CommPackLines(Real_t *buf, const Real_t *field,
+                                 Index_t i0, Index_t i1, Index_t len,
+                                 Index_t stride, Index_t step)
+{
+   if (step == 1) {
+      for (Index_t i=i0 ; i<i1 ; ++i) {
+         Real_t *dst = buf + i*len ;
+         const Real_t *src = field + i*stride ;
+#pragma omp simd
+         for (Index_t j=0 ; j<len ; ++j) {
+            dst[j] = src[j] ;
+         }
+      }
+   }
+   else if (s_commPrefetch) {
+      Index_t jPre = CommPrefetchEnd(len) ;
+      for (Index_t i=i0 ; i<i1 ; ++i) {
+         Real_t *dst = buf + i*len ;
+         const Real_t *src = field + i*stride ;
+         Index_t j ;
+         for (j=0 ; j<jPre ; ++j) {
+            COMM_PREFETCH_NTA(&src[(j + COMM_PREFETCH_DIST)*step], 0) ;
+            dst[j] = src[j*step] ;
+         }
+         for ( ; j<len ; ++j) {
+            dst[j] = src[j*step] ;
+         }
+      }
+   }
+   else {
+      for (Index_t i=i0 ; i<i1 ; ++i) {
+         Real_t *dst = buf + i*len ;
+         const Real_t *src = field + i*stride ;
+         for (Index_t j=0 ; j<len ; ++j) {
+            dst[j] = src[j*step] ;
+         }
+      }
+   }
+}
+
+/* Unpacks lines i0..i1-1 of a face of one field, the inverse of
+ * CommPackLines; adds to the field when sum is set, overwrites it
+ * otherwise */
+static inline void CommUnpackLines(Real_t *field, const Real_t *buf,
+                                   Index_t i0, Index_t i1, Index_t len,
+                                   Index_t stride, Index_t step, bool sum)
+{
+   Index_t jPre = CommPrefetchEnd(len) ;
+   for (Index_t i=i0 ; i<i1 ; ++i) {
+      Real_t *dst = field + i*stride ;
+      const Real_t *src = buf + i*len ;
+      if (step == 1 && sum) {
+#pragma omp simd
+         for (Index_t j=0 ; j<len ; ++j) {
+            dst[j] += src[j] ;
+         }
+      }
+      else if (step == 1) {
+#pragma omp simd
+         for (Index_t j=0 ; j<len ; ++j) {
+            dst[j] = src[j] ;
+         }
+      }
+      else if (!s_commPrefetch) {
+         for (Index_t j=0 ; j<len ; ++j) {
+            dst[j*step] = sum ? dst[j*step] + src[j] : src[j] ;
+         }
+      }
+      else if (sum) {
+         Index_t j ;
+         for (j=0 ; j<jPre ; ++j) {
+            COMM_PREFETCH_NTA(&dst[(j + COMM_PREFETCH_DIST)*step], 1) ;
+            dst[j*step] += src[j] ;
+         }
+         for ( ; j<len ; ++j) {
+            dst[j*step] += src[j] ;
+         }
+      }
+      else {
+         Index_t j ;
+         for (j=0 ; j<jPre ; ++j) {
+            COMM_PREFETCH_NTA(&dst[(j + COMM_PREFETCH_DIST)*step], 1) ;
+            dst[j*step] = src[j] ;
+         }
+         for ( ; j<len ; ++j) {
+            dst[j*step] = src[j] ;
+         }
+      }
+   }
+}
+
+/* A face message of CommSend: lines of len values, line i of a field
+ * starting at offset + i*stride */
+struct CommFace_t {
+   Real_t *buf ;
+   Index_t offset ;
+   Index_t lines ;
+   Index_t len ;
+   Index_t stride ;
+   Index_t step ;
+   int toRank ;
+   Index_t msg ;
+} ;
+
+struct CommFaceList_t {
+   Int_t num ;
+   CommFace_t face[6] ;
+} ;
+
+static inline void CommAddFace(CommFaceList_t &list, Real_t *buf,
+                               Index_t offset, Index_t lines, Index_t len,
+                               Index_t stride, Index_t step,
+                               int toRank, Index_t msg)
+{
+   CommFace_t &face = list.face[list.num++] ;
+   face.buf = buf ;
+   face.offset = offset ;
+   face.lines = lines ;
+   face.len = len ;
+   face.stride = stride ;
+   face.step = step ;
+   face.toRank = toRank ;
+   face.msg = msg ;
+}
+
+/* Packs the faces of list, field after field.  With shared set the
+ * list is thread 0's and every thread of the team packs its range of
+ * lines of each face; the faces are complete when this returns. */
+static void CommPackFaces(Domain& domain, Index_t xferFields,
+                          Domain_member *fieldData,
+                          CommFaceList_t *list, bool shared)
+{
+   if (shared) {
+      list = static_cast<CommFaceList_t *>(ParBroadcast(list)) ;
+   }
+   for (Int_t f=0 ; f<list->num ; ++f) {
+      const CommFace_t &face = list->face[f] ;
+      Index_t i0 = 0 ;
+      Index_t i1 = face.lines ;
+      if (shared) {
+         ParRange(0, face.lines, &i0, &i1) ;
+      }
+      for (Index_t fi=0 ; fi<xferFields ; ++fi) {
+         CommPackLines(face.buf + fi*face.lines*face.len,
+                       &(domain.*fieldData[fi])(face.offset),
+                       i0, i1, face.len, face.stride, face.step) ;
+      }
+   }
+   if (shared) {
+      ParBarrier() ;
+   }
+}
+
+/*
+   Neighborhood collective exchange (-neighbor).  main() then runs on a
+   Cartesian communicator created with reorder, so the MPI library may
+   place the process grid on the network; the domain of a process
+   follows its rank in that communicator.  On top of it a distributed
+   graph communicator lists the (up to 26) neighbors, and an exchange
+   becomes one MPI_Ineighbor_alltoallv: CommRecv and CommSend only note
+   the count and buffer offset of each message, CommSend starts the
+   collective once everything is packed, and the unpack routines wait
+   for it.  Outside of it the buffers and their layout are unchanged.
+   The collective is called by one thread, so with -hybrid the
+   exchanges made by the whole team stay point-to-point.
+*/
+struct CommNeighborhood_t {
+   MPI_Comm graph ;
+   int numNbr ;
+   int rank[26] ;
+   int sendCount[26] ;
+   int sendDispl[26] ;
+   int recvCount[26] ;
+   int recvDispl[26] ;
+   Real_t *sendBase ;
+   Real_t *recvBase ;
+   bool active ;               // the current exchange is collective
+   MPI_Request request ;
+} ;
+
+static CommNeighborhood_t s_nbr = {
+   MPI_COMM_NULL, 0, { 0 }, { 0 }, { 0 }, { 0 }, { 0 }, NULL, NULL, false,
+   MPI_REQUEST_NULL
+} ;
+
+static inline bool CommUseNeighborhood(Domain& domain, Int_t team)
+{
+   return domain.commNeighbor() && (team == 1) &&
+          (s_nbr.graph != MPI_COMM_NULL) ;
+}
+
+/* Notes a message of the collective exchange */
+static inline void CommNoteNeighborMsg(int rank, Real_t *buf, int count,
+                                       bool send)
+{
+   for (Int_t n=0 ; n<s_nbr.numNbr ; ++n) {
+      if (s_nbr.rank[n] == rank) {
+         if (send) {
+            s_nbr.sendCount[n] = count ;
+            s_nbr.sendDispl[n] = int(buf - s_nbr.sendBase) ;
+         }
+         else {
+            s_nbr.recvCount[n] = count ;
+            s_nbr.recvDispl[n] = int(buf - s_nbr.recvBase) ;
+         }
+         return ;
+      }
+   }
+}
+
+/* Waits for the collective exchange, if one is in flight */
+static inline void CommWaitNeighborhood()
+{
+   if (s_nbr.request != MPI_REQUEST_NULL) {
+      MPI_Wait(&s_nbr.request, MPI_STATUS_IGNORE) ;
+   }
+}
+
+/*
+   Shared-memory exchange (-shm).  The receive buffers of the ranks of
+   a node live in one MPI-3 shared window, and a message to a neighbor
+   on the same node never goes through MPI: the sender packs straight
+   into the receiver's commDataRecv, where the receiver unpacks it as
+   before.  Each rank's part of the window starts with a control block
+   of one slot per direction of a neighbor.  CommRecv posts a receive by
+   writing its buffer offset and count to the slot of the sender and
+   bumping the slot's posted count; the sender waits for that, packs,
+   and bumps the filled count, and the unpack routines wait for the
+   filled counts before they start.  Every exchange posts its receives
+   before its sends and finishes its unpacks before the next one posts,
+   so the nth message between two ranks always meets the nth receive
+   and a rank never packs into a buffer that is still being unpacked.
+   Neighbors on other nodes keep using messages.
+*/
+struct CommSharedSlot_t {
+   std::atomic<long> posted ;   // receives posted by the owner
+   std::atomic<long> filled ;   // messages packed by the neighbor
+   Index_t offset ;             // into the owner's commDataRecv
+   Index_t count ;
+   char pad[128 - 2*sizeof(std::atomic<long>) - 2*sizeof(Index_t)] ;
+} ;
+
+struct CommSharedCtl_t {
+   CommSharedSlot_t slot[26] ;   // by s_commSendDir entry of the neighbor
+} ;
+
+struct CommSharedPeer_t {
+   int rank ;                    // -1 unless the neighbor is on this node
+   CommSharedCtl_t *ctl ;
+   Real_t *recvBase ;
+} ;
+
+struct CommShared_t {
+   MPI_Comm node ;
+   MPI_Win win ;
+   bool active ;                 // the current exchange uses the window
+   CommSharedCtl_t *ctl ;
+   Real_t *recvBase ;
+   Real_t *heapRecv ;            // commDataRecv of the Domain constructor
+   MPI_Request *recvRequestBase ;
+   CommSharedPeer_t peer[26] ;
+   Int_t opposite[26] ;          // direction of this rank seen from peer[m]
+   long sendSeq[26] ;
+   long recvSeq[26] ;
+   long recvWait[26] ;           // receive to wait for, 0 if none
+   Index_t recvMsg[26] ;         // its message slot
+} ;
+
+static CommShared_t s_shm = {
+   MPI_COMM_NULL, MPI_WIN_NULL, false, NULL, NULL, NULL, NULL
+} ;
+
+static inline bool CommUseShared(Domain& domain)
+{
+   return domain.commShared() && (s_shm.win != MPI_WIN_NULL) ;
+}
+
+/* Direction of a neighbor on this node, -1 if rank is not one */
+static inline Int_t CommSharedDir(int rank)
+{
+   if (!s_shm.active) {
+      return -1 ;
+   }
+   for (Int_t m=0 ; m<26 ; ++m) {
+      if (s_shm.peer[m].rank == rank) {
+         return m ;
+      }
+   }
+   return -1 ;
+}
+
+/* Posts the receive of message slot msg from the neighbor in
+ * direction m */
+static inline void CommSharedPostRecv(Int_t m, Real_t *buf, int count,
+                                      Index_t msg)
+{
+   CommSharedSlot_t &slot = s_shm.ctl->slot[m] ;
+   slot.offset = Index_t(buf - s_shm.recvBase) ;
+   slot.count = count ;
+   s_shm.recvWait[m] = ++s_shm.recvSeq[m] ;
+   s_shm.recvMsg[m] = msg ;
+   slot.posted.store(s_shm.recvWait[m], std::memory_order_release) ;
+}
+
+/* Where to pack a message of count values for toRank: the receiver's
+ * buffer once it has posted the receive, or buf */
+static inline Real_t *CommSendBuffer(Real_t *buf, int count, int toRank)
+{
+   Int_t m = CommSharedDir(toRank) ;
+   if (m < 0) {
+      return buf ;
+   }
+   const CommSharedPeer_t &peer = s_shm.peer[m] ;
+   CommSharedSlot_t &slot = peer.ctl->slot[s_shm.opposite[m]] ;
+   long seq = s_shm.sendSeq[m] + 1 ;
+   while (slot.posted.load(std::memory_order_acquire) < seq) {
+      std::this_thread::yield() ;
+   }
+   if (slot.count != count) {
+      fprintf(stderr, "Shared-memory message size mismatch (%d vs %d)\n",
+              int(slot.count), count) ;
+      MPI_Abort(MPI_COMM_WORLD, -1) ;
+   }
+   return peer.recvBase + slot.offset ;
+}
+
+/* Completes a message packed into the receiver's buffer; false if
+ * toRank is not on this node */
+static inline bool CommSharedSend(int toRank)
+{
+   Int_t m = CommSharedDir(toRank) ;
+   if (m < 0) {
+      return false ;
+   }
+   CommSharedSlot_t &slot = s_shm.peer[m].ctl->slot[s_shm.opposite[m]] ;
+   slot.filled.store(++s_shm.sendSeq[m], std::memory_order_release) ;
+   return true ;
+}
+
+/* Waits until the neighbors have packed this thread's receives */
+static inline void CommWaitShared(Int_t team)
+{
+   for (Int_t m=0 ; m<26 ; ++m) {
+      if (s_shm.recvWait[m] == 0 || !CommOwnsMsg(s_shm.recvMsg[m], team)) {
+         continue ;
+      }
+      CommSharedSlot_t &slot = s_shm.ctl->slot[m] ;
+      while (slot.filled.load(std::memory_order_acquire) < s_shm.recvWait[m]) {
+         std::this_thread::yield() ;
+      }
+      s_shm.recvWait[m] = 0 ;
+   }
+}
+
+/*
+   One-sided exchange (-rma fence|pscw).  commDataRecv is exposed in an
+   RMA window over domain.comm, and a message becomes an MPI_Put of the
+   packed buffer to where the receiver would have received it, so no
+   receive has to be matched.  A receiver announces each buffer offset
+   once per argument set of CommRecv: the first exchange of the set
+   sends the offsets to the senders, who keep them by message slot.
+   Synchronization is either collective fences (CommRecv opens the
+   epoch, the unpack routine closes it) or post-start-complete-wait
+   with the group of the neighbors: CommRecv posts the exposure,
+   CommSend starts the access epoch and completes it once the puts are
+   issued, and the unpack routines wait for the exposure to end.  The
+   window is used by one thread, so with -hybrid the exchanges made by
+   the whole team stay point-to-point; on-node neighbors with -shm
+   still go through the shared window.
+*/
+#define COMM_MAX_RMA_PATTERNS 32
+
+struct CommRmaPattern_t {
+   bool send ;
+   Int_t msgType ;
+   Index_t xferFields ;
+   Index_t dx, dy, dz ;
+   bool doXfer ;
+   bool planeOnly ;
+   bool ready ;               // the offsets have been exchanged
+   long disp[26] ;            // by message slot, in the receiver's buffer
+   MPI_Request request[26] ;  // offset messages of the first exchange
+} ;
+
+struct CommRma_t {
+   MPI_Win win ;
+   MPI_Group group ;          // the neighbors
+   Int_t sync ;               // COMM_RMA_FENCE or COMM_RMA_PSCW
+   bool active ;              // the current exchange is one-sided
+   bool exposed ;             // receives posted, not yet waited for
+   bool started ;             // access epoch open (PSCW)
+   CommRmaPattern_t *pat ;
+   Real_t *recvBase ;
+   MPI_Request *recvRequestBase ;
+   MPI_Request *sendRequestBase ;
+   Int_t numPattern ;
+   CommRmaPattern_t pattern[COMM_MAX_RMA_PATTERNS] ;
+} ;
+
+static CommRma_t s_rma = {
+   MPI_WIN_NULL, MPI_GROUP_NULL, COMM_RMA_NONE, false, false, false,
+   NULL, NULL, NULL, NULL, 0
+} ;
+
+static inline bool CommUseRma(Domain& domain, Int_t team)
+{
+   return (domain.commRma() != COMM_RMA_NONE) && (team == 1) &&
+          (s_rma.win != MPI_WIN_NULL) ;
+}
+
+/* The offsets of an argument set; NULL if the table is full, in which
+ * case every rank falls back to messages for it */
+static CommRmaPattern_t *CommFindRmaPattern(bool send, Int_t msgType,
+                                            Index_t xferFields,
+                                            Index_t dx, Index_t dy, Index_t dz,
+                                            bool doXfer, bool planeOnly)
+{
+   for (Int_t i=0 ; i<s_rma.numPattern ; ++i) {
+      CommRmaPattern_t &pat = s_rma.pattern[i] ;
+      if (pat.send == send && pat.msgType == msgType &&
+          pat.xferFields == xferFields &&
+          pat.dx == dx && pat.dy == dy && pat.dz == dz &&
+          pat.doXfer == doXfer && pat.planeOnly == planeOnly) {
+         return &pat ;
+      }
+   }
+   if (s_rma.numPattern == COMM_MAX_RMA_PATTERNS) {
+      return NULL ;
+   }
+
+   CommRmaPattern_t &pat = s_rma.pattern[s_rma.numPattern++] ;
+   pat.send = send ;
+   pat.msgType = msgType ;
+   pat.xferFields = xferFields ;
+   pat.dx = dx ;
+   pat.dy = dy ;
+   pat.dz = dz ;
+   pat.doXfer = doXfer ;
+   pat.planeOnly = planeOnly ;
+   pat.ready = false ;
+   for (Index_t i=0 ; i<26 ; ++i) {
+      pat.disp[i] = 0 ;
+      pat.request[i] = MPI_REQUEST_NULL ;
+   }
+   return &pat ;
+}
+
+/* Sets up the one-sided side of an exchange; the caller falls back to
+ * messages unless this returns true */
+static inline bool CommBeginRma(Domain& domain, Int_t team, bool send,
+                                Int_t msgType, Index_t xferFields,
+                                Index_t dx, Index_t dy, Index_t dz,
+                                bool doXfer, bool planeOnly)
+{
+   s_rma.pat = NULL ;
+   if (CommUseRma(domain, team)) {
+      s_rma.pat = CommFindRmaPattern(send, msgType, xferFields,
+                                     dx, dy, dz, doXfer, planeOnly) ;
+   }
+   s_rma.active = (s_rma.pat != NULL) ;
+   return s_rma.active ;
+}
+
+/* End of CommRecv: the receive buffer is exposed to the neighbors */
+static inline void CommExposeRma()
+{
+   CommRmaPattern_t *pat = s_rma.pat ;
+   if (!pat->ready) {
+      MPI_Waitall(26, pat->request, MPI_STATUSES_IGNORE) ;
+      pat->ready = true ;
+   }
+   if (s_rma.sync == COMM_RMA_PSCW) {
+      MPI_Win_post(s_rma.group, 0, s_rma.win) ;
+   }
+   else {
+      MPI_Win_fence(MPI_MODE_NOPRECEDE, s_rma.win) ;
+   }
+   s_rma.exposed = true ;
+   s_rma.active = false ;
+}
+
+/* Before the puts of CommSend */
+static inline void CommStartRma()
+{
+   if (s_rma.sync == COMM_RMA_PSCW) {
+      MPI_Win_start(s_rma.group, 0, s_rma.win) ;
+      s_rma.started = true ;
+   }
+}
+
+/* Ends the access epoch: the send buffers may be reused (PSCW).  With
+ * fences the puts complete at the fence of the unpack. */
+static inline void CommCompleteRma()
+{
+   if (s_rma.started) {
+      MPI_Win_complete(s_rma.win) ;
+      s_rma.started = false ;
+   }
+}
+
+/* Waits until the neighbors' puts into this rank's buffer are done */
+static inline void CommWaitRma()
+{
+   if (!s_rma.exposed) {
+      return ;
+   }
+   // with -overlap the sends may not have been finished yet, and the
+   // neighbors wait for their completion
+   CommCompleteRma() ;
+   if (s_rma.sync == COMM_RMA_PSCW) {
+      MPI_Win_wait(s_rma.win) ;
+   }
+   else {
+      MPI_Win_fence(MPI_MODE_NOSUCCEED, s_rma.win) ;
+   }
+   s_rma.exposed = false ;
+}
+
+/*
+   Dimension-sweep exchange (-sweep).  The 26 messages of an exchange
+   are routed through the face neighbors in three stages, x, then y,
+   then z, so a rank sends and receives at most 6 messages: an edge
+   message takes two hops and a corner message three, forwarded by the
+   ranks in between.  A stage message is the list of the original
+   messages it carries, each preceded by its direction and length.
+   CommRecv and CommSend only note the buffers of the messages; the end
+   of CommRecv posts the six stage receives and the end of CommSend
+   sends the x stage.  The unpack routines run the y and z stages and
+   copy every message that has reached its destination into the receive
+   buffer it would have been received into, so CommSBN and
+   CommSyncPosVel sum and overwrite the same values in the same order as
+   with separate messages and the results are bitwise the same.  The
+   sweep is run by one thread, so with -hybrid the exchanges made by
+   the whole team stay point-to-point.
+*/
+#define COMM_SWEEP_HEADER 4    // direction and length of a carried message
+
+struct CommSweepEntry_t {
+   Int_t dir[3] ;               // from the sender to the destination
+   Index_t count ;
+   const Real_t *data ;
+} ;
+
+struct CommSweep_t {
+   MPI_Comm comm ;
+   bool active ;                // the current exchange is swept
+   bool pending ;               // stages left to run
+   Int_t msgType ;
+   int rank[26] ;               // neighbor by s_commSendDir entry, -1 if none
+   int faceRank[6] ;            // stage neighbors: -x, +x, -y, +y, -z, +z
+   Index_t stageSize ;          // capacity of a stage buffer
+   Real_t *stageBuf ;           // 6 send, then 6 receive buffers
+   MPI_Request sendRequest[6] ;
+   MPI_Request recvRequest[6] ;
+   Real_t *recvBuf[26] ;        // by direction of the sender
+   Index_t recvCount[26] ;
+   Int_t numExpected ;
+   Int_t numDelivered ;
+   CommSweepEntry_t held[54] ;  // messages still to send or forward
+   Int_t numHeld ;
+} ;
+
+static CommSweep_t s_sweep = {
+   MPI_COMM_NULL, false, false, 0
+} ;
+
+static inline bool CommUseSweep(Domain& domain, Int_t team)
+{
+   return domain.commSweep() && (team == 1) && (s_sweep.stageBuf != NULL) ;
+}
+
+/* s_commSendDir entry of direction dir */
+static inline Int_t CommSweepDirIndex(const Int_t dir[3])
+{
+   for (Int_t m=0 ; m<26 ; ++m) {
+      if (s_commSendDir[m][0] == dir[0] && s_commSendDir[m][1] == dir[1] &&
+          s_commSendDir[m][2] == dir[2]) {
+         return m ;
+      }
+   }
+   return -1 ;
+}
+
+/* s_commSendDir entry of a neighbor */
+static inline Int_t CommSweepRankIndex(int rank)
+{
+   for (Int_t m=0 ; m<26 ; ++m) {
+      if (s_sweep.rank[m] == rank) {
+         return m ;
+      }
+   }
+   fprintf(stderr, "Rank %d is not a neighbor of the sweep\n", rank) ;
+   MPI_Abort(MPI_COMM_WORLD, -1) ;
+   return -1 ;
+}
+
+/* Start of CommRecv */
+static inline void CommBeginSweep(Int_t msgType)
+{
+   s_sweep.msgType = msgType ;
+   for (Int_t m=0 ; m<26 ; ++m) {
+      s_sweep.recvBuf[m] = NULL ;
+      s_sweep.recvCount[m] = 0 ;
+   }
+   s_sweep.numExpected = 0 ;
+   s_sweep.numDelivered = 0 ;
+   s_sweep.numHeld = 0 ;
+}
+
+static inline void CommSweepNoteRecv(int fromRank, Real_t *buf, int count)
+{
+   Int_t m = CommSweepRankIndex(fromRank) ;
+   s_sweep.recvBuf[m] = buf ;
+   s_sweep.recvCount[m] = count ;
+   ++s_sweep.numExpected ;
+}
+
+static inline void CommSweepNoteSend(int toRank, const Real_t *buf, int count)
+{
+   const Int_t *dir = s_commSendDir[CommSweepRankIndex(toRank)] ;
+   CommSweepEntry_t &entry = s_sweep.held[s_sweep.numHeld++] ;
+   entry.dir[0] = dir[0] ;
+   entry.dir[1] = dir[1] ;
+   entry.dir[2] = dir[2] ;
+   entry.count = count ;
+   entry.data = buf ;
+}
+
+/* End of CommRecv: posts the receives of all three stages */
+static void CommPostSweepRecvs()
+{
+   MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
+   for (Int_t f=0 ; f<6 ; ++f) {
+      s_sweep.recvRequest[f] = MPI_REQUEST_NULL ;
+      if (s_sweep.faceRank[f] >= 0) {
+         MPI_Irecv(&s_sweep.stageBuf[(6 + f)*s_sweep.stageSize],
+                   s_sweep.stageSize, baseType, s_sweep.faceRank[f],
+                   s_sweep.msgType, s_sweep.comm, &s_sweep.recvRequest[f]) ;
+      }
+   }
+   s_sweep.pending = true ;
+}
+
+/* Sends the held messages that go along axis a and drops them */
+static void CommSendSweepStage(Int_t a)
+{
+   MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
+   for (Int_t side=0 ; side<2 ; ++side) {
+      Int_t f = 2*a + side ;
+      Int_t dir = (side == 0) ? -1 : 1 ;
+      s_sweep.sendRequest[f] = MPI_REQUEST_NULL ;
+      if (s_sweep.faceRank[f] < 0) {
+         continue ;
+      }
+      Real_t *buf = &s_sweep.stageBuf[f*s_sweep.stageSize] ;
+      Index_t len = 1 ;
+      Int_t num = 0 ;
+      Int_t keep = 0 ;
+      for (Int_t i=0 ; i<s_sweep.numHeld ; ++i) {
+         const CommSweepEntry_t &entry = s_sweep.held[i] ;
+         if (entry.dir[a] != dir) {
+            s_sweep.held[keep++] = entry ;
+            continue ;
+         }
+         if (len + COMM_SWEEP_HEADER + entry.count > s_sweep.stageSize) {
+            fprintf(stderr, "Sweep stage buffer too small\n") ;
+            MPI_Abort(MPI_COMM_WORLD, -1) ;
+         }
+         buf[len] = Real_t(entry.dir[0]) ;
+         buf[len + 1] = Real_t(entry.dir[1]) ;
+         buf[len + 2] = Real_t(entry.dir[2]) ;
+         buf[len + 3] = Real_t(entry.count) ;
+         memcpy(&buf[len + COMM_SWEEP_HEADER], entry.data,
+                entry.count*sizeof(Real_t)) ;
+         len += COMM_SWEEP_HEADER + entry.count ;
+         ++num ;
+      }
+      s_sweep.numHeld = keep ;
+      buf[0] = Real_t(num) ;
+      MPI_Isend(buf, len, baseType, s_sweep.faceRank[f], s_sweep.msgType,
+                s_sweep.comm, &s_sweep.sendRequest[f]) ;
+   }
+}
+
+/* Receives the stage of axis a: keeps the messages that go on and
+ * copies the others to their receive buffers */
+static void CommRecvSweepStage(Int_t a)
+{
+   MPI_Status status ;
+   for (Int_t side=0 ; side<2 ; ++side) {
+      Int_t f = 2*a + side ;
+      if (s_sweep.faceRank[f] < 0) {
+         continue ;
+      }
+      MPI_Wait(&s_sweep.recvRequest[f], &status) ;
+      const Real_t *buf = &s_sweep.stageBuf[(6 + f)*s_sweep.stageSize] ;
+      Int_t num = Int_t(buf[0]) ;
+      Index_t pos = 1 ;
+      for (Int_t k=0 ; k<num ; ++k) {
+         CommSweepEntry_t entry ;
+         entry.dir[0] = Int_t(buf[pos]) ;
+         entry.dir[1] = Int_t(buf[pos + 1]) ;
+         entry.dir[2] = Int_t(buf[pos + 2]) ;
+         entry.count = Index_t(buf[pos + 3]) ;
+         entry.data = &buf[pos + COMM_SWEEP_HEADER] ;
+         pos += COMM_SWEEP_HEADER + entry.count ;
+
+         bool arrived = true ;
+         for (Int_t b=a+1 ; b<3 ; ++b) {
+            arrived = arrived && (entry.dir[b] == 0) ;
+         }
+         if (!arrived) {
+            s_sweep.held[s_sweep.numHeld++] = entry ;
+            continue ;
+         }
+         // the sender is in the opposite direction
+         const Int_t from[3] = { -entry.dir[0], -entry.dir[1], -entry.dir[2] } ;
+         Int_t m = CommSweepDirIndex(from) ;
+         if (s_sweep.recvBuf[m] == NULL || s_sweep.recvCount[m] != entry.count) {
+            fprintf(stderr, "Unexpected sweep message from direction %d\n", int(m)) ;
+            MPI_Abort(MPI_COMM_WORLD, -1) ;
+         }
+         memcpy(s_sweep.recvBuf[m], entry.data, entry.count*sizeof(Real_t)) ;
+         ++s_sweep.numDelivered ;
+      }
+   }
+}
+
+/* Runs the stages left; afterwards the receive buffers hold what the
+ * separate messages would have put there */
+static void CommFinishSweep()
+{
+   if (!s_sweep.pending) {
+      return ;
+   }
+   for (Int_t a=0 ; a<3 ; ++a) {
+      CommRecvSweepStage(a) ;
+      if (a < 2) {
+         CommSendSweepStage(a + 1) ;
+      }
+   }
+   MPI_Waitall(6, s_sweep.sendRequest, MPI_STATUSES_IGNORE) ;
+   if (s_sweep.numHeld != 0 || s_sweep.numDelivered != s_sweep.numExpected) {
+      fprintf(stderr, "Sweep exchange incomplete\n") ;
+      MPI_Abort(MPI_COMM_WORLD, -1) ;
+   }
+   s_sweep.pending = false ;
+}
+
+/* Waits for the parts of the exchange that do not go through
+ * recvRequest: those of this thread with -hybrid, all of them on
+ * thread 0 otherwise */
+static inline void CommWaitOther(Int_t team)
+{
+   if (team == 1 && ParThreadId() != 0) {
+      return ;
+   }
+   CommWaitNeighborhood() ;
+   CommWaitShared(team) ;
+   CommWaitRma() ;
+   CommFinishSweep() ;
+}
+
+/*
+   Persistent exchange (-persist).  CommRecv and CommSend are only ever
+   called with a handful of argument sets, and every call with the same
+   set posts the same messages: same buffer offsets, counts, peers and
+   tag.  The first call of a set creates persistent requests for it with
+   MPI_Recv_init/MPI_Send_init; later calls only restart them, the
+   receives of a call all at once with MPI_Startall and each send with
+   MPI_Start as soon as its buffer is packed.  Completing a persistent
+   request leaves it allocated, so recvRequest/sendRequest hold copies
+   of the handles and the MPI_Wait calls are the same in both modes.
+*/
+#define COMM_MAX_PATTERNS 32
+
+struct CommPattern_t {
+   bool send ;
+   Int_t msgType ;
+   Index_t xferFields ;
+   Index_t dx, dy, dz ;
+   bool doXfer ;
+   bool planeOnly ;
+   MPI_Request *slotBase ;   // domain.recvRequest or domain.sendRequest
+   MPI_Request request[26] ;
+} ;
+
+static CommPattern_t s_commPattern[COMM_MAX_PATTERNS] ;
+static Int_t s_numCommPattern = 0 ;
+static std::mutex s_commPatternLock ;
+
+/* The persistent requests of an argument set, NULL for plain
+ * nonblocking calls */
+static CommPattern_t *CommFindPattern(Domain& domain, bool send,
+                                      Int_t msgType, Index_t xferFields,
+                                      Index_t dx, Index_t dy, Index_t dz,
+                                      bool doXfer, bool planeOnly)
+{
+   if (!domain.commPersistent() || s_nbr.active || s_rma.active) {
+      return NULL ;
+   }
+
+   std::lock_guard<std::mutex> guard(s_commPatternLock) ;
+   for (Int_t i=0 ; i<s_numCommPattern ; ++i) {
+      CommPattern_t &pat = s_commPattern[i] ;
+      if (pat.send == send && pat.msgType == msgType &&
+          pat.xferFields == xferFields &&
+          pat.dx == dx && pat.dy == dy && pat.dz == dz &&
+          pat.doXfer == doXfer && pat.planeOnly == planeOnly) {
+         return &pat ;
+      }
+   }
+   if (s_numCommPattern == COMM_MAX_PATTERNS) {
+      return NULL ;
+   }
+
+   CommPattern_t &pat = s_commPattern[s_numCommPattern++] ;
+   pat.send = send ;
+   pat.msgType = msgType ;
+   pat.xferFields = xferFields ;
+   pat.dx = dx ;
+   pat.dy = dy ;
+   pat.dz = dz ;
+   pat.doXfer = doXfer ;
+   pat.planeOnly = planeOnly ;
+   pat.slotBase = send ? domain.sendRequest : domain.recvRequest ;
+   for (Index_t i=0 ; i<26 ; ++i) {
+      pat.request[i] = MPI_REQUEST_NULL ;
+   }
+   return &pat ;
+}
+
+/* MPI_Irecv, or with a pattern: set up the persistent receive of the
+ * slot.  It is started by CommStartRecvs at the end of CommRecv. */
+static inline void CommPostRecv(Real_t *buf, int count, MPI_Datatype type,
+                                int fromRank, int tag, MPI_Comm comm,
+                                CommPattern_t *pat, MPI_Request *request)
+{
+   if (s_sweep.active) {
+      CommSweepNoteRecv(fromRank, buf, count) ;
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   Int_t m = CommSharedDir(fromRank) ;
+   if (m >= 0) {
+      CommSharedPostRecv(m, buf, count, request - s_shm.recvRequestBase) ;
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (s_rma.active) {
+      // the sender learns the offset with the first exchange
+      CommRmaPattern_t *pat = s_rma.pat ;
+      if (!pat->ready) {
+         Index_t msg = request - s_rma.recvRequestBase ;
+         pat->disp[msg] = long(buf - s_rma.recvBase) ;
+         MPI_Isend(&pat->disp[msg], 1, MPI_LONG, fromRank,
+                   MSG_RMA_OFFSET + tag, comm, &pat->request[msg]) ;
+      }
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (s_nbr.active) {
+      CommNoteNeighborMsg(fromRank, buf, count, false) ;
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (pat == NULL) {
+      MPI_Irecv(buf, count, type, fromRank, tag, comm, request) ;
+      return ;
+   }
+   MPI_Request &persistent = pat->request[request - pat->slotBase] ;
+   if (persistent == MPI_REQUEST_NULL) {
+      MPI_Recv_init(buf, count, type, fromRank, tag, comm, &persistent) ;
+   }
+   *request = persistent ;
+}
+
+/* MPI_Isend, or with a pattern: (re)start the persistent send of the
+ * slot */
+static inline void CommPostSend(Real_t *buf, int count, MPI_Datatype type,
+                                int toRank, int tag, MPI_Comm comm,
+                                CommPattern_t *pat, MPI_Request *request)
+{
+   if (s_sweep.active) {
+      CommSweepNoteSend(toRank, buf, count) ;
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (CommSharedSend(toRank)) {
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (s_rma.active) {
+      CommRmaPattern_t *pat = s_rma.pat ;
+      Index_t msg = request - s_rma.sendRequestBase ;
+      if (!pat->ready) {
+         MPI_Recv(&pat->disp[msg], 1, MPI_LONG, toRank,
+                  MSG_RMA_OFFSET + tag, comm, MPI_STATUS_IGNORE) ;
+      }
+      MPI_Put(buf, count, type, toRank, MPI_Aint(pat->disp[msg]),
+              count, type, s_rma.win) ;
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (s_nbr.active) {
+      CommNoteNeighborMsg(toRank, buf, count, true) ;
+      *request = MPI_REQUEST_NULL ;
+      return ;
+   }
+   if (pat == NULL) {
+      MPI_Isend(buf, count, type, toRank, tag, comm, request) ;
+      return ;
+   }
+   MPI_Request &persistent = pat->request[request - pat->slotBase] ;
+   if (persistent == MPI_REQUEST_NULL) {
+      MPI_Send_init(buf, count, type, toRank, tag, comm, &persistent) ;
+   }
+   MPI_Start(&persistent) ;
+   *request = persistent ;
+}
+
+/* Starts the receives this thread has set up in CommRecv */
+static inline void CommStartRecvs(Domain& domain, Int_t team)
+{
+   MPI_Request start[26] ;
+   int numStart = 0 ;
+   for (Index_t i=0 ; i<26 ; ++i) {
+      if (CommOwnsMsg(i, team) && domain.recvRequest[i] != MPI_REQUEST_NULL) {
+         start[numStart++] = domain.recvRequest[i] ;
+      }
+   }
+   if (numStart > 0) {
+      MPI_Startall(numStart, start) ;
+   }
+}
+
+/*
+   Derived datatype sends (-dtype).  Instead of packing into
+   commDataSend, each message is described by an MPI datatype that
+   picks its face, edge or corner out of every field array in place: a
+   subarray of the dx*dy*dz block per field, combined with
+   MPI_Type_create_struct at the absolute addresses of the fields and
+   sent from MPI_BOTTOM.  The subarray is traversed in C order, which
+   is the order of the hand-written pack loops, so receivers unpack the
+   same buffers as before.  Types are built the first time a field set
+   is sent and rebuilt when the arrays move (the MonoQ gradients are
+   reallocated every cycle).  Receives still go through commDataRecv,
+   since CommSBN sums and CommSyncPosVel overwrites in message order.
+   With -shm the sends are packed, so on-node neighbors get theirs in
+   place.
+*/
+#define COMM_MAX_SEND_TYPES 16
+
+struct CommSendType_t {
+   Index_t xferFields ;
+   Index_t dx, dy, dz ;
+   Domain_member field[MAX_FIELDS_PER_MPI_COMM] ;
+   Real_t *base[MAX_FIELDS_PER_MPI_COMM] ;
+   MPI_Datatype type[26] ;   // by s_commSendDir entry
+} ;
+
+static CommSendType_t s_commSendType[COMM_MAX_SEND_TYPES] ;
+static Int_t s_numCommSendType = 0 ;
+
+static void CommFreeSendTypes(CommSendType_t &st)
+{
+   for (Index_t m=0 ; m<26 ; ++m) {
+      if (st.type[m] != MPI_DATATYPE_NULL) {
+         MPI_Type_free(&st.type[m]) ;
+      }
+   }
+}
+
+/* Builds the datatype of message m for the arrays in st.base */
+static void CommBuildSendType(CommSendType_t &st, Index_t m)
+{
+   MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
+   // C order: plane, row, col
+   int size[3] = { int(st.dz), int(st.dy), int(st.dx) } ;
+   int subSize[3] ;
+   int start[3] ;
+   for (Int_t d=0 ; d<3 ; ++d) {
+      Int_t dir = s_commSendDir[m][2 - d] ;
+      subSize[d] = (dir == 0) ? size[d] : 1 ;
+      start[d] = (dir > 0) ? size[d] - 1 : 0 ;
+   }
+
+   MPI_Datatype face ;
+   MPI_Type_create_subarray(3, size, subSize, start, MPI_ORDER_C,
+                            baseType, &face) ;
+
+   int blockLen[MAX_FIELDS_PER_MPI_COMM] ;
+   MPI_Aint displ[MAX_FIELDS_PER_MPI_COMM] ;
+   MPI_Datatype fieldType[MAX_FIELDS_PER_MPI_COMM] ;
+   for (Index_t fi=0 ; fi<st.xferFields ; ++fi) {
+      blockLen[fi] = 1 ;
+      MPI_Get_address(st.base[fi], &displ[fi]) ;
+      fieldType[fi] = face ;
+   }
+   MPI_Type_create_struct(int(st.xferFields), blockLen, displ, fieldType,
+                          &st.type[m]) ;
+   MPI_Type_commit(&st.type[m]) ;
+   MPI_Type_free(&face) ;
+}
+
+/* The send types of a field set, built or rebuilt as needed */
+static CommSendType_t *CommFindSendTypes(Domain& domain, Index_t xferFields,
+                                         Domain_member *fieldData,
+                                         Index_t dx, Index_t dy, Index_t dz)
+{
+   std::lock_guard<std::mutex> guard(s_commPatternLock) ;
+   CommSendType_t *st = NULL ;
+   for (Int_t i=0 ; i<s_numCommSendType && st == NULL ; ++i) {
+      CommSendType_t &cand = s_commSendType[i] ;
+      bool same = (cand.xferFields == xferFields &&
+                   cand.dx == dx && cand.dy == dy && cand.dz == dz) ;
+      for (Index_t fi=0 ; same && fi<xferFields ; ++fi) {
+         same = (cand.field[fi] == fieldData[fi]) ;
+      }
+      if (same) {
+         st = &cand ;
+      }
+   }
+   if (st == NULL) {
+      if (s_numCommSendType == COMM_MAX_SEND_TYPES) {
+         return NULL ;
+      }
+      st = &s_commSendType[s_numCommSendType++] ;
+      st->xferFields = xferFields ;
+      st->dx = dx ;
+      st->dy = dy ;
+      st->dz = dz ;
+      for (Index_t fi=0 ; fi<xferFields ; ++fi) {
+         st->field[fi] = fieldData[fi] ;
+         st->base[fi] = NULL ;
+      }
+      for (Index_t m=0 ; m<26 ; ++m) {
+         st->type[m] = MPI_DATATYPE_NULL ;
+      }
+   }
+
+   bool moved = false ;
+   for (Index_t fi=0 ; fi<xferFields ; ++fi) {
+      Real_t *base = &(domain.*fieldData[fi])(0) ;
+      if (st->base[fi] != base) {
+         st->base[fi] = base ;
+         moved = true ;
+      }
+   }
+   if (moved) {
+      CommFreeSendTypes(*st) ;
+   }
+   return st ;
+}
+
+/* Posts the sends of CommSend from the field arrays; false if no types
+ * are available and the caller has to pack */
+static bool CommPostTypedSends(Domain& domain, Int_t msgType,
+                               Index_t xferFields, Domain_member *fieldData,
+                               Index_t dx, Index_t dy, Index_t dz,
+                               bool doSend, bool planeOnly, Int_t team)
+{
+   CommSendType_t *st = CommFindSendTypes(domain, xferFields, fieldData,
+                                          dx, dy, dz) ;
+   if (st == NULL) {
+      return false ;
+   }
+
+   const Index_t loc[3] = { domain.colLoc(), domain.rowLoc(), domain.planeLoc() } ;
+   const Index_t numProc[3] = { domain.tpx(), domain.tpy(), domain.tpz() } ;
+   int myRank ;
+   Index_t msg = 0 ;
+   MPI_Comm_rank(domain.comm, &myRank) ;
+
+   for (Index_t m=0 ; m<(planeOnly ? 6 : 26) ; ++m) {
+      const Int_t *dir = s_commSendDir[m] ;
+      bool exists = true ;
+      for (Int_t d=0 ; d<3 ; ++d) {
+         if ((dir[d] < 0 && loc[d] == 0) ||
+             (dir[d] > 0 && loc[d] == numProc[d] - 1)) {
+            exists = false ;
+         }
+      }
+      if (!exists) {
+         continue ;
+      }
+      int toRank = myRank + dir[2]*domain.tpx()*domain.tpy() +
+                   dir[1]*domain.tpx() + dir[0] ;
+      if (toRank > myRank && !doSend) {
+         continue ;
+      }
+      if (CommOwnsMsg(msg, team)) {
+         // only the owner of a message touches its type
+         if (st->type[m] == MPI_DATATYPE_NULL) {
+            CommBuildSendType(*st, m) ;
+         }
+         MPI_Isend(MPI_BOTTOM, 1, st->type[m], toRank, msgType,
+                   domain.comm, &domain.sendRequest[msg]) ;
+      }
+      ++msg ;
+   }
+   return true ;
+}
+
+/* Waits for this thread's sends */
+static inline void CommWaitSends(Domain& domain, Int_t team)
+{
+   MPI_Status status[26] ;
+   CommCompleteRma() ;
+   if (team == 1) {
+      MPI_Waitall(26, domain.sendRequest, status) ;
+   }
+   else {
+      for (Index_t i=0; i<26; ++i) {
+         if (CommOwnsMsg(i, team)) {
+            MPI_Wait(&domain.sendRequest[i], &status[i]) ;
+         }
+      }
+   }
+}
+
+/* Creates the Cartesian communicator of a px x py x pz process grid
+ * (-neighbor); ranks in it are numbered like the domains, plane by
+ * plane, row by row */
+MPI_Comm CommCreateCart(const Int_t side[3])
+{
+   int dims[3] = { int(side[2]), int(side[1]), int(side[0]) } ;
+   int periods[3] = { 0, 0, 0 } ;
+   MPI_Comm cart ;
+   MPI_Cart_create(MPI_COMM_WORLD, 3, dims, periods, 1, &cart) ;
+   return cart ;
+}
+
+/* Creates the neighbor graph of the collective exchange on
+ * domain.comm */
+void CommSetupNeighborhood(Domain& domain)
+{
+   const Index_t loc[3] = { domain.colLoc(), domain.rowLoc(), domain.planeLoc() } ;
+   const Index_t numProc[3] = { domain.tpx(), domain.tpy(), domain.tpz() } ;
+   int myRank ;
+   MPI_Comm_rank(domain.comm, &myRank) ;
+
+   s_nbr.numNbr = 0 ;
+   for (Index_t m=0 ; m<26 ; ++m) {
+      const Int_t *dir = s_commSendDir[m] ;
+      bool exists = true ;
+      for (Int_t d=0 ; d<3 ; ++d) {
+         if ((dir[d] < 0 && loc[d] == 0) ||
+             (dir[d] > 0 && loc[d] == numProc[d] - 1)) {
+            exists = false ;
+         }
+      }
+      if (exists) {
+         s_nbr.rank[s_nbr.numNbr++] = myRank +
+            dir[2]*domain.tpx()*domain.tpy() + dir[1]*domain.tpx() + dir[0] ;
+      }
+   }
+
+   MPI_Dist_graph_create_adjacent(domain.comm,
+                                  s_nbr.numNbr, s_nbr.rank, MPI_UNWEIGHTED,
+                                  s_nbr.numNbr, s_nbr.rank, MPI_UNWEIGHTED,
+                                  MPI_INFO_NULL, 0, &s_nbr.graph) ;
+   s_nbr.request = MPI_REQUEST_NULL ;
+   s_nbr.active = false ;
+}
+
+/* Rank of the neighbor in s_commSendDir direction m, -1 if there is
+ * none */
+static int CommNeighborRank(Domain& domain, Index_t m, int myRank)
+{
+   const Index_t loc[3] = { domain.colLoc(), domain.rowLoc(), domain.planeLoc() } ;
+   const Index_t numProc[3] = { domain.tpx(), domain.tpy(), domain.tpz() } ;
+   const Int_t *dir = s_commSendDir[m] ;
+   for (Int_t d=0 ; d<3 ; ++d) {
+      if ((dir[d] < 0 && loc[d] == 0) ||
+          (dir[d] > 0 && loc[d] == numProc[d] - 1)) {
+         return -1 ;
+      }
+   }
+   return myRank + dir[2]*domain.tpx()*domain.tpy() + dir[1]*domain.tpx() + dir[0] ;
+}
+
+/* Moves commDataRecv into a window shared by the ranks of this node
+ * and finds the neighbors that are on it (-shm).  Collective over
+ * domain.comm. */
+void CommSetupShared(Domain& domain)
+{
+   // control block rounded up to whole cache lines
+   const MPI_Aint ctlSize = MPI_Aint(sizeof(CommSharedCtl_t) + 127) & ~MPI_Aint(127) ;
+   MPI_Aint size = ctlSize + MPI_Aint(domain.commBufSize*sizeof(Real_t)) ;
+   char *base ;
+   int myRank ;
+   MPI_Info info ;
+
+   MPI_Comm_rank(domain.comm, &myRank) ;
+   MPI_Comm_split_type(domain.comm, MPI_COMM_TYPE_SHARED, myRank,
+                       MPI_INFO_NULL, &s_shm.node) ;
+   MPI_Info_create(&info) ;
+   MPI_Info_set(info, "alloc_shared_noncontig", "true") ;
+   MPI_Win_allocate_shared(size, 1, info, s_shm.node, &base, &s_shm.win) ;
+   MPI_Info_free(&info) ;
+
+   s_shm.ctl = new (base) CommSharedCtl_t ;
+   for (Index_t m=0 ; m<26 ; ++m) {
+      s_shm.ctl->slot[m].posted.store(0) ;
+      s_shm.ctl->slot[m].filled.store(0) ;
+      s_shm.ctl->slot[m].offset = 0 ;
+      s_shm.ctl->slot[m].count = 0 ;
+      s_shm.sendSeq[m] = 0 ;
+      s_shm.recvSeq[m] = 0 ;
+      s_shm.recvWait[m] = 0 ;
+      s_shm.recvMsg[m] = 0 ;
+   }
+   s_shm.heapRecv = domain.commDataRecv ;
+   domain.commDataRecv = reinterpret_cast<Real_t *>(base + ctlSize) ;
+   memset(domain.commDataRecv, 0, domain.commBufSize*sizeof(Real_t)) ;
+   s_shm.recvBase = domain.commDataRecv ;
+   s_shm.recvRequestBase = domain.recvRequest ;
+
+   MPI_Win_lock_all(MPI_MODE_NOCHECK, s_shm.win) ;
+   // the control blocks are set up before anyone looks at them
+   MPI_Barrier(s_shm.node) ;
+
+   MPI_Group group, nodeGroup ;
+   MPI_Comm_group(domain.comm, &group) ;
+   MPI_Comm_group(s_shm.node, &nodeGroup) ;
+   for (Index_t m=0 ; m<26 ; ++m) {
+      CommSharedPeer_t &peer = s_shm.peer[m] ;
+      int rank = CommNeighborRank(domain, m, myRank) ;
+      int nodeRank = MPI_UNDEFINED ;
+      peer.rank = -1 ;
+      peer.ctl = NULL ;
+      peer.recvBase = NULL ;
+      if (rank >= 0) {
+         MPI_Group_translate_ranks(group, 1, &rank, nodeGroup, &nodeRank) ;
+      }
+      if (nodeRank != MPI_UNDEFINED) {
+         MPI_Aint peerSize ;
+         int dispUnit ;
+         char *peerBase ;
+         MPI_Win_shared_query(s_shm.win, nodeRank, &peerSize, &dispUnit,
+                              &peerBase) ;
+         peer.rank = rank ;
+         peer.ctl = reinterpret_cast<CommSharedCtl_t *>(peerBase) ;
+         peer.recvBase = reinterpret_cast<Real_t *>(peerBase + ctlSize) ;
+      }
+      for (Index_t o=0 ; o<26 ; ++o) {
+         if (s_commSendDir[o][0] == -s_commSendDir[m][0] &&
+             s_commSendDir[o][1] == -s_commSendDir[m][1] &&
+             s_commSendDir[o][2] == -s_commSendDir[m][2]) {
+            s_shm.opposite[m] = o ;
+         }
+      }
+   }
+   MPI_Group_free(&nodeGroup) ;
+   MPI_Group_free(&group) ;
+}
+
+/* Exposes commDataRecv in the window of the one-sided exchange (-rma);
+ * sync is COMM_RMA_FENCE or COMM_RMA_PSCW.  Collective over
+ * domain.comm, after CommSetupShared. */
+void CommSetupRma(Domain& domain, Int_t sync)
+{
+   int ranks[26] ;
+   int numNbr = 0 ;
+   int myRank ;
+   MPI_Group group ;
+   MPI_Info info ;
+
+   MPI_Comm_rank(domain.comm, &myRank) ;
+   for (Index_t m=0 ; m<26 ; ++m) {
+      int rank = CommNeighborRank(domain, m, myRank) ;
+      if (rank >= 0) {
+         ranks[numNbr++] = rank ;
+      }
+   }
+   MPI_Comm_group(domain.comm, &group) ;
+   MPI_Group_incl(group, numNbr, ranks, &s_rma.group) ;
+   MPI_Group_free(&group) ;
+
+   MPI_Info_create(&info) ;
+   MPI_Info_set(info, "no_locks", "true") ;
+   MPI_Win_create(domain.commDataRecv,
+                  MPI_Aint(domain.commBufSize*sizeof(Real_t)), sizeof(Real_t),
+                  info, domain.comm, &s_rma.win) ;
+   MPI_Info_free(&info) ;
+
+   s_rma.sync = sync ;
+   s_rma.recvBase = domain.commDataRecv ;
+   s_rma.recvRequestBase = domain.recvRequest ;
+   s_rma.sendRequestBase = domain.sendRequest ;
+   s_rma.numPattern = 0 ;
+}
+
+/* Stage buffers and neighbors of the dimension sweep (-sweep) */
+void CommSetupSweep(Domain& domain)
+{
+   int myRank ;
+   MPI_Comm_rank(domain.comm, &myRank) ;
+   for (Index_t m=0 ; m<26 ; ++m) {
+      s_sweep.rank[m] = CommNeighborRank(domain, m, myRank) ;
+   }
+   for (Int_t f=0 ; f<6 ; ++f) {
+      Int_t dir[3] = { 0, 0, 0 } ;
+      dir[f/2] = (f % 2 == 0) ? -1 : 1 ;
+      s_sweep.faceRank[f] = s_sweep.rank[CommSweepDirIndex(dir)] ;
+      s_sweep.sendRequest[f] = MPI_REQUEST_NULL ;
+      s_sweep.recvRequest[f] = MPI_REQUEST_NULL ;
+   }
+
+   // a stage message carries at most a face, four edges and four
+   // corners
+   s_sweep.stageSize = 1 + 9*COMM_SWEEP_HEADER +
+      MAX_FIELDS_PER_MPI_COMM*(domain.maxPlaneSize() +
+                               4*domain.maxEdgeSize() + 4) ;
+   s_sweep.stageBuf = Allocate<Real_t>(12*s_sweep.stageSize) ;
+   s_sweep.comm = domain.comm ;
+   s_sweep.pending = false ;
+}
+
+/* Frees the persistent requests, the send datatypes and the
+ * communicators; call before the Domain goes away */
+void CommFreeResources(Domain& domain)
+{
+   for (Int_t p=0 ; p<s_numCommPattern ; ++p) {
+      for (Index_t i=0 ; i<26 ; ++i) {
+         if (s_commPattern[p].request[i] != MPI_REQUEST_NULL) {
+            MPI_Request_free(&s_commPattern[p].request[i]) ;
+         }
+      }
+   }
+   s_numCommPattern = 0 ;
+   for (Int_t i=0 ; i<s_numCommSendType ; ++i) {
+      CommFreeSendTypes(s_commSendType[i]) ;
+   }
+   s_numCommSendType = 0 ;
+   if (s_nbr.graph != MPI_COMM_NULL) {
+      MPI_Comm_free(&s_nbr.graph) ;
+   }
+   if (s_rma.win != MPI_WIN_NULL) {
+      MPI_Win_free(&s_rma.win) ;
+      MPI_Group_free(&s_rma.group) ;
+   }
+   if (s_sweep.stageBuf != NULL) {
+      Release(&s_sweep.stageBuf) ;
+   }
+   if (s_shm.win != MPI_WIN_NULL) {
+      domain.commDataRecv = s_shm.heapRecv ;
+      MPI_Win_unlock_all(s_shm.win) ;
+      MPI_Win_free(&s_shm.win) ;
+      MPI_Comm_free(&s_shm.node) ;
+   }
+   if (domain.comm != MPI_COMM_WORLD) {
+      MPI_Comm_free(&domain.comm) ;
+   }
+}
+
 /******************************************/
 
 
@@ -62,6 +1517,12 @@ void CommRecv(Domain& domain, Int_t msgType, Index_t xferFields,
    if (domain.numRanks() == 1)
       return ;
 
+   Int_t team = CommTeamSize(domain) ;
+
+   // with -tpack the receives are posted by thread 0
+   if (team == 1 && ParThreadId() != 0)
+      return ;
+
    /* post recieve buffers for all incoming messages */
    int myRank ;
    Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
@@ -78,290 +1539,386 @@ void CommRecv(Domain& domain, Int_t msgType, Index_t xferFields,
    if (domain.rowLoc() == 0) {
       rowMin = false ;
    }
-   if (domain.rowLoc() == (domain.tp()-1)) {
+   if (domain.rowLoc() == (domain.tpy()-1)) {
       rowMax = false ;
    }
    if (domain.colLoc() == 0) {
       colMin = false ;
    }
-   if (domain.colLoc() == (domain.tp()-1)) {
+   if (domain.colLoc() == (domain.tpx()-1)) {
       colMax = false ;
    }
    if (domain.planeLoc() == 0) {
       planeMin = false ;
    }
-   if (domain.planeLoc() == (domain.tp()-1)) {
+   if (domain.planeLoc() == (domain.tpz()-1)) {
       planeMax = false ;
    }
 
    for (Index_t i=0; i<26; ++i) {
-      domain.recvRequest[i] = MPI_REQUEST_NULL ;
+      if (CommOwnsMsg(i, team)) {
+         domain.recvRequest[i] = MPI_REQUEST_NULL ;
+      }
    }
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   s_sweep.active = CommUseSweep(domain, team) ;
+   if (s_sweep.active) {
+      CommBeginSweep(msgType) ;
+   }
+   s_shm.active = CommUseShared(domain) ;
+   s_nbr.active = !CommBeginRma(domain, team, false, msgType, xferFields,
+                                dx, dy, dz, doRecv, planeOnly) &&
+                  CommUseNeighborhood(domain, team) ;
+   if (s_nbr.active) {
+      s_nbr.recvBase = domain.commDataRecv ;
+      for (Int_t n=0 ; n<s_nbr.numNbr ; ++n) {
+         s_nbr.recvCount[n] = 0 ;
+         s_nbr.recvDispl[n] = 0 ;
+      }
+   }
+
+   CommPattern_t *pat = CommFindPattern(domain, false, msgType, xferFields,
+                                        dx, dy, dz, doRecv, planeOnly) ;
+
+   MPI_Comm_rank(domain.comm, &myRank) ;
 
    /* post receives */
 
    /* receive data from neighboring domain faces */
    if (planeMin && doRecv) {
-      /* contiguous memory */
-      int fromRank = myRank - domain.tp()*domain.tp() ;
-      int recvCount = dx * dy * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
+      if (CommOwnsMsg(pmsg, team)) {
+         /* contiguous memory */
+         int fromRank = myRank - domain.tpx()*domain.tpy() ;
+         int recvCount = dx * dy * xferFields ;
+         CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm],
+                      recvCount, baseType, fromRank, msgType,
+                      domain.comm, pat, &domain.recvRequest[pmsg]) ;
+      }
       ++pmsg ;
    }
    if (planeMax) {
-      /* contiguous memory */
-      int fromRank = myRank + domain.tp()*domain.tp() ;
-      int recvCount = dx * dy * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
+      if (CommOwnsMsg(pmsg, team)) {
+         /* contiguous memory */
+         int fromRank = myRank + domain.tpx()*domain.tpy() ;
+         int recvCount = dx * dy * xferFields ;
+         CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm],
+                      recvCount, baseType, fromRank, msgType,
+                      domain.comm, pat, &domain.recvRequest[pmsg]) ;
+      }
       ++pmsg ;
    }
    if (rowMin && doRecv) {
-      /* semi-contiguous memory */
-      int fromRank = myRank - domain.tp() ;
-      int recvCount = dx * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
+      if (CommOwnsMsg(pmsg, team)) {
+         /* semi-contiguous memory */
+         int fromRank = myRank - domain.tpx() ;
+         int recvCount = dx * dz * xferFields ;
+         CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm],
+                      recvCount, baseType, fromRank, msgType,
+                      domain.comm, pat, &domain.recvRequest[pmsg]) ;
+      }
       ++pmsg ;
    }
    if (rowMax) {
-      /* semi-contiguous memory */
-      int fromRank = myRank + domain.tp() ;
-      int recvCount = dx * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
+      if (CommOwnsMsg(pmsg, team)) {
+         /* semi-contiguous memory */
+         int fromRank = myRank + domain.tpx() ;
+         int recvCount = dx * dz * xferFields ;
+         CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm],
+                      recvCount, baseType, fromRank, msgType,
+                      domain.comm, pat, &domain.recvRequest[pmsg]) ;
+      }
       ++pmsg ;
    }
    if (colMin && doRecv) {
-      /* scattered memory */
-      int fromRank = myRank - 1 ;
-      int recvCount = dy * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
+      if (CommOwnsMsg(pmsg, team)) {
+         /* scattered memory */
+         int fromRank = myRank - 1 ;
+         int recvCount = dy * dz * xferFields ;
+         CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm],
+                      recvCount, baseType, fromRank, msgType,
+                      domain.comm, pat, &domain.recvRequest[pmsg]) ;
+      }
       ++pmsg ;
    }
    if (colMax) {
-      /* scattered memory */
-      int fromRank = myRank + 1 ;
-      int recvCount = dy * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
+      if (CommOwnsMsg(pmsg, team)) {
+         /* scattered memory */
+         int fromRank = myRank + 1 ;
+         int recvCount = dy * dz * xferFields ;
+         CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm],
+                      recvCount, baseType, fromRank, msgType,
+                      domain.comm, pat, &domain.recvRequest[pmsg]) ;
+      }
       ++pmsg ;
    }
 
    if (!planeOnly) {
       /* receive data from domains connected only by an edge */
       if (rowMin && colMin && doRecv) {
-         int fromRank = myRank - domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank - domain.tpx() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dz * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMin && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() - domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank - domain.tpx()*domain.tpy() - domain.tpx() ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dx * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (colMin && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank - domain.tpx()*domain.tpy() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dy * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMax && colMax) {
-         int fromRank = myRank + domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank + domain.tpx() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dz * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMax && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() + domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank + domain.tpx()*domain.tpy() + domain.tpx() ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dx * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (colMax && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank + domain.tpx()*domain.tpy() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dy * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMax && colMin) {
-         int fromRank = myRank + domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank + domain.tpx() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dz * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMin && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() - domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank + domain.tpx()*domain.tpy() - domain.tpx() ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dx * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (colMin && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank + domain.tpx()*domain.tpy() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dy * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMin && colMax && doRecv) {
-         int fromRank = myRank - domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank - domain.tpx() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dz * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (rowMax && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() + domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank - domain.tpx()*domain.tpy() + domain.tpx() ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dx * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       if (colMax && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int fromRank = myRank - domain.tpx()*domain.tpy() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm],
+                         dy * xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg]) ;
+         }
          ++emsg ;
       }
 
       /* receive data from domains connected only by a corner */
       if (rowMin && colMin && planeMin && doRecv) {
-         /* corner at domain logical coord (0, 0, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() - domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 0, 0) */
+            int fromRank = myRank - domain.tpx()*domain.tpy() - domain.tpx() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMin && colMin && planeMax) {
-         /* corner at domain logical coord (0, 0, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() - domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 0, 1) */
+            int fromRank = myRank + domain.tpx()*domain.tpy() - domain.tpx() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMin && colMax && planeMin && doRecv) {
-         /* corner at domain logical coord (1, 0, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() - domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 0, 0) */
+            int fromRank = myRank - domain.tpx()*domain.tpy() - domain.tpx() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMin && colMax && planeMax) {
-         /* corner at domain logical coord (1, 0, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() - domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 0, 1) */
+            int fromRank = myRank + domain.tpx()*domain.tpy() - domain.tpx() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMax && colMin && planeMin && doRecv) {
-         /* corner at domain logical coord (0, 1, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() + domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 1, 0) */
+            int fromRank = myRank - domain.tpx()*domain.tpy() + domain.tpx() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMax && colMin && planeMax) {
-         /* corner at domain logical coord (0, 1, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() + domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 1, 1) */
+            int fromRank = myRank + domain.tpx()*domain.tpy() + domain.tpx() - 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMax && colMax && planeMin && doRecv) {
-         /* corner at domain logical coord (1, 1, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() + domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 1, 0) */
+            int fromRank = myRank - domain.tpx()*domain.tpy() + domain.tpx() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
       if (rowMax && colMax && planeMax) {
-         /* corner at domain logical coord (1, 1, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() + domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 1, 1) */
+            int fromRank = myRank + domain.tpx()*domain.tpy() + domain.tpx() + 1 ;
+            CommPostRecv(&domain.commDataRecv[pmsg * maxPlaneComm +
+                                               emsg * maxEdgeComm +
+                                               cmsg * CACHE_COHERENCE_PAD_REAL],
+                         xferFields, baseType, fromRank, msgType,
+                         domain.comm, pat, &domain.recvRequest[pmsg+emsg+cmsg]) ;
+         }
          ++cmsg ;
       }
    }
+
+   if (pat != NULL) {
+      CommStartRecvs(domain, team) ;
+   }
+   if (s_rma.active) {
+      CommExposeRma() ;
+   }
+   if (s_sweep.active) {
+      CommPostSweepRecvs() ;
+      s_sweep.active = false ;
+   }
 }
 
 /******************************************/
 
-void CommSend(Domain& domain, Int_t msgType,
-              Index_t xferFields, Domain_member *fieldData,
-              Index_t dx, Index_t dy, Index_t dz, bool doSend, bool planeOnly)
+/* Packs and posts the sends; waits for them unless wait is false, in
+ * which case CommSendFinish has to be called later */
+static void CommSendMsgs(Domain& domain, Int_t msgType,
+                         Index_t xferFields, Domain_member *fieldData,
+                         Index_t dx, Index_t dy, Index_t dz,
+                         bool doSend, bool planeOnly, bool wait)
 {
 
    if (domain.numRanks() == 1)
       return ;
 
+   Int_t team = CommTeamSize(domain) ;
+   Int_t packTeam = CommPackTeamSize(domain) ;
+
+   // with -tpack the other threads only help thread 0 pack the faces
+   if (packTeam > team && ParThreadId() != 0) {
+      CommPackFaces(domain, xferFields, fieldData, NULL, true) ;
+      return ;
+   }
+
    /* post recieve buffers for all incoming messages */
    int myRank ;
    Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
@@ -370,7 +1927,6 @@ void CommSend(Domain& domain, Int_t msgType,
    Index_t emsg = 0 ; /* edge comm msg */
    Index_t cmsg = 0 ; /* corner comm msg */
    MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
-   MPI_Status status[26] ;
    Real_t *destAddr ;
    bool rowMin, rowMax, colMin, colMax, planeMin, planeMax ;
    /* assume communication to 6 neighbors by default */
@@ -378,64 +1934,90 @@ void CommSend(Domain& domain, Int_t msgType,
    if (domain.rowLoc() == 0) {
       rowMin = false ;
    }
-   if (domain.rowLoc() == (domain.tp()-1)) {
+   if (domain.rowLoc() == (domain.tpy()-1)) {
       rowMax = false ;
    }
    if (domain.colLoc() == 0) {
       colMin = false ;
    }
-   if (domain.colLoc() == (domain.tp()-1)) {
+   if (domain.colLoc() == (domain.tpx()-1)) {
       colMax = false ;
    }
    if (domain.planeLoc() == 0) {
       planeMin = false ;
    }
-   if (domain.planeLoc() == (domain.tp()-1)) {
+   if (domain.planeLoc() == (domain.tpz()-1)) {
       planeMax = false ;
    }
 
    for (Index_t i=0; i<26; ++i) {
-      domain.sendRequest[i] = MPI_REQUEST_NULL ;
+      if (CommOwnsMsg(i, team)) {
+         domain.sendRequest[i] = MPI_REQUEST_NULL ;
+      }
+   }
+
+   s_sweep.active = CommUseSweep(domain, team) ;
+   s_shm.active = CommUseShared(domain) ;
+   s_nbr.active = !CommBeginRma(domain, team, true, msgType, xferFields,
+                                dx, dy, dz, doSend, planeOnly) &&
+                  CommUseNeighborhood(domain, team) ;
+   if (s_nbr.active) {
+      s_nbr.sendBase = domain.commDataSend ;
+      for (Int_t n=0 ; n<s_nbr.numNbr ; ++n) {
+         s_nbr.sendCount[n] = 0 ;
+         s_nbr.sendDispl[n] = 0 ;
+      }
+   }
+   else if (s_rma.active) {
+      CommStartRma() ;
+   }
+   else if (domain.commDatatypes() && !s_shm.active && !s_sweep.active &&
+            CommPostTypedSends(domain, msgType, xferFields, fieldData,
+                               dx, dy, dz, doSend, planeOnly, team)) {
+      if (packTeam > team) {
+         // nothing to pack: release the team
+         CommFaceList_t none ;
+         none.num = 0 ;
+         CommPackFaces(domain, xferFields, fieldData, &none, true) ;
+      }
+      if (wait) {
+         CommWaitSends(domain, team) ;
+      }
+      return ;
    }
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   CommPattern_t *pat = CommFindPattern(domain, true, msgType, xferFields,
+                                        dx, dy, dz, doSend, planeOnly) ;
+
+   MPI_Comm_rank(domain.comm, &myRank) ;
 
    /* post sends */
 
+   /* the faces are packed first, by the team with -tpack */
+   CommFaceList_t faces ;
+   faces.num = 0 ;
+
    if (planeMin | planeMax) {
       /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
       int sendCount = dx * dy ;
 
       if (planeMin) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<sendCount; ++i) {
-               destAddr[i] = (domain.*src)(i) ;
-            }
-            destAddr += sendCount ;
+         if (CommOwnsMsg(pmsg, team)) {
+            int toRank = myRank - domain.tpx()*domain.tpy() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm],
+                                      xferFields*sendCount, toRank) ;
+            CommAddFace(faces, destAddr, 0, dy, dx, dx, 1, toRank, pmsg) ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank - domain.tp()*domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
          ++pmsg ;
       }
       if (planeMax && doSend) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<sendCount; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz - 1) + i) ;
-            }
-            destAddr += sendCount ;
+         if (CommOwnsMsg(pmsg, team)) {
+            int toRank = myRank + domain.tpx()*domain.tpy() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm],
+                                      xferFields*sendCount, toRank) ;
+            CommAddFace(faces, destAddr, dx*dy*(dz - 1), dy, dx, dx, 1,
+                        toRank, pmsg) ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank + domain.tp()*domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
          ++pmsg ;
       }
    }
@@ -444,39 +2026,22 @@ void CommSend(Domain& domain, Int_t msgType,
       int sendCount = dx * dz ;
 
       if (rowMin) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  destAddr[i*dx+j] = (domain.*src)(i*dx*dy + j) ;
-               }
-            }
-            destAddr += sendCount ;
+         if (CommOwnsMsg(pmsg, team)) {
+            int toRank = myRank - domain.tpx() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm],
+                                      xferFields*sendCount, toRank) ;
+            CommAddFace(faces, destAddr, 0, dz, dx, dx*dy, 1, toRank, pmsg) ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank - domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
          ++pmsg ;
       }
       if (rowMax && doSend) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  destAddr[i*dx+j] = (domain.*src)(dx*(dy - 1) + i*dx*dy + j) ;
-               }
-            }
-            destAddr += sendCount ;
+         if (CommOwnsMsg(pmsg, team)) {
+            int toRank = myRank + domain.tpx() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm],
+                                      xferFields*sendCount, toRank) ;
+            CommAddFace(faces, destAddr, dx*(dy - 1), dz, dx, dx*dy, 1,
+                        toRank, pmsg) ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank + domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
          ++pmsg ;
       }
    }
@@ -485,362 +2050,463 @@ void CommSend(Domain& domain, Int_t msgType,
       int sendCount = dy * dz ;
 
       if (colMin) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  destAddr[i*dy + j] = (domain.*src)(i*dx*dy + j*dx) ;
-               }
-            }
-            destAddr += sendCount ;
+         if (CommOwnsMsg(pmsg, team)) {
+            int toRank = myRank - 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm],
+                                      xferFields*sendCount, toRank) ;
+            CommAddFace(faces, destAddr, 0, dz, dy, dx*dy, dx, toRank, pmsg) ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank - 1, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
          ++pmsg ;
       }
       if (colMax && doSend) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  destAddr[i*dy + j] = (domain.*src)(dx - 1 + i*dx*dy + j*dx) ;
-               }
-            }
-            destAddr += sendCount ;
+         if (CommOwnsMsg(pmsg, team)) {
+            int toRank = myRank + 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm],
+                                      xferFields*sendCount, toRank) ;
+            CommAddFace(faces, destAddr, dx - 1, dz, dy, dx*dy, dx,
+                        toRank, pmsg) ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank + 1, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
          ++pmsg ;
       }
    }
 
+   CommPackFaces(domain, xferFields, fieldData, &faces, packTeam > team) ;
+   for (Int_t f=0 ; f<faces.num ; ++f) {
+      const CommFace_t &face = faces.face[f] ;
+      CommPostSend(face.buf, xferFields*face.lines*face.len, baseType,
+                   face.toRank, msgType,
+                   domain.comm, pat, &domain.sendRequest[face.msg]) ;
+   }
+
    if (!planeOnly) {
       if (rowMin && colMin) {
-         int toRank = myRank - domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(i*dx*dy) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank - domain.tpx() - 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dz, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dz; ++i) {
+                  destAddr[i] = (domain.*src)(i*dx*dy) ;
+               }
+               destAddr += dz ;
             }
-            destAddr += dz ;
+            destAddr -= xferFields*dz ;
+            CommPostSend(destAddr, xferFields*dz, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMin && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() - domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-               destAddr[i] = (domain.*src)(i) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank - domain.tpx()*domain.tpy() - domain.tpx() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dx, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dx; ++i) {
+                  destAddr[i] = (domain.*src)(i) ;
+               }
+               destAddr += dx ;
             }
-            destAddr += dx ;
+            destAddr -= xferFields*dx ;
+            CommPostSend(destAddr, xferFields*dx, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (colMin && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(i*dx) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank - domain.tpx()*domain.tpy() - 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dy, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dy; ++i) {
+                  destAddr[i] = (domain.*src)(i*dx) ;
+               }
+               destAddr += dy ;
             }
-            destAddr += dy ;
+            destAddr -= xferFields*dy ;
+            CommPostSend(destAddr, xferFields*dy, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMax && colMax && doSend) {
-         int toRank = myRank + domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy - 1 + i*dx*dy) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank + domain.tpx() + 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dz, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dz; ++i) {
+                  destAddr[i] = (domain.*src)(dx*dy - 1 + i*dx*dy) ;
+               }
+               destAddr += dz ;
             }
-            destAddr += dz ;
+            destAddr -= xferFields*dz ;
+            CommPostSend(destAddr, xferFields*dz, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMax && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() + domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-              destAddr[i] = (domain.*src)(dx*(dy-1) + dx*dy*(dz-1) + i) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank + domain.tpx()*domain.tpy() + domain.tpx() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dx, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dx; ++i) {
+                 destAddr[i] = (domain.*src)(dx*(dy-1) + dx*dy*(dz-1) + i) ;
+               }
+               destAddr += dx ;
             }
-            destAddr += dx ;
+            destAddr -= xferFields*dx ;
+            CommPostSend(destAddr, xferFields*dx, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (colMax && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz-1) + dx - 1 + i*dx) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank + domain.tpx()*domain.tpy() + 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dy, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dy; ++i) {
+                  destAddr[i] = (domain.*src)(dx*dy*(dz-1) + dx - 1 + i*dx) ;
+               }
+               destAddr += dy ;
             }
-            destAddr += dy ;
+            destAddr -= xferFields*dy ;
+            CommPostSend(destAddr, xferFields*dy, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMax && colMin && doSend) {
-         int toRank = myRank + domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(dx*(dy-1) + i*dx*dy) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank + domain.tpx() - 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dz, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dz; ++i) {
+                  destAddr[i] = (domain.*src)(dx*(dy-1) + i*dx*dy) ;
+               }
+               destAddr += dz ;
             }
-            destAddr += dz ;
+            destAddr -= xferFields*dz ;
+            CommPostSend(destAddr, xferFields*dz, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMin && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() - domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz-1) + i) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank + domain.tpx()*domain.tpy() - domain.tpx() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dx, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dx; ++i) {
+                  destAddr[i] = (domain.*src)(dx*dy*(dz-1) + i) ;
+               }
+               destAddr += dx ;
             }
-            destAddr += dx ;
+            destAddr -= xferFields*dx ;
+            CommPostSend(destAddr, xferFields*dx, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (colMin && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz-1) + i*dx) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank + domain.tpx()*domain.tpy() - 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dy, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dy; ++i) {
+                  destAddr[i] = (domain.*src)(dx*dy*(dz-1) + i*dx) ;
+               }
+               destAddr += dy ;
             }
-            destAddr += dy ;
+            destAddr -= xferFields*dy ;
+            CommPostSend(destAddr, xferFields*dy, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMin && colMax) {
-         int toRank = myRank - domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(dx - 1 + i*dx*dy) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank - domain.tpx() + 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dz, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dz; ++i) {
+                  destAddr[i] = (domain.*src)(dx - 1 + i*dx*dy) ;
+               }
+               destAddr += dz ;
             }
-            destAddr += dz ;
+            destAddr -= xferFields*dz ;
+            CommPostSend(destAddr, xferFields*dz, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMax && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() + domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-               destAddr[i] = (domain.*src)(dx*(dy - 1) + i) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank - domain.tpx()*domain.tpy() + domain.tpx() ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dx, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dx; ++i) {
+                  destAddr[i] = (domain.*src)(dx*(dy - 1) + i) ;
+               }
+               destAddr += dx ;
             }
-            destAddr += dx ;
+            destAddr -= xferFields*dx ;
+            CommPostSend(destAddr, xferFields*dx, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (colMax && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(dx - 1 + i*dx) ;
+         if (CommOwnsMsg(pmsg+emsg, team)) {
+            int toRank = myRank - domain.tpx()*domain.tpy() + 1 ;
+            destAddr = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                           emsg * maxEdgeComm],
+                                      xferFields*dy, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               Domain_member src = fieldData[fi] ;
+               for (Index_t i=0; i<dy; ++i) {
+                  destAddr[i] = (domain.*src)(dx - 1 + i*dx) ;
+               }
+               destAddr += dy ;
             }
-            destAddr += dy ;
+            destAddr -= xferFields*dy ;
+            CommPostSend(destAddr, xferFields*dy, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg]) ;
          }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
          ++emsg ;
       }
 
       if (rowMin && colMin && planeMin) {
-         /* corner at domain logical coord (0, 0, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() - domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(0) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 0, 0) */
+            int toRank = myRank - domain.tpx()*domain.tpy() - domain.tpx() - 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(0) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMin && colMin && planeMax && doSend) {
-         /* corner at domain logical coord (0, 0, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() - domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*(dz - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 0, 1) */
+            int toRank = myRank + domain.tpx()*domain.tpy() - domain.tpx() - 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx*dy*(dz - 1) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMin && colMax && planeMin) {
-         /* corner at domain logical coord (1, 0, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() - domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx - 1 ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 0, 0) */
+            int toRank = myRank - domain.tpx()*domain.tpy() - domain.tpx() + 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx - 1 ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMin && colMax && planeMax && doSend) {
-         /* corner at domain logical coord (1, 0, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() - domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 0, 1) */
+            int toRank = myRank + domain.tpx()*domain.tpy() - domain.tpx() + 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMax && colMin && planeMin) {
-         /* corner at domain logical coord (0, 1, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() + domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*(dy - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 1, 0) */
+            int toRank = myRank - domain.tpx()*domain.tpy() + domain.tpx() - 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx*(dy - 1) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMax && colMin && planeMax && doSend) {
-         /* corner at domain logical coord (0, 1, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() + domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (0, 1, 1) */
+            int toRank = myRank + domain.tpx()*domain.tpy() + domain.tpx() - 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMax && colMax && planeMin) {
-         /* corner at domain logical coord (1, 1, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() + domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy - 1 ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 1, 0) */
+            int toRank = myRank - domain.tpx()*domain.tpy() + domain.tpx() + 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx*dy - 1 ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
       if (rowMax && colMax && planeMax && doSend) {
-         /* corner at domain logical coord (1, 1, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() + domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*dz - 1 ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+         if (CommOwnsMsg(pmsg+emsg+cmsg, team)) {
+            /* corner at domain logical coord (1, 1, 1) */
+            int toRank = myRank + domain.tpx()*domain.tpy() + domain.tpx() + 1 ;
+            Real_t *comBuf = CommSendBuffer(&domain.commDataSend[pmsg * maxPlaneComm +
+                                                                 emsg * maxEdgeComm +
+                                                                 cmsg * CACHE_COHERENCE_PAD_REAL],
+                                            xferFields, toRank) ;
+            Index_t idx = dx*dy*dz - 1 ;
+            for (Index_t fi=0; fi<xferFields; ++fi) {
+               comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+            }
+            CommPostSend(comBuf, xferFields, baseType, toRank, msgType,
+                         domain.comm, pat, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
          ++cmsg ;
       }
    }
 
-   MPI_Waitall(26, domain.sendRequest, status) ;
+   if (s_nbr.active) {
+      MPI_Ineighbor_alltoallv(domain.commDataSend, s_nbr.sendCount,
+                              s_nbr.sendDispl, baseType,
+                              domain.commDataRecv, s_nbr.recvCount,
+                              s_nbr.recvDispl, baseType,
+                              s_nbr.graph, &s_nbr.request) ;
+      s_nbr.active = false ;
+   }
+   if (s_rma.active) {
+      s_rma.pat->ready = true ;
+      s_rma.active = false ;
+   }
+   if (s_sweep.active) {
+      CommSendSweepStage(0) ;
+      s_sweep.active = false ;
+   }
+
+   if (wait) {
+      CommWaitSends(domain, team) ;
+   }
+}
+
+void CommSend(Domain& domain, Int_t msgType,
+              Index_t xferFields, Domain_member *fieldData,
+              Index_t dx, Index_t dy, Index_t dz, bool doSend, bool planeOnly)
+{
+   CommSendMsgs(domain, msgType, xferFields, fieldData,
+                dx, dy, dz, doSend, planeOnly, true) ;
+}
+
+/* CommSend without waiting for the sends, so the caller can compute
+ * while they are in flight (-overlap) */
+void CommSendStart(Domain& domain, Int_t msgType,
+                   Index_t xferFields, Domain_member *fieldData,
+                   Index_t dx, Index_t dy, Index_t dz,
+                   bool doSend, bool planeOnly)
+{
+   CommSendMsgs(domain, msgType, xferFields, fieldData,
+                dx, dy, dz, doSend, planeOnly, false) ;
+}
+
+/* Waits for the sends started by CommSendStart */
+void CommSendFinish(Domain& domain)
+{
+   if (domain.numRanks() == 1)
+      return ;
+
+   Int_t team = CommTeamSize(domain) ;
+   if (team > 1 || ParThreadId() == 0) {
+      CommWaitSends(domain, team) ;
+   }
 }
 
 /******************************************/
@@ -850,6 +2516,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (domain.numRanks() == 1)
       return ;
 
+   Int_t team = CommTeamSize(domain) ;
+   Int_t packTeam = CommPackTeamSize(domain) ;
+
+   CommWaitOther(team) ;
+
    /* summation order should be from smallest value to largest */
    /* or we could try out kahan summation! */
 
@@ -870,23 +2541,38 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (domain.rowLoc() == 0) {
       rowMin = 0 ;
    }
-   if (domain.rowLoc() == (domain.tp()-1)) {
+   if (domain.rowLoc() == (domain.tpy()-1)) {
       rowMax = 0 ;
    }
    if (domain.colLoc() == 0) {
       colMin = 0 ;
    }
-   if (domain.colLoc() == (domain.tp()-1)) {
+   if (domain.colLoc() == (domain.tpx()-1)) {
       colMax = 0 ;
    }
    if (domain.planeLoc() == 0) {
       planeMin = 0 ;
    }
-   if (domain.planeLoc() == (domain.tp()-1)) {
+   if (domain.planeLoc() == (domain.tpz()-1)) {
       planeMax = 0 ;
    }
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   MPI_Comm_rank(domain.comm, &myRank) ;
+
+   // node planes this thread unpacks into (all of them when funneled)
+   Index_t zBegin = 0 ;
+   Index_t zEnd = dz ;
+   if (packTeam > 1) {
+      for (Index_t i=0; i<26; ++i) {
+         if (CommOwnsMsg(i, team)) {
+            MPI_Wait(&domain.recvRequest[i], &status) ;
+         }
+      }
+      ParBarrier() ;
+      ParRange(0, dz, &zBegin, &zEnd) ;
+   }
+   const bool ownZMin = (zBegin == 0 && zEnd > 0) ;
+   const bool ownZMax = (zBegin < dz && zEnd == dz) ;
 
    if (planeMin | planeMax) {
       /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
@@ -894,27 +2580,29 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
 
       if (planeMin) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(i) += srcAddr[i] ;
+         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (ownZMin) {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(0), srcAddr,
+                               0, dy, dx, dx, 1, true) ;
+               srcAddr += opCount ;
             }
-            srcAddr += opCount ;
          }
          ++pmsg ;
       }
       if (planeMax) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(dx*dy*(dz - 1) + i) += srcAddr[i] ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (ownZMax) {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(dx*dy*(dz - 1)), srcAddr,
+                               0, dy, dx, dx, 1, true) ;
+               srcAddr += opCount ;
             }
-            srcAddr += opCount ;
          }
          ++pmsg ;
       }
@@ -927,14 +2615,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
       if (rowMin) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(i*dx*dy + j) += srcAddr[i*dx + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(0), srcAddr,
+                            zBegin, zEnd, dx, dx*dy, 1, true) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -942,14 +2627,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
       if (rowMax) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(dx*(dy - 1) + i*dx*dy + j) += srcAddr[i*dx + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(dx*(dy - 1)), srcAddr,
+                            zBegin, zEnd, dx, dx*dy, 1, true) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -962,14 +2644,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
       if (colMin) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(i*dx*dy + j*dx) += srcAddr[i*dy + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(0), srcAddr,
+                            zBegin, zEnd, dy, dx*dy, dx, true) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -977,14 +2656,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
       if (colMax) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(dx - 1 + i*dx*dy + j*dx) += srcAddr[i*dy + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(dx - 1), srcAddr,
+                            zBegin, zEnd, dy, dx*dy, dx, true) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -994,10 +2670,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMin & colMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(i*dx*dy) += srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1008,13 +2685,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMin & planeMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(i) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(i) += srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1022,13 +2702,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (colMin & planeMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(i*dx) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(i*dx) += srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1036,10 +2719,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMax & colMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(dx*dy - 1 + i*dx*dy) += srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1050,13 +2734,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMax & planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy-1) + dx*dy*(dz-1) + i) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(dx*(dy-1) + dx*dy*(dz-1) + i) += srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1064,13 +2751,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (colMax & planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + dx - 1 + i*dx) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(dx*dy*(dz-1) + dx - 1 + i*dx) += srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1078,10 +2768,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMax & colMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(dx*(dy-1) + i*dx*dy) += srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1092,13 +2783,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMin & planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(dx*dy*(dz-1) + i) += srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1106,13 +2800,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (colMin & planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i*dx) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(dx*dy*(dz-1) + i*dx) += srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1120,10 +2817,11 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMin & colMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(dx - 1 + i*dx*dy) += srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1134,13 +2832,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (rowMax & planeMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy - 1) + i) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(dx*(dy - 1) + i) += srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1148,13 +2849,16 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
    if (colMax & planeMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx - 1 + i*dx) += srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(dx - 1 + i*dx) += srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1164,9 +2868,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
       Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(0) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(0) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1176,9 +2883,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*(dz - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1188,9 +2898,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1200,9 +2913,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1212,9 +2928,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1224,9 +2943,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1236,9 +2958,12 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1248,12 +2973,20 @@ void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*dz - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) += comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
+
+   // the next exchange may reuse the receive buffer
+   if (packTeam > 1) {
+      ParBarrier() ;
+   }
 }
 
 /******************************************/
@@ -1263,6 +2996,11 @@ void CommSyncPosVel(Domain& domain) {
    if (domain.numRanks() == 1)
       return ;
 
+   Int_t team = CommTeamSize(domain) ;
+   Int_t packTeam = CommPackTeamSize(domain) ;
+
+   CommWaitOther(team) ;
+
    int myRank ;
    bool doRecv = false ;
    Index_t xferFields = 6 ; /* x, y, z, xd, yd, zd */
@@ -1284,19 +3022,19 @@ void CommSyncPosVel(Domain& domain) {
    if (domain.rowLoc() == 0) {
       rowMin = false ;
    }
-   if (domain.rowLoc() == (domain.tp()-1)) {
+   if (domain.rowLoc() == (domain.tpy()-1)) {
       rowMax = false ;
    }
    if (domain.colLoc() == 0) {
       colMin = false ;
    }
-   if (domain.colLoc() == (domain.tp()-1)) {
+   if (domain.colLoc() == (domain.tpx()-1)) {
       colMax = false ;
    }
    if (domain.planeLoc() == 0) {
       planeMin = false ;
    }
-   if (domain.planeLoc() == (domain.tp()-1)) {
+   if (domain.planeLoc() == (domain.tpz()-1)) {
       planeMax = false ;
    }
 
@@ -1307,7 +3045,22 @@ void CommSyncPosVel(Domain& domain) {
    fieldData[4] = &Domain::yd ;
    fieldData[5] = &Domain::zd ;
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   MPI_Comm_rank(domain.comm, &myRank) ;
+
+   // node planes this thread unpacks into (all of them when funneled)
+   Index_t zBegin = 0 ;
+   Index_t zEnd = dz ;
+   if (packTeam > 1) {
+      for (Index_t i=0; i<26; ++i) {
+         if (CommOwnsMsg(i, team)) {
+            MPI_Wait(&domain.recvRequest[i], &status) ;
+         }
+      }
+      ParBarrier() ;
+      ParRange(0, dz, &zBegin, &zEnd) ;
+   }
+   const bool ownZMin = (zBegin == 0 && zEnd > 0) ;
+   const bool ownZMax = (zBegin < dz && zEnd == dz) ;
 
    if (planeMin | planeMax) {
       /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
@@ -1316,26 +3069,28 @@ void CommSyncPosVel(Domain& domain) {
       if (planeMin && doRecv) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(i) = srcAddr[i] ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (ownZMin) {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(0), srcAddr,
+                               0, dy, dx, dx, 1, false) ;
+               srcAddr += opCount ;
             }
-            srcAddr += opCount ;
          }
          ++pmsg ;
       }
       if (planeMax) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(dx*dy*(dz - 1) + i) = srcAddr[i] ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (ownZMax) {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(dx*dy*(dz - 1)), srcAddr,
+                               0, dy, dx, dx, 1, false) ;
+               srcAddr += opCount ;
             }
-            srcAddr += opCount ;
          }
          ++pmsg ;
       }
@@ -1348,14 +3103,11 @@ void CommSyncPosVel(Domain& domain) {
       if (rowMin && doRecv) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(i*dx*dy + j) = srcAddr[i*dx + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(0), srcAddr,
+                            zBegin, zEnd, dx, dx*dy, 1, false) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -1363,14 +3115,11 @@ void CommSyncPosVel(Domain& domain) {
       if (rowMax) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(dx*(dy - 1) + i*dx*dy + j) = srcAddr[i*dx + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(dx*(dy - 1)), srcAddr,
+                            zBegin, zEnd, dx, dx*dy, 1, false) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -1384,14 +3133,11 @@ void CommSyncPosVel(Domain& domain) {
       if (colMin && doRecv) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(i*dx*dy + j*dx) = srcAddr[i*dy + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(0), srcAddr,
+                            zBegin, zEnd, dy, dx*dy, dx, false) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -1399,14 +3145,11 @@ void CommSyncPosVel(Domain& domain) {
       if (colMax) {
          /* contiguous memory */
          srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+         if (packTeam == 1)
+            MPI_Wait(&domain.recvRequest[pmsg], &status) ;
          for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(dx - 1 + i*dx*dy + j*dx) = srcAddr[i*dy + j] ;
-               }
-            }
+            CommUnpackLines(&(domain.*fieldData[fi])(dx - 1), srcAddr,
+                            zBegin, zEnd, dy, dx*dy, dx, false) ;
             srcAddr += opCount ;
          }
          ++pmsg ;
@@ -1416,10 +3159,11 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMin && colMin && doRecv) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(i*dx*dy) = srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1430,13 +3174,16 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMin && planeMin && doRecv) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(i) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(i) = srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1444,13 +3191,16 @@ void CommSyncPosVel(Domain& domain) {
    if (colMin && planeMin && doRecv) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(i*dx) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(i*dx) = srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1458,10 +3208,11 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMax && colMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(dx*dy - 1 + i*dx*dy) = srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1472,13 +3223,16 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMax && planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy-1) + dx*dy*(dz-1) + i) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(dx*(dy-1) + dx*dy*(dz-1) + i) = srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1486,13 +3240,16 @@ void CommSyncPosVel(Domain& domain) {
    if (colMax && planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + dx - 1 + i*dx) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(dx*dy*(dz-1) + dx - 1 + i*dx) = srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1500,10 +3257,11 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMax && colMin) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(dx*(dy-1) + i*dx*dy) = srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1514,13 +3272,16 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMin && planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(dx*dy*(dz-1) + i) = srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1528,13 +3289,16 @@ void CommSyncPosVel(Domain& domain) {
    if (colMin && planeMax) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i*dx) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(dx*dy*(dz-1) + i*dx) = srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1542,10 +3306,11 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMin && colMax && doRecv) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
          Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
+         for (Index_t i=zBegin; i<zEnd; ++i) {
             (domain.*dest)(dx - 1 + i*dx*dy) = srcAddr[i] ;
          }
          srcAddr += dz ;
@@ -1556,13 +3321,16 @@ void CommSyncPosVel(Domain& domain) {
    if (rowMax && planeMin && doRecv) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy - 1) + i) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dx; ++i) {
+               (domain.*dest)(dx*(dy - 1) + i) = srcAddr[i] ;
+            }
+            srcAddr += dx ;
          }
-         srcAddr += dx ;
       }
       ++emsg ;
    }
@@ -1570,13 +3338,16 @@ void CommSyncPosVel(Domain& domain) {
    if (colMax && planeMin && doRecv) {
       srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
                                        emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx - 1 + i*dx) = srcAddr[i] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0 ; fi<xferFields; ++fi) {
+            Domain_member dest = fieldData[fi] ;
+            for (Index_t i=0; i<dy; ++i) {
+               (domain.*dest)(dx - 1 + i*dx) = srcAddr[i] ;
+            }
+            srcAddr += dy ;
          }
-         srcAddr += dy ;
       }
       ++emsg ;
    }
@@ -1587,9 +3358,12 @@ void CommSyncPosVel(Domain& domain) {
       Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(0) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(0) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1599,9 +3373,12 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*(dz - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1611,9 +3388,12 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1623,9 +3403,12 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1635,9 +3418,12 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1647,9 +3433,12 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1659,9 +3448,12 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMin) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
@@ -1671,12 +3463,20 @@ void CommSyncPosVel(Domain& domain) {
                                              emsg * maxEdgeComm +
                                       cmsg * CACHE_COHERENCE_PAD_REAL] ;
       Index_t idx = dx*dy*dz - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+      if (packTeam == 1)
+         MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
+      if (ownZMax) {
+         for (Index_t fi=0; fi<xferFields; ++fi) {
+            (domain.*fieldData[fi])(idx) = comBuf[fi] ;
+         }
       }
       ++cmsg ;
    }
+
+   // the next exchange may reuse the receive buffer
+   if (packTeam > 1) {
+      ParBarrier() ;
+   }
 }
 
 /******************************************/
@@ -1686,6 +3486,11 @@ void CommMonoQ(Domain& domain)
    if (domain.numRanks() == 1)
       return ;
 
+   Int_t team = CommTeamSize(domain) ;
+   Int_t packTeam = CommPackTeamSize(domain) ;
+
+   CommWaitOther(team) ;
+
    int myRank ;
    Index_t xferFields = 3 ; /* delv_xi, delv_eta, delv_zeta */
    Domain_member fieldData[3] ;
@@ -1703,19 +3508,19 @@ void CommMonoQ(Domain& domain)
    if (domain.rowLoc() == 0) {
       rowMin = false ;
    }
-   if (domain.rowLoc() == (domain.tp()-1)) {
+   if (domain.rowLoc() == (domain.tpy()-1)) {
       rowMax = false ;
    }
    if (domain.colLoc() == 0) {
       colMin = false ;
    }
-   if (domain.colLoc() == (domain.tp()-1)) {
+   if (domain.colLoc() == (domain.tpx()-1)) {
       colMax = false ;
    }
    if (domain.planeLoc() == 0) {
       planeMin = false ;
    }
-   if (domain.planeLoc() == (domain.tp()-1)) {
+   if (domain.planeLoc() == (domain.tpz()-1)) {
       planeMax = false ;
    }
 
@@ -1731,37 +3536,64 @@ void CommMonoQ(Domain& domain)
    fieldOffset[2] = domain.numElem() ;
 
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   MPI_Comm_rank(domain.comm, &myRank) ;
+
+   // with -tpack thread 0 waits for the faces and the team unpacks them
+   if (packTeam > team) {
+      for (Index_t i=0; i<26; ++i) {
+         if (CommOwnsMsg(i, team)) {
+            MPI_Wait(&domain.recvRequest[i], &status) ;
+         }
+      }
+      ParBarrier() ;
+   }
 
    if (planeMin | planeMax) {
       /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
       Index_t opCount = dx * dy ;
+      Index_t lineBegin = 0 ;
+      Index_t lineEnd = dy ;
+      if (packTeam > team) {
+         ParRange(0, dy, &lineBegin, &lineEnd) ;
+      }
 
       if (planeMin) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
+         if (packTeam > team || CommOwnsMsg(pmsg, team)) {
+            srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+            if (packTeam == team)
+               MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(fieldOffset[fi]), srcAddr,
+                               lineBegin, lineEnd, dx, dx, 1, false) ;
+               srcAddr += opCount ;
+               fieldOffset[fi] += opCount ;
+            }
+         }
+         else {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               fieldOffset[fi] += opCount ;
             }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
          }
          ++pmsg ;
       }
       if (planeMax) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
+         if (packTeam > team || CommOwnsMsg(pmsg, team)) {
+            srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+            if (packTeam == team)
+               MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(fieldOffset[fi]), srcAddr,
+                               lineBegin, lineEnd, dx, dx, 1, false) ;
+               srcAddr += opCount ;
+               fieldOffset[fi] += opCount ;
+            }
+         }
+         else {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               fieldOffset[fi] += opCount ;
             }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
          }
          ++pmsg ;
       }
@@ -1770,32 +3602,49 @@ void CommMonoQ(Domain& domain)
    if (rowMin | rowMax) {
       /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
       Index_t opCount = dx * dz ;
+      Index_t lineBegin = 0 ;
+      Index_t lineEnd = dz ;
+      if (packTeam > team) {
+         ParRange(0, dz, &lineBegin, &lineEnd) ;
+      }
 
       if (rowMin) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
+         if (packTeam > team || CommOwnsMsg(pmsg, team)) {
+            srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+            if (packTeam == team)
+               MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(fieldOffset[fi]), srcAddr,
+                               lineBegin, lineEnd, dx, dx, 1, false) ;
+               srcAddr += opCount ;
+               fieldOffset[fi] += opCount ;
+            }
+         }
+         else {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               fieldOffset[fi] += opCount ;
             }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
          }
          ++pmsg ;
       }
       if (rowMax) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
+         if (packTeam > team || CommOwnsMsg(pmsg, team)) {
+            srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+            if (packTeam == team)
+               MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(fieldOffset[fi]), srcAddr,
+                               lineBegin, lineEnd, dx, dx, 1, false) ;
+               srcAddr += opCount ;
+               fieldOffset[fi] += opCount ;
+            }
+         }
+         else {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               fieldOffset[fi] += opCount ;
             }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
          }
          ++pmsg ;
       }
@@ -1803,35 +3652,313 @@ void CommMonoQ(Domain& domain)
    if (colMin | colMax) {
       /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
       Index_t opCount = dy * dz ;
+      Index_t lineBegin = 0 ;
+      Index_t lineEnd = dz ;
+      if (packTeam > team) {
+         ParRange(0, dz, &lineBegin, &lineEnd) ;
+      }
 
       if (colMin) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
+         if (packTeam > team || CommOwnsMsg(pmsg, team)) {
+            srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+            if (packTeam == team)
+               MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(fieldOffset[fi]), srcAddr,
+                               lineBegin, lineEnd, dy, dy, 1, false) ;
+               srcAddr += opCount ;
+               fieldOffset[fi] += opCount ;
+            }
+         }
+         else {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               fieldOffset[fi] += opCount ;
             }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
          }
          ++pmsg ;
       }
       if (colMax) {
          /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
+         if (packTeam > team || CommOwnsMsg(pmsg, team)) {
+            srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
+            if (packTeam == team)
+               MPI_Wait(&domain.recvRequest[pmsg], &status) ;
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               CommUnpackLines(&(domain.*fieldData[fi])(fieldOffset[fi]), srcAddr,
+                               lineBegin, lineEnd, dy, dy, 1, false) ;
+               srcAddr += opCount ;
+            }
+         }
+         else {
+            for (Index_t fi=0 ; fi<xferFields; ++fi) {
+               fieldOffset[fi] += opCount ;
             }
-            srcAddr += opCount ;
          }
          ++pmsg ;
       }
    }
+
+   // the next exchange may reuse the receive buffer
+   if (packTeam > 1) {
+      ParBarrier() ;
+   }
+}
+
+/******************************************/
+
+/* One cycle's worth of the recurring exchanges: forces, MonoQ
+ * gradients, positions and velocities.  The gradients are allocated
+ * around their exchange as in CalcQForElems. */
+static void CommBenchmarkCycle(Domain& domain)
+{
+   Domain_member force[3] = { &Domain::fx, &Domain::fy, &Domain::fz } ;
+   Domain_member grad[3] = { &Domain::delv_xi, &Domain::delv_eta,
+                             &Domain::delv_zeta } ;
+   Domain_member posVel[6] = { &Domain::x, &Domain::y, &Domain::z,
+                               &Domain::xd, &Domain::yd, &Domain::zd } ;
+   Index_t numElem = domain.numElem() ;
+   Index_t allElem = numElem +                                /* local */
+      2*domain.sizeX()*domain.sizeY() +                       /* plane ghosts */
+      2*domain.sizeX()*domain.sizeZ() +                       /* row ghosts */
+      2*domain.sizeY()*domain.sizeZ() ;                       /* col ghosts */
+
+   CommRecv(domain, MSG_COMM_SBN, 3,
+            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+            true, false) ;
+   CommSend(domain, MSG_COMM_SBN, 3, force,
+            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+            true, false) ;
+   CommSBN(domain, 3, force) ;
+
+   domain.AllocateGradients(numElem, allElem) ;
+   for (Index_t i=0 ; i<numElem ; ++i) {
+      domain.delv_xi(i) = Real_t(0.0) ;
+      domain.delv_eta(i) = Real_t(0.0) ;
+      domain.delv_zeta(i) = Real_t(0.0) ;
+   }
+   CommRecv(domain, MSG_MONOQ, 3,
+            domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+            true, true) ;
+   CommSend(domain, MSG_MONOQ, 3, grad,
+            domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+            true, true) ;
+   CommMonoQ(domain) ;
+   domain.DeallocateGradients() ;
+
+   CommRecv(domain, MSG_SYNC_POS_VEL, 6,
+            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+            false, false) ;
+   CommSend(domain, MSG_SYNC_POS_VEL, 6, posVel,
+            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+            false, false) ;
+   CommSyncPosVel(domain) ;
+}
+
+/* Times the recurring exchanges of iters cycles with packed sends and
+ * nonblocking requests, packed sends and persistent requests, derived
+ * datatype sends and, with -neighbor, neighborhood collectives, with
+ * -shm, the shared-memory window, with -rma, one-sided puts and, with
+ * -sweep, the dimension sweep (-commbench).  Called before the time loop;
+ * forces are zeroed afterwards and positions and velocities are only
+ * overwritten with the neighbors' equal copies, so the run that
+ * follows is unchanged. */
+void CommBenchmark(Domain& domain, Int_t iters, Int_t myRank)
+{
+   static const char *modeName[7] = {
+      "packed, nonblocking ", "packed, persistent  ", "derived datatypes   ",
+      "neighbor collective ", "shared-memory window",
+      (s_rma.sync == COMM_RMA_PSCW) ? "one-sided, PSCW     " :
+                                      "one-sided, fence    ",
+      "dimension sweep     "
+   } ;
+   const bool haveMode[7] = { true, true, true,
+                              s_nbr.graph != MPI_COMM_NULL,
+                              s_shm.win != MPI_WIN_NULL,
+                              s_rma.win != MPI_WIN_NULL,
+                              s_sweep.stageBuf != NULL } ;
+   Int_t persistent = domain.commPersistent() ;
+   Int_t datatypes = domain.commDatatypes() ;
+   Int_t neighbor = domain.commNeighbor() ;
+   Int_t shared = domain.commShared() ;
+   Int_t rma = domain.commRma() ;
+   Int_t sweep = domain.commSweep() ;
+   double local[7] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 } ;
+   double global[7] ;
+
+   for (Int_t mode=0 ; mode<7 ; ++mode) {
+      if (!haveMode[mode]) {
+         continue ;
+      }
+      domain.commPersistent() = (mode == 1) ;
+      domain.commDatatypes() = (mode == 2) ;
+      domain.commNeighbor() = (mode == 3) ;
+      domain.commShared() = (mode == 4) ;
+      domain.commRma() = (mode == 5) ? s_rma.sync : COMM_RMA_NONE ;
+      domain.commSweep() = (mode == 6) ;
+      CommBenchmarkCycle(domain) ;   // warm-up, sets up requests and types
+      MPI_Barrier(domain.comm) ;
+      double start = MPI_Wtime() ;
+      for (Int_t it=0 ; it<iters ; ++it) {
+         CommBenchmarkCycle(domain) ;
+      }
+      local[mode] = (MPI_Wtime() - start)/double(iters) ;
+   }
+
+   domain.commPersistent() = persistent ;
+   domain.commDatatypes() = datatypes ;
+   domain.commNeighbor() = neighbor ;
+   domain.commShared() = shared ;
+   domain.commRma() = rma ;
+   domain.commSweep() = sweep ;
+   for (Index_t i=0 ; i<domain.numNode() ; ++i) {
+      domain.fx(i) = Real_t(0.0) ;
+      domain.fy(i) = Real_t(0.0) ;
+      domain.fz(i) = Real_t(0.0) ;
+   }
+
+   MPI_Reduce(local, global, 7, MPI_DOUBLE, MPI_MAX, 0, domain.comm) ;
+   if (myRank == 0) {
+      printf("Halo exchange benchmark (%d cycles, slowest rank)\n", int(iters)) ;
+      for (Int_t mode=0 ; mode<7 ; ++mode) {
+         if (!haveMode[mode]) {
+            continue ;
+         }
+         printf("   %s = %10.2f us/cycle (%+.1f%%)\n", modeName[mode],
+                1.0e6*global[mode],
+                (global[0] > 0.0) ? 100.0*(global[mode] - global[0])/global[0] : 0.0) ;
+      }
+      printf("\n") ;
+   }
+}
+
+/* A face orientation of -packbench, packed and unpacked by one thread
+ * or by the team */
+struct CommPackBench_t {
+   Domain *domain ;
+   Real_t *buf ;
+   Index_t iters ;
+   Index_t lines ;
+   Index_t len ;
+   Index_t stride ;
+   Index_t step ;
+   bool team ;
+   double packTime ;
+   double unpackTime ;
+} ;
+
+static void CommPackBenchRun(void *arg)
+{
+   CommPackBench_t &bench = *static_cast<CommPackBench_t *>(arg) ;
+   Domain &domain = *bench.domain ;
+   Domain_member posVel[6] = { &Domain::x, &Domain::y, &Domain::z,
+                               &Domain::xd, &Domain::yd, &Domain::zd } ;
+   Index_t faceSize = bench.lines*bench.len ;
+   Index_t i0 = 0 ;
+   Index_t i1 = bench.lines ;
+   if (bench.team) {
+      ParRange(0, bench.lines, &i0, &i1) ;
+   }
+
+   // warm-up: the face in cache as far as it fits
+   for (Index_t fi=0 ; fi<6 ; ++fi) {
+      CommPackLines(bench.buf + fi*faceSize, &(domain.*posVel[fi])(0),
+                    i0, i1, bench.len, bench.stride, bench.step) ;
+   }
+   if (bench.team) {
+      ParBarrier() ;
+   }
+
+   double start = MPI_Wtime() ;
+   for (Index_t it=0 ; it<bench.iters ; ++it) {
+      for (Index_t fi=0 ; fi<6 ; ++fi) {
+         CommPackLines(bench.buf + fi*faceSize, &(domain.*posVel[fi])(0),
+                       i0, i1, bench.len, bench.stride, bench.step) ;
+      }
+      if (bench.team) {
+         ParBarrier() ;
+      }
+   }
+   if (ParThreadId() == 0) {
+      bench.packTime = (MPI_Wtime() - start)/double(bench.iters) ;
+   }
+
+   // the face is written back with the values just packed from it
+   start = MPI_Wtime() ;
+   for (Index_t it=0 ; it<bench.iters ; ++it) {
+      for (Index_t fi=0 ; fi<6 ; ++fi) {
+         CommUnpackLines(&(domain.*posVel[fi])(0), bench.buf + fi*faceSize,
+                         i0, i1, bench.len, bench.stride, bench.step, false) ;
+      }
+      if (bench.team) {
+         ParBarrier() ;
+      }
+   }
+   if (ParThreadId() == 0) {
+      bench.unpackTime = (MPI_Wtime() - start)/double(bench.iters) ;
+   }
+}
+
+/* Times the pack and unpack kernels on the six position and velocity
+ * fields for each face orientation, on one thread and on the ParRun
+ * team, and the strided faces once more without the prefetches
+ * (-packbench).  Unpacking writes back what was packed, so the run
+ * that follows is unchanged. */
+void CommPackBenchmark(Domain& domain, Int_t iters, Int_t myRank)
+{
+   static const char *faceName[4] = {
+      "plane (a), contiguous", "row (b), pencils     ",
+      "column (c), strided  ", "column (c), no hint  "
+   } ;
+   Index_t dx = domain.sizeX() + 1 ;
+   Index_t dy = domain.sizeY() + 1 ;
+   Index_t dz = domain.sizeZ() + 1 ;
+   //                          lines len stride   step
+   const Index_t shape[4][4] = { { dy, dx, dx,    1  },
+                                 { dz, dx, dx*dy, 1  },
+                                 { dz, dy, dx*dy, dx },
+                                 { dz, dy, dx*dy, dx } } ;
+   double local[16] ;
+   double global[16] ;
+   CommPackBench_t bench ;
+
+   bench.domain = &domain ;
+   bench.buf = Allocate<Real_t>(6*domain.maxPlaneSize()) ;
+   bench.iters = iters ;
+   for (Int_t f=0 ; f<4 ; ++f) {
+      bench.lines = shape[f][0] ;
+      bench.len = shape[f][1] ;
+      bench.stride = shape[f][2] ;
+      bench.step = shape[f][3] ;
+      s_commPrefetch = (f != 3) ;
+      for (Int_t t=0 ; t<2 ; ++t) {
+         bench.team = (t == 1) ;
+         if (bench.team) {
+            ParRun(CommPackBenchRun, &bench) ;
+         }
+         else {
+            CommPackBenchRun(&bench) ;
+         }
+         local[4*f + t] = bench.packTime ;
+         local[4*f + 2 + t] = bench.unpackTime ;
+      }
+   }
+   s_commPrefetch = true ;
+   Release(&bench.buf) ;
+
+   MPI_Reduce(local, global, 16, MPI_DOUBLE, MPI_MAX, 0, domain.comm) ;
+   if (myRank == 0) {
+      printf("Face pack/unpack benchmark (6 fields, %d iterations, slowest rank)\n",
+             int(iters)) ;
+      printf("   %-21s   %11s %11s %11s %11s\n", "us per face",
+             "pack", "pack team", "unpack", "unpack team") ;
+      for (Int_t f=0 ; f<4 ; ++f) {
+         printf("   %s = %11.2f %11.2f %11.2f %11.2f\n", faceName[f],
+                1.0e6*global[4*f], 1.0e6*global[4*f + 1],
+                1.0e6*global[4*f + 2], 1.0e6*global[4*f + 3]) ;
+      }
+      printf("   (team of %d threads)\n\n", int(ParNumThreads())) ;
+   }
 }
 
 #endif
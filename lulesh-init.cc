@@ -15,7 +15,8 @@
 /////////////////////////////////////////////////////////////////////
 Domain::Domain(Int_t numRanks, Index_t colLoc,
                Index_t rowLoc, Index_t planeLoc,
-               Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost)
+               Index_t nx, Int_t tpx, Int_t tpy, Int_t tpz,
+               Int_t nr, Int_t balance, Int_t cost)
    :
    m_e_cut(Real_t(1.0e-7)),
    m_p_cut(Real_t(1.0e-7)),
@@ -48,7 +49,9 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
 #if USE_MPI
    , 
    commDataSend(0),
-   commDataRecv(0)
+   commDataRecv(0),
+   dtRequest(MPI_REQUEST_NULL),
+   comm(MPI_COMM_WORLD)
 #endif
 {
 
@@ -56,9 +59,31 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    Index_t edgeNodes = edgeElems+1 ;
    this->cost() = cost;
 
-   m_tp       = tp ;
+   m_tpx      = tpx ;
+   m_tpy      = tpy ;
+   m_tpz      = tpz ;
    m_numRanks = numRanks ;
 
+   m_halfStepCoords = 0 ;
+   m_taskGraph = 0 ;
+   m_deterministic = 0 ;
+   m_commHybrid = 0 ;
+   m_eosPartition = 0 ;
+   m_regionBatch = 0 ;
+   m_commPersistent = 0 ;
+   m_commDatatypes = 0 ;
+   m_commNeighbor = 0 ;
+   m_haloOverlap = 0 ;
+   m_commShared = 0 ;
+   m_commRma = COMM_RMA_NONE ;
+   m_commTeamPack = 0 ;
+   m_commSweep = 0 ;
+
+   m_smallReg = SmallRegion_t() ;
+   m_smallReg.eosCutoff = EOS_MIN_TASK_ELEMS ;
+   m_eosPart = EOSPartition_t() ;
+   m_taskGraphState = TaskGraph_t() ;
+
    ///////////////////////////////
    //   Initialize Sedov Mesh
    ///////////////////////////////
@@ -105,21 +130,13 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
       zd(i) = Real_t(0.0) ;
    }
 
-   for (Index_t i=0; i<numNode(); ++i) {
-      xdd(i) = Real_t(0.0) ;
-      ydd(i) = Real_t(0.0) ;
-      zdd(i) = Real_t(0.0) ;
-   }
-
    for (Index_t i=0; i<numNode(); ++i) {
       nodalMass(i) = Real_t(0.0) ;
    }
 
    BuildMesh(nx, edgeNodes, edgeElems);
 
-#if _OPENMP
    SetupThreadSupportStructures();
-#endif
 
    // Setup region index sets. For now, these are constant sized
    // throughout the run, but could be changed every cycle to 
@@ -179,9 +196,10 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
 
    // deposit initial energy
    // An energy of 3.948746e+7 is correct for a problem with
-   // 45 zones along a side - we need to scale it
+   // 45 zones along a side - we need to scale it (by the longest side
+   // of the mesh, which sets the element size)
    const Real_t ebase = Real_t(3.948746e+7);
-   Real_t scale = (nx*m_tp)/Real_t(45.0);
+   Real_t scale = (nx*MAX(m_tpx, MAX(m_tpy, m_tpz)))/Real_t(45.0);
    Real_t einit = ebase*scale*scale*scale;
    if (m_rowLoc + m_colLoc + m_planeLoc == 0) {
       // Dump into the first zone (which we know is in the corner)
@@ -217,7 +235,9 @@ Domain::~Domain()
 void
 Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
 {
-  Index_t meshEdgeElems = m_tp*nx ;
+  // the longest side of the mesh spans 1.125; the elements stay cubes
+  // when the process grid is not
+  Index_t meshEdgeElems = MAX(m_tpx, MAX(m_tpy, m_tpz))*nx ;
 
   // initialize nodal coordinates 
   Index_t nidx = 0 ;
@@ -271,13 +291,19 @@ Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
 void
 Domain::SetupThreadSupportStructures()
 {
-#if _OPENMP
-   Index_t numthreads = omp_get_max_threads();
-#else
-   Index_t numthreads = 1;
-#endif
+   Index_t numthreads = ParNumThreads();
 
   if (numthreads > 1) {
+    SetupNodeElemCornerList() ;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::SetupNodeElemCornerList()
+{
+  if (m_nodeElemStart == 0) {
     // set up node-centered indexing of elements 
     Index_t *nodeElemCount = new Index_t[numNode()] ;
 
@@ -348,11 +374,11 @@ Domain::SetupCommBuffers(Int_t edgeNodes)
 
   // assume communication to 6 neighbors by default 
   m_rowMin = (m_rowLoc == 0)        ? 0 : 1;
-  m_rowMax = (m_rowLoc == m_tp-1)     ? 0 : 1;
+  m_rowMax = (m_rowLoc == m_tpy-1)    ? 0 : 1;
   m_colMin = (m_colLoc == 0)        ? 0 : 1;
-  m_colMax = (m_colLoc == m_tp-1)     ? 0 : 1;
+  m_colMax = (m_colLoc == m_tpx-1)    ? 0 : 1;
   m_planeMin = (m_planeLoc == 0)    ? 0 : 1;
-  m_planeMax = (m_planeLoc == m_tp-1) ? 0 : 1;
+  m_planeMax = (m_planeLoc == m_tpz-1) ? 0 : 1;
 
 #if USE_MPI   
   // account for face communication 
@@ -379,20 +405,13 @@ Domain::SetupCommBuffers(Int_t edgeNodes)
 		 (m_rowMax & m_colMax & m_planeMin) +
 		 (m_rowMax & m_colMax & m_planeMax)) * CACHE_COHERENCE_PAD_REAL ;
 
+  this->commBufSize = comBufSize ;
   this->commDataSend = new Real_t[comBufSize] ;
   this->commDataRecv = new Real_t[comBufSize] ;
   // prevent floating point exceptions 
   memset(this->commDataSend, 0, comBufSize*sizeof(Real_t)) ;
   memset(this->commDataRecv, 0, comBufSize*sizeof(Real_t)) ;
 #endif   
-
-  // Boundary nodesets
-  if (m_colLoc == 0)
-    m_symmX.resize(edgeNodes*edgeNodes);
-  if (m_rowLoc == 0)
-    m_symmY.resize(edgeNodes*edgeNodes);
-  if (m_planeLoc == 0)
-    m_symmZ.resize(edgeNodes*edgeNodes);
 }
 
 
@@ -401,8 +420,9 @@ void
 Domain::CreateRegionIndexSets(Int_t nr, Int_t balance)
 {
 #if USE_MPI   
-   int myRank;
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   // the rank that owns this place of the process grid, also when
+   // -neighbor has renumbered the ranks
+   Index_t myRank = (m_planeLoc*m_tpy + m_rowLoc)*m_tpx + m_colLoc ;
    srand(myRank);
 #else
    srand(0);
@@ -513,21 +533,21 @@ Domain::CreateRegionIndexSets(Int_t nr, Int_t balance)
 void 
 Domain::SetupSymmetryPlanes(Int_t edgeNodes)
 {
-  Index_t nidx = 0 ;
+  m_nodeSymm.assign(numNode(), 0) ;
+
   for (Index_t i=0; i<edgeNodes; ++i) {
     Index_t planeInc = i*edgeNodes*edgeNodes ;
     Index_t rowInc   = i*edgeNodes ;
     for (Index_t j=0; j<edgeNodes; ++j) {
       if (m_planeLoc == 0) {
-	m_symmZ[nidx] = rowInc   + j ;
+	m_nodeSymm[rowInc + j] |= SYMM_Z ;
       }
       if (m_rowLoc == 0) {
-	m_symmY[nidx] = planeInc + j ;
+	m_nodeSymm[planeInc + j] |= SYMM_Y ;
       }
       if (m_colLoc == 0) {
-	m_symmX[nidx] = planeInc + j*edgeNodes ;
+	m_nodeSymm[planeInc + j*edgeNodes] |= SYMM_X ;
       }
-      ++nidx ;
     }
   }
 }
@@ -622,7 +642,7 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
 	lzetam(rowInc+j) = ghostIdx[0] + rowInc + j ;
       }
 
-      if (m_planeLoc == m_tp-1) {
+      if (m_planeLoc == m_tpz-1) {
 	elemBC(rowInc+j+numElem()-edgeElems*edgeElems) |=
 	  ZETA_P_FREE;
       }
@@ -641,7 +661,7 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
 	letam(planeInc+j) = ghostIdx[2] + rowInc + j ;
       }
 
-      if (m_rowLoc == m_tp-1) {
+      if (m_rowLoc == m_tpy-1) {
 	elemBC(planeInc+j+edgeElems*edgeElems-edgeElems) |= 
 	  ETA_P_FREE ;
       }
@@ -660,7 +680,7 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
 	lxim(planeInc+j*edgeElems) = ghostIdx[4] + rowInc + j ;
       }
 
-      if (m_colLoc == m_tp-1) {
+      if (m_colLoc == m_tpx-1) {
 	elemBC(planeInc+j*edgeElems+edgeElems-1) |= XI_P_FREE ;
       }
       else {
@@ -673,22 +693,60 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
 }
 
 ///////////////////////////////////////////////////////////////////////////
-void InitMeshDecomp(Int_t numRanks, Int_t myRank,
-                    Int_t *col, Int_t *row, Int_t *plane, Int_t *side)
+// Picks the most cubic process grid px*py*pz = numRanks (smallest
+// difference between the longest and the shortest side), with
+// px <= py <= pz.  Every domain is an nx^3 block whichever grid is used.
+static void FactorProcessGrid(Int_t numRanks, Int_t side[3])
+{
+   Int_t bestSpread = -1 ;
+
+   for (Int_t px=1 ; px*px*px<=numRanks ; ++px) {
+      if (numRanks % px != 0) {
+         continue ;
+      }
+      Int_t rest = numRanks / px ;
+      for (Int_t py=px ; py*py<=rest ; ++py) {
+         if (rest % py != 0) {
+            continue ;
+         }
+         Int_t pz = rest / py ;
+         if (bestSpread < 0 || pz - px < bestSpread) {
+            bestSpread = pz - px ;
+            side[0] = px ;
+            side[1] = py ;
+            side[2] = pz ;
+         }
+      }
+   }
+}
+
+///////////////////////////////////////////////////////////////////////////
+void InitMeshDecomp(Int_t numRanks, Int_t myRank, const Int_t grid[3],
+                    Int_t *col, Int_t *row, Int_t *plane, Int_t side[3])
 {
-   Int_t testProcs;
    Int_t dx, dy, dz;
    Int_t myDom;
    
-   // Assume cube processor layout for now 
-   testProcs = Int_t(cbrt(Real_t(numRanks))+0.5) ;
-   if (testProcs*testProcs*testProcs != numRanks) {
-      printf("Num processors must be a cube of an integer (1, 8, 27, ...)\n") ;
+   if (grid[0] > 0) {
+      // given on the command line (-grid)
+      side[0] = grid[0] ;
+      side[1] = grid[1] ;
+      side[2] = grid[2] ;
+      if (side[0]*side[1]*side[2] != numRanks) {
+         if (myRank == 0) {
+            printf("Process grid %d x %d x %d does not match %d processors\n",
+                   int(side[0]), int(side[1]), int(side[2]), int(numRanks)) ;
+            fflush(stdout) ;
+         }
 #if USE_MPI      
-      MPI_Abort(MPI_COMM_WORLD, -1) ;
+         MPI_Abort(MPI_COMM_WORLD, -1) ;
 #else
-      exit(-1);
+         exit(-1);
 #endif
+      }
+   }
+   else {
+      FactorProcessGrid(numRanks, side) ;
    }
    if (sizeof(Real_t) != 4 && sizeof(Real_t) != 8) {
       printf("MPI operations only support float and double right now...\n");
@@ -707,9 +765,9 @@ void InitMeshDecomp(Int_t numRanks, Int_t myRank,
 #endif
    }
 
-   dx = testProcs ;
-   dy = testProcs ;
-   dz = testProcs ;
+   dx = side[0] ;
+   dy = side[1] ;
+   dz = side[2] ;
 
    // temporary test
    if (dx*dy*dz != numRanks) {
@@ -732,7 +790,6 @@ void InitMeshDecomp(Int_t numRanks, Int_t myRank,
    *col = myDom % dx ;
    *row = (myDom / dx) % dy ;
    *plane = myDom / (dx*dy) ;
-   *side = testProcs;
 
    return;
 }
@@ -0,0 +1,336 @@
+#if _OPENMP
+#include <omp.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "lulesh.h"
+
+/*
+ * Parallel execution layer.
+ *
+ * Everything in lulesh.cc that runs in parallel is written SPMD style:
+ * ParRun() starts a function on every thread of the team, loops are
+ * split with ParRange() and separated with ParBarrier(), and thread 0
+ * does the allocations and MPI calls.  The layer has two backends:
+ *
+ *  PAR_OPENMP : the OpenMP runtime (parallel region, omp barrier,
+ *               omp tasks); serial when built without OpenMP
+ *  PAR_POOL   : a pool of std::threads started once.  Waiting (for the
+ *               next region, at barriers, for tasks) spins for
+ *               spinCount iterations and then sleeps on a condition
+ *               variable.  Tasks go to the spawning thread's deque;
+ *               idle threads take from their own deque first and then
+ *               steal from the other end of the others' deques.
+ *
+ * Thread 0 of both backends is the thread that called ParInit, so MPI
+ * calls made by thread 0 satisfy MPI_THREAD_FUNNELED.
+ */
+
+struct ParTask_t {
+   void (*fn)(void *) ;
+   void *arg ;
+} ;
+
+struct ParTaskQueue_t {
+   std::mutex lock ;
+   std::deque<ParTask_t> tasks ;
+} ;
+
+static Int_t s_backend = PAR_OPENMP ;
+static Int_t s_numThreads = 1 ;
+static Int_t s_spinCount = 0 ;
+
+// pool state
+static std::vector<std::thread> s_workers ;
+static std::vector<ParTaskQueue_t *> s_queues ;
+static std::atomic<unsigned> s_runGen(0) ;
+static std::atomic<unsigned> s_barrierGen(0) ;
+static std::atomic<Int_t> s_barrierCount(0) ;
+static std::atomic<Int_t> s_sleepers(0) ;
+static std::atomic<long> s_pendingTasks(0) ;
+static std::atomic<unsigned> s_taskGen(0) ;  // bumped by spawns and the last task
+static std::atomic<bool> s_stop(false) ;
+static std::mutex s_sleepLock ;
+static std::condition_variable s_wake ;
+static void (*s_runFn)(void *) = 0 ;
+static void *s_runArg = 0 ;
+static bool s_inRun = false ;
+static void *s_broadcast[2] = { 0, 0 } ;
+static thread_local Int_t t_threadId = 0 ;
+static thread_local Int_t t_broadcastCount = 0 ;
+
+static inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+   __builtin_ia32_pause() ;
+#endif
+}
+
+/* Waits until word no longer holds old: spin, then sleep */
+static void PoolWait(const std::atomic<unsigned> &word, unsigned old)
+{
+   for (Int_t i=0 ; i<s_spinCount ; ++i) {
+      if (word.load(std::memory_order_acquire) != old) {
+         return ;
+      }
+      CpuRelax() ;
+   }
+   std::unique_lock<std::mutex> guard(s_sleepLock) ;
+   ++s_sleepers ;
+   while (word.load() == old) {
+      s_wake.wait(guard) ;
+   }
+   --s_sleepers ;
+}
+
+/* Publishes a change of a word threads may be sleeping on */
+static void PoolWakeAll()
+{
+   if (s_sleepers.load() > 0) {
+      std::lock_guard<std::mutex> guard(s_sleepLock) ;
+      s_wake.notify_all() ;
+   }
+}
+
+static void PoolBarrier()
+{
+   unsigned gen = s_barrierGen.load(std::memory_order_acquire) ;
+   if (s_barrierCount.fetch_add(1) == s_numThreads-1) {
+      s_barrierCount.store(0) ;
+      s_barrierGen.fetch_add(1) ;
+      PoolWakeAll() ;
+   }
+   else {
+      PoolWait(s_barrierGen, gen) ;
+   }
+}
+
+static bool PoolRunOneTask(Int_t tid)
+{
+   ParTask_t task ;
+   bool found = false ;
+
+   // own queue, newest first
+   {
+      ParTaskQueue_t *q = s_queues[tid] ;
+      std::lock_guard<std::mutex> guard(q->lock) ;
+      if (!q->tasks.empty()) {
+         task = q->tasks.back() ;
+         q->tasks.pop_back() ;
+         found = true ;
+      }
+   }
+   // steal the oldest task of another thread
+   for (Int_t i=1 ; !found && i<s_numThreads ; ++i) {
+      ParTaskQueue_t *q = s_queues[(tid + i) % s_numThreads] ;
+      std::lock_guard<std::mutex> guard(q->lock) ;
+      if (!q->tasks.empty()) {
+         task = q->tasks.front() ;
+         q->tasks.pop_front() ;
+         found = true ;
+      }
+   }
+
+   if (found) {
+      task.fn(task.arg) ;
+      if (s_pendingTasks.fetch_sub(1) == 1) {
+         s_taskGen.fetch_add(1) ;
+         PoolWakeAll() ;
+      }
+   }
+   return found ;
+}
+
+static void PoolWorker(Int_t tid)
+{
+   t_threadId = tid ;
+   unsigned gen = 0 ;
+   for (;;) {
+      PoolWait(s_runGen, gen) ;
+      gen = s_runGen.load() ;
+      if (s_stop.load()) {
+         break ;
+      }
+      s_runFn(s_runArg) ;
+      PoolBarrier() ;
+   }
+}
+
+/******************************************/
+
+void ParInit(Int_t backend, Int_t numThreads, Int_t spinCount)
+{
+   s_backend = backend ;
+   s_spinCount = spinCount ;
+
+   if (backend == PAR_POOL) {
+      s_numThreads = (numThreads > 0) ? numThreads : 1 ;
+      for (Int_t t=0 ; t<s_numThreads ; ++t) {
+         s_queues.push_back(new ParTaskQueue_t) ;
+      }
+      for (Int_t t=1 ; t<s_numThreads ; ++t) {
+         s_workers.push_back(std::thread(PoolWorker, t)) ;
+      }
+   }
+   else {
+#if _OPENMP
+      s_numThreads = omp_get_max_threads() ;
+#else
+      s_numThreads = 1 ;
+#endif
+   }
+}
+
+void ParFinalize()
+{
+   if (s_backend == PAR_POOL) {
+      s_stop.store(true) ;
+      s_runGen.fetch_add(1) ;
+      PoolWakeAll() ;
+      for (size_t t=0 ; t<s_workers.size() ; ++t) {
+         s_workers[t].join() ;
+      }
+      s_workers.clear() ;
+      for (size_t t=0 ; t<s_queues.size() ; ++t) {
+         delete s_queues[t] ;
+      }
+      s_queues.clear() ;
+   }
+}
+
+Int_t ParBackend()
+{
+   return s_backend ;
+}
+
+Int_t ParNumThreads()
+{
+   return s_numThreads ;
+}
+
+Int_t ParThreadId()
+{
+   if (s_backend == PAR_POOL) {
+      return t_threadId ;
+   }
+#if _OPENMP
+   return omp_get_thread_num() ;
+#else
+   return 0 ;
+#endif
+}
+
+Int_t ParTeamSize()
+{
+   if (s_backend == PAR_POOL) {
+      return s_inRun ? s_numThreads : 1 ;
+   }
+#if _OPENMP
+   return omp_get_num_threads() ;
+#else
+   return 1 ;
+#endif
+}
+
+void ParRun(void (*fn)(void *), void *arg)
+{
+   if (s_backend == PAR_POOL) {
+      s_runFn = fn ;
+      s_runArg = arg ;
+      s_inRun = true ;
+      s_runGen.fetch_add(1) ;
+      PoolWakeAll() ;
+      fn(arg) ;
+      PoolBarrier() ;
+      s_inRun = false ;
+   }
+   else {
+#pragma omp parallel
+      fn(arg) ;
+   }
+}
+
+void ParBarrier()
+{
+   if (s_backend == PAR_POOL) {
+      PoolBarrier() ;
+   }
+   else {
+#pragma omp barrier
+   }
+}
+
+void ParRange(Index_t begin, Index_t end, Index_t *myBegin, Index_t *myEnd)
+{
+   // contiguous pieces whose sizes differ by at most one, like the
+   // static schedule of an OpenMP loop; the whole range outside a
+   // ParRun region
+   Int8_t n = (end > begin) ? Int8_t(end - begin) : 0 ;
+   Int8_t tid = ParThreadId() ;
+   Int8_t team = ParTeamSize() ;
+   Int8_t q = n / team ;
+   Int8_t r = n % team ;
+   Int8_t first = tid*q + ((tid < r) ? tid : r) ;
+   *myBegin = begin + Index_t(first) ;
+   *myEnd = begin + Index_t(first + q + ((tid < r) ? 1 : 0)) ;
+}
+
+void *ParBroadcast(void *value)
+{
+   // consecutive broadcasts alternate between two slots, so thread 0
+   // cannot overwrite a slot before everyone has read it: that would
+   // take it through the barrier of the following broadcast
+   Int_t slot = t_broadcastCount++ & 1 ;
+   if (ParThreadId() == 0) {
+      s_broadcast[slot] = value ;
+   }
+   ParBarrier() ;
+   return s_broadcast[slot] ;
+}
+
+void ParTaskSpawn(void (*fn)(void *), void *arg)
+{
+   if (s_backend == PAR_POOL) {
+      ParTaskQueue_t *q = s_queues[t_threadId] ;
+      s_pendingTasks.fetch_add(1) ;
+      {
+         std::lock_guard<std::mutex> guard(q->lock) ;
+         ParTask_t task ;
+         task.fn = fn ;
+         task.arg = arg ;
+         q->tasks.push_back(task) ;
+      }
+      s_taskGen.fetch_add(1) ;
+      PoolWakeAll() ;
+   }
+   else {
+#pragma omp task firstprivate(fn, arg)
+      fn(arg) ;
+   }
+}
+
+void ParTaskBarrier()
+{
+   if (s_backend == PAR_POOL) {
+      Int_t tid = t_threadId ;
+      while (s_pendingTasks.load() > 0) {
+         // every new task and the end of the last one bump s_taskGen,
+         // so a thread that found nothing to run waits for that
+         unsigned gen = s_taskGen.load(std::memory_order_acquire) ;
+         if (!PoolRunOneTask(tid)) {
+            PoolWait(s_taskGen, gen) ;
+         }
+      }
+      PoolBarrier() ;
+   }
+   else {
+      // an OpenMP barrier completes all tasks of the team
+#pragma omp barrier
+   }
+}
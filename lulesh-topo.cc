@@ -0,0 +1,366 @@
+#if USE_MPI
+# include <mpi.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "lulesh.h"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <unistd.h>
+#include <dirent.h>
+#define LULESH_HAVE_SYSFS 1
+#else
+#define LULESH_HAVE_SYSFS 0
+#endif
+
+/*
+ * Thread placement (-bind) and binding report.
+ *
+ * The CPU topology (package, core, NUMA node of every logical CPU the
+ * process may run on) is read from sysfs.  With -bind compact threads
+ * fill the hyperthreads of a core, then the cores of a package, then
+ * the next package; with -bind scatter they are spread over packages
+ * first and share a core only when every core is in use.  When several
+ * ranks on a node were given the same CPU set by the launcher, the set
+ * is first cut into one contiguous (compact order) piece per rank.
+ *
+ * The binding actually in effect is printed per rank, along with
+ * warnings for threads sharing a CPU and for teams that span several
+ * NUMA nodes: the Domain is initialized by the master thread, so all
+ * mesh data is first touched on the master thread's NUMA node.
+ */
+
+#if LULESH_HAVE_SYSFS
+
+struct CpuInfo_t {
+   int cpu ;
+   int package ;
+   int core ;
+   int numa ;
+   int smt ;       // hyperthread number within the core
+   int coreRank ;  // core number within the package
+} ;
+
+static int ReadIntFile(const char *path, int defaultVal)
+{
+   int val = defaultVal ;
+   FILE *f = fopen(path, "r") ;
+   if (f != NULL) {
+      if (fscanf(f, "%d", &val) != 1) {
+         val = defaultVal ;
+      }
+      fclose(f) ;
+   }
+   return val ;
+}
+
+static int FindCpuNumaNode(int cpu)
+{
+   char path[128] ;
+   int node = 0 ;
+   snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu) ;
+   DIR *dir = opendir(path) ;
+   if (dir != NULL) {
+      struct dirent *entry ;
+      while ((entry = readdir(dir)) != NULL) {
+         if (sscanf(entry->d_name, "node%d", &node) == 1) {
+            break ;
+         }
+      }
+      closedir(dir) ;
+   }
+   return node ;
+}
+
+static bool CompactOrder(const CpuInfo_t &a, const CpuInfo_t &b)
+{
+   if (a.package != b.package) return a.package < b.package ;
+   if (a.core != b.core) return a.core < b.core ;
+   return a.cpu < b.cpu ;
+}
+
+static bool ScatterOrder(const CpuInfo_t &a, const CpuInfo_t &b)
+{
+   if (a.smt != b.smt) return a.smt < b.smt ;
+   if (a.coreRank != b.coreRank) return a.coreRank < b.coreRank ;
+   if (a.package != b.package) return a.package < b.package ;
+   return a.cpu < b.cpu ;
+}
+
+/* Topology of the CPUs in the affinity mask, in compact order */
+static void DetectTopology(const cpu_set_t &mask, std::vector<CpuInfo_t> &cpus)
+{
+   char path[128] ;
+
+   cpus.clear() ;
+   for (int c=0 ; c<CPU_SETSIZE ; ++c) {
+      if (!CPU_ISSET(c, &mask)) {
+         continue ;
+      }
+      CpuInfo_t info ;
+      info.cpu = c ;
+      snprintf(path, sizeof(path),
+               "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c) ;
+      info.package = ReadIntFile(path, 0) ;
+      snprintf(path, sizeof(path),
+               "/sys/devices/system/cpu/cpu%d/topology/core_id", c) ;
+      info.core = ReadIntFile(path, c) ;
+      info.numa = FindCpuNumaNode(c) ;
+      info.smt = 0 ;
+      info.coreRank = 0 ;
+      cpus.push_back(info) ;
+   }
+
+   std::sort(cpus.begin(), cpus.end(), CompactOrder) ;
+
+   for (size_t i=1 ; i<cpus.size() ; ++i) {
+      const CpuInfo_t &prev = cpus[i-1] ;
+      if (cpus[i].package == prev.package) {
+         if (cpus[i].core == prev.core) {
+            cpus[i].smt = prev.smt + 1 ;
+            cpus[i].coreRank = prev.coreRank ;
+         }
+         else {
+            cpus[i].coreRank = prev.coreRank + 1 ;
+         }
+      }
+   }
+}
+
+static int CpuNumaNode(const std::vector<CpuInfo_t> &cpus, int cpu)
+{
+   for (size_t i=0 ; i<cpus.size() ; ++i) {
+      if (cpus[i].cpu == cpu) {
+         return cpus[i].numa ;
+      }
+   }
+   return FindCpuNumaNode(cpu) ;
+}
+
+/* "0-3,8" style list of the CPUs in a mask */
+static std::string FormatCpuList(const cpu_set_t &mask)
+{
+   std::string list ;
+   char buf[32] ;
+   for (int c=0 ; c<CPU_SETSIZE ; ++c) {
+      if (!CPU_ISSET(c, &mask)) {
+         continue ;
+      }
+      int last = c ;
+      while (last+1 < CPU_SETSIZE && CPU_ISSET(last+1, &mask)) {
+         ++last ;
+      }
+      if (last == c) {
+         snprintf(buf, sizeof(buf), "%s%d", list.empty() ? "" : ",", c) ;
+      }
+      else {
+         snprintf(buf, sizeof(buf), "%s%d-%d", list.empty() ? "" : ",", c, last) ;
+      }
+      list += buf ;
+      c = last ;
+   }
+   return list ;
+}
+
+#endif // LULESH_HAVE_SYSFS
+
+/******************************************/
+
+/* Prints the per-rank reports in rank order on rank 0 */
+static void PrintRankReports(const std::string &report, Int_t myRank, Int_t numRanks)
+{
+#if USE_MPI
+   int len = int(report.size()) ;
+   std::vector<int> lens(numRanks), displs(numRanks) ;
+   MPI_Gather(&len, 1, MPI_INT, &lens[0], 1, MPI_INT, 0, MPI_COMM_WORLD) ;
+
+   int total = 0 ;
+   if (myRank == 0) {
+      for (Int_t r=0 ; r<numRanks ; ++r) {
+         displs[r] = total ;
+         total += lens[r] ;
+      }
+   }
+   std::vector<char> all(total + 1) ;
+   MPI_Gatherv(const_cast<char *>(report.c_str()), len, MPI_CHAR,
+               &all[0], &lens[0], &displs[0], MPI_CHAR, 0, MPI_COMM_WORLD) ;
+   if (myRank == 0) {
+      all[total] = '\0' ;
+      printf("%s\n", &all[0]) ;
+      fflush(stdout) ;
+   }
+#else
+   printf("%s\n", report.c_str()) ;
+   fflush(stdout) ;
+#endif
+}
+
+/******************************************/
+
+#if LULESH_HAVE_SYSFS
+struct ThreadPin_t {
+   const std::vector<CpuInfo_t> *order ;
+   cpu_set_t *threadMasks ;
+   int *threadCpu ;
+} ;
+
+static void PinThread(void *arg)
+{
+   const ThreadPin_t *pin = static_cast<const ThreadPin_t *>(arg) ;
+   const std::vector<CpuInfo_t> &order = *pin->order ;
+   Int_t tid = ParThreadId() ;
+   cpu_set_t threadMask ;
+   CPU_ZERO(&threadMask) ;
+   CPU_SET(order[tid % Int_t(order.size())].cpu, &threadMask) ;
+   sched_setaffinity(0, sizeof(threadMask), &threadMask) ;
+}
+
+static void QueryThreadBinding(void *arg)
+{
+   const ThreadPin_t *pin = static_cast<const ThreadPin_t *>(arg) ;
+   Int_t tid = ParThreadId() ;
+   CPU_ZERO(&pin->threadMasks[tid]) ;
+   sched_getaffinity(0, sizeof(cpu_set_t), &pin->threadMasks[tid]) ;
+   pin->threadCpu[tid] = sched_getcpu() ;
+}
+#endif
+
+void SetupThreadBinding(Int_t policy, Int_t myRank, Int_t numRanks, bool report)
+{
+   Int_t numThreads = ParNumThreads() ;
+   std::string text ;
+   char line[256] ;
+
+#if LULESH_HAVE_SYSFS
+   cpu_set_t procMask ;
+   std::vector<CpuInfo_t> cpus ;
+
+   CPU_ZERO(&procMask) ;
+   sched_getaffinity(0, sizeof(procMask), &procMask) ;
+   DetectTopology(procMask, cpus) ;
+
+   if (policy != BIND_NONE && !cpus.empty()) {
+      Int_t first = 0 ;
+      Int_t count = Int_t(cpus.size()) ;
+#if USE_MPI
+      // Ranks on one node that were all handed the same CPU set share
+      // it out in contiguous pieces
+      MPI_Comm nodeComm ;
+      int localRank, localSize ;
+      MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, myRank,
+                          MPI_INFO_NULL, &nodeComm) ;
+      MPI_Comm_rank(nodeComm, &localRank) ;
+      MPI_Comm_size(nodeComm, &localSize) ;
+      if (localSize > 1) {
+         std::vector<cpu_set_t> masks(localSize) ;
+         MPI_Allgather(&procMask, int(sizeof(cpu_set_t)), MPI_BYTE,
+                       &masks[0], int(sizeof(cpu_set_t)), MPI_BYTE, nodeComm) ;
+         bool shared = true ;
+         for (int r=0 ; r<localSize ; ++r) {
+            shared = shared && CPU_EQUAL(&masks[r], &procMask) ;
+         }
+         if (shared && count >= localSize) {
+            first = Int_t((Int8_t(localRank)*count)/localSize) ;
+            count = Int_t((Int8_t(localRank+1)*count)/localSize) - first ;
+         }
+      }
+      MPI_Comm_free(&nodeComm) ;
+#endif
+      std::vector<CpuInfo_t> order(cpus.begin() + first,
+                                   cpus.begin() + first + count) ;
+      if (policy == BIND_SCATTER) {
+         std::sort(order.begin(), order.end(), ScatterOrder) ;
+      }
+
+      ThreadPin_t pin ;
+      pin.order = &order ;
+      ParRun(PinThread, &pin) ;
+   }
+
+   if (!report) {
+      return ;
+   }
+
+   // Gather what every thread is actually allowed to run on
+   std::vector<cpu_set_t> threadMasks(numThreads) ;
+   std::vector<int> threadCpu(numThreads) ;
+   ThreadPin_t query ;
+   query.threadMasks = &threadMasks[0] ;
+   query.threadCpu = &threadCpu[0] ;
+   ParRun(QueryThreadBinding, &query) ;
+
+   char host[64] ;
+   gethostname(host, sizeof(host)) ;
+   host[sizeof(host)-1] = '\0' ;
+   snprintf(line, sizeof(line), "Rank %d on %s: %d threads, cpus %s\n",
+            int(myRank), host, int(numThreads), FormatCpuList(procMask).c_str()) ;
+   text += line ;
+
+   int masterNuma = CpuNumaNode(cpus, threadCpu[0]) ;
+   std::vector<int> numaUsed ;
+   bool pinned = true ;
+   bool piled = false ;
+   for (Int_t t=0 ; t<numThreads ; ++t) {
+      int numCpu = CPU_COUNT(&threadMasks[t]) ;
+      std::string where ;
+      for (int c=0 ; c<CPU_SETSIZE ; ++c) {
+         if (CPU_ISSET(c, &threadMasks[t])) {
+            int numa = CpuNumaNode(cpus, c) ;
+            if (std::find(numaUsed.begin(), numaUsed.end(), numa) == numaUsed.end()) {
+               numaUsed.push_back(numa) ;
+            }
+            if (numCpu == 1) {
+               for (size_t i=0 ; i<cpus.size() ; ++i) {
+                  if (cpus[i].cpu == c) {
+                     snprintf(line, sizeof(line), " (package %d core %d numa %d)",
+                              cpus[i].package, cpus[i].core, cpus[i].numa) ;
+                     where = line ;
+                  }
+               }
+            }
+         }
+      }
+      if (numCpu != 1) {
+         pinned = false ;
+      }
+      for (Int_t u=0 ; u<t ; ++u) {
+         if (numCpu == 1 && CPU_EQUAL(&threadMasks[u], &threadMasks[t])) {
+            piled = true ;
+         }
+      }
+      snprintf(line, sizeof(line), "   thread %3d -> cpus %s%s\n", int(t),
+               FormatCpuList(threadMasks[t]).c_str(), where.c_str()) ;
+      text += line ;
+   }
+
+   if (piled) {
+      snprintf(line, sizeof(line),
+               "   WARNING: rank %d has several threads bound to the same cpu\n",
+               int(myRank)) ;
+      text += line ;
+   }
+   if (numaUsed.size() > 1) {
+      snprintf(line, sizeof(line),
+               "   WARNING: rank %d threads %s %d NUMA nodes, but the mesh is "
+               "first touched by the master thread on node %d\n",
+               int(myRank), pinned ? "span" : "may run on", int(numaUsed.size()),
+               masterNuma) ;
+      text += line ;
+   }
+#else
+   if (!report) {
+      return ;
+   }
+   snprintf(line, sizeof(line), "Rank %d: %d threads, topology not available%s\n",
+            int(myRank), int(numThreads),
+            policy != BIND_NONE ? " (-bind ignored)" : "") ;
+   text += line ;
+#endif
+
+   PrintRankReports(text, myRank, numRanks) ;
+}
@@ -37,12 +37,34 @@ static void PrintCommandLineOptions(char *execname, int myRank)
       printf(" -q              : quiet mode - suppress all stdout\n");
       printf(" -i <iterations> : number of cycles to run\n");
       printf(" -s <size>       : length of cube mesh along side\n");
+      printf(" -grid <px>x<py>x<pz> : Process grid (def: most cubic factorization of np)\n");
       printf(" -r <numregions> : Number of distinct regions (def: 11)\n");
       printf(" -b <balance>    : Load balance between regions of a domain (def: 1)\n");
       printf(" -c <cost>       : Extra cost of more expensive regions (def: 1)\n");
       printf(" -f <numfiles>   : Number of files to split viz dump into (def: (np+10)/9)\n");
       printf(" -p              : Print out progress\n");
       printf(" -v              : Output viz file (requires compiling with -DVIZ_MESH\n");
+      printf(" -dump <file>    : Write the final e of every element to <file>.<rank>, full precision\n");
+      printf(" -hs             : Keep half-step nodal coordinates (not bitwise identical)\n");
+      printf(" -tg             : Run the element phase as a dataflow task graph\n");
+      printf(" -det            : Results independent of thread and rank count\n");
+      printf(" -part           : Split the EOS work statically by measured cost\n");
+      printf(" -batch          : Evaluate small regions of equal cost together\n");
+      printf(" -bind <policy>  : Pin threads: compact, scatter or none (def: none)\n");
+      printf(" -par <backend>  : Threading layer: omp or pool (def: omp)\n");
+      printf(" -spin <n>       : Spins before an idle pool thread sleeps (def: %d)\n", PAR_SPIN_COUNT);
+      printf(" -hybrid         : All threads take part in the halo exchange (needs MPI_THREAD_MULTIPLE)\n");
+      printf(" -persist        : Reuse persistent MPI requests for the halo exchanges\n");
+      printf(" -dtype          : Send halos straight from the field arrays with MPI datatypes\n");
+      printf(" -neighbor       : Cartesian communicator and neighborhood collective halo exchanges\n");
+      printf(" -overlap        : Compute the boundary first and overlap the halo exchanges with the interior\n");
+      printf(" -shm            : Exchange halos with neighbors on the same node through a shared-memory window\n");
+      printf(" -rma <sync>     : One-sided halo exchanges synchronized with fence or pscw\n");
+      printf(" -tpack          : All threads pack the halo faces and unpack the halos; thread 0\n");
+      printf("                   packs the edges and corners and makes the MPI calls\n");
+      printf(" -sweep          : Route edge and corner halos through the faces: 6 messages per exchange\n");
+      printf(" -commbench <n>  : Time n cycles of halo exchanges in each mode first\n");
+      printf(" -packbench <n>  : Time n packs and unpacks of each face orientation first\n");
       printf(" -h              : This message\n");
       printf("\n\n");
    }
@@ -90,6 +112,30 @@ void ParseCommandLineOptions(int argc, char *argv[],
             }
             i+=2;
          }
+         /* -grid <px>x<py>x<pz> */
+         else if (strcmp(argv[i], "-grid") == 0) {
+            int px, py, pz ;
+            char extra ;
+            if (i+1 >= argc) {
+               ParseError("Missing argument to -grid\n", myRank);
+            }
+            if (sscanf(argv[i+1], "%dx%dx%d%c", &px, &py, &pz, &extra) != 3 ||
+                px < 1 || py < 1 || pz < 1) {
+               ParseError("Parse Error on option -grid <px>x<py>x<pz> positive integers required after argument\n", myRank);
+            }
+            opts->grid[0] = px;
+            opts->grid[1] = py;
+            opts->grid[2] = pz;
+            i+=2;
+         }
+         /* -dump <file> */
+         else if (strcmp(argv[i], "-dump") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing file name argument to -dump\n", myRank);
+            }
+            opts->dumpFile = argv[i+1];
+            i+=2;
+         }
 	 /* -r <numregions> */
          else if (strcmp(argv[i], "-r") == 0) {
             if (i+1 >= argc) {
@@ -142,6 +188,155 @@ void ParseCommandLineOptions(int argc, char *argv[],
             }
             i+=2;
          }
+         /* -hs */
+         else if (strcmp(argv[i], "-hs") == 0) {
+            opts->halfStep = 1;
+            i++;
+         }
+         /* -tg */
+         else if (strcmp(argv[i], "-tg") == 0) {
+            opts->taskGraph = 1;
+            i++;
+         }
+         /* -bind <policy> */
+         else if (strcmp(argv[i], "-bind") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing argument to -bind\n", myRank);
+            }
+            if (strcmp(argv[i+1], "compact") == 0) {
+               opts->bind = BIND_COMPACT;
+            }
+            else if (strcmp(argv[i+1], "scatter") == 0) {
+               opts->bind = BIND_SCATTER;
+            }
+            else if (strcmp(argv[i+1], "none") == 0) {
+               opts->bind = BIND_NONE;
+            }
+            else {
+               ParseError("Parse Error on option -bind compact, scatter or none required after argument\n", myRank);
+            }
+            i+=2;
+         }
+         /* -par <backend> */
+         else if (strcmp(argv[i], "-par") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing argument to -par\n", myRank);
+            }
+            if (strcmp(argv[i+1], "omp") == 0) {
+               opts->par = PAR_OPENMP;
+            }
+            else if (strcmp(argv[i+1], "pool") == 0) {
+               opts->par = PAR_POOL;
+            }
+            else {
+               ParseError("Parse Error on option -par omp or pool required after argument\n", myRank);
+            }
+            i+=2;
+         }
+         /* -spin <n> */
+         else if (strcmp(argv[i], "-spin") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing integer argument to -spin\n", myRank);
+            }
+            ok = StrToInt(argv[i+1], &(opts->spin));
+            if (!ok || opts->spin < 0) {
+               ParseError("Parse Error on option -spin non-negative integer value required after argument\n", myRank);
+            }
+            i+=2;
+         }
+         /* -hybrid */
+         else if (strcmp(argv[i], "-hybrid") == 0) {
+            opts->hybrid = 1;
+            i++;
+         }
+         /* -persist */
+         else if (strcmp(argv[i], "-persist") == 0) {
+            opts->persist = 1;
+            i++;
+         }
+         /* -dtype */
+         else if (strcmp(argv[i], "-dtype") == 0) {
+            opts->dtype = 1;
+            i++;
+         }
+         /* -neighbor */
+         else if (strcmp(argv[i], "-neighbor") == 0) {
+            opts->neighbor = 1;
+            i++;
+         }
+         /* -overlap */
+         else if (strcmp(argv[i], "-overlap") == 0) {
+            opts->overlap = 1;
+            i++;
+         }
+         /* -shm */
+         else if (strcmp(argv[i], "-shm") == 0) {
+            opts->shm = 1;
+            i++;
+         }
+         /* -rma <sync> */
+         else if (strcmp(argv[i], "-rma") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing argument to -rma\n", myRank);
+            }
+            if (strcmp(argv[i+1], "fence") == 0) {
+               opts->rma = COMM_RMA_FENCE;
+            }
+            else if (strcmp(argv[i+1], "pscw") == 0) {
+               opts->rma = COMM_RMA_PSCW;
+            }
+            else {
+               ParseError("Parse Error on option -rma fence or pscw required after argument\n", myRank);
+            }
+            i+=2;
+         }
+         /* -tpack */
+         else if (strcmp(argv[i], "-tpack") == 0) {
+            opts->teamPack = 1;
+            i++;
+         }
+         /* -sweep */
+         else if (strcmp(argv[i], "-sweep") == 0) {
+            opts->sweep = 1;
+            i++;
+         }
+         /* -commbench */
+         else if (strcmp(argv[i], "-commbench") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing integer argument to -commbench\n", myRank);
+            }
+            ok = StrToInt(argv[i+1], &(opts->commBench));
+            if (!ok || opts->commBench < 0) {
+               ParseError("Parse Error on option -commbench non-negative integer value required after argument\n", myRank);
+            }
+            i+=2;
+         }
+         /* -packbench */
+         else if (strcmp(argv[i], "-packbench") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing integer argument to -packbench\n", myRank);
+            }
+            ok = StrToInt(argv[i+1], &(opts->packBench));
+            if (!ok || opts->packBench < 0) {
+               ParseError("Parse Error on option -packbench non-negative integer value required after argument\n", myRank);
+            }
+            i+=2;
+         }
+         /* -part */
+         else if (strcmp(argv[i], "-part") == 0) {
+            opts->part = 1;
+            i++;
+         }
+         /* -batch */
+         else if (strcmp(argv[i], "-batch") == 0) {
+            opts->batch = 1;
+            i++;
+         }
+         /* -det */
+         else if (strcmp(argv[i], "-det") == 0) {
+            opts->deterministic = 1;
+            i++;
+         }
          /* -v */
          else if (strcmp(argv[i], "-v") == 0) {
 #if VIZ_MESH            
@@ -228,3 +423,40 @@ void VerifyAndWriteFinalOutput(Real_t elapsed_time,
 
    return ;
 }
+
+/////////////////////////////////////////////////////////////////////
+
+/* Writes "<global element> <e>" lines for the elements of this rank to
+ * <name>.<rank>.  The global element number is the same for any
+ * process grid, so the sorted concatenation of all files of a run can
+ * be compared with a run on another rank count (see tests/). */
+void DumpElemEnergy(Domain& locDom, const char *name, Int_t myRank)
+{
+   char fileName[1024] ;
+   snprintf(fileName, sizeof(fileName), "%s.%d", name, int(myRank)) ;
+   FILE *fp = fopen(fileName, "w") ;
+   if (fp == NULL) {
+      printf("Could not open %s for -dump\n", fileName) ;
+      return ;
+   }
+
+   Int8_t nx = locDom.sizeX() ;
+   Int8_t ny = locDom.sizeY() ;
+   Int8_t nz = locDom.sizeZ() ;
+   Int8_t globalX = nx*locDom.tpx() ;
+   Int8_t globalY = ny*locDom.tpy() ;
+   Index_t elem = 0 ;
+   for (Int8_t plane=0 ; plane<nz ; ++plane) {
+      for (Int8_t row=0 ; row<ny ; ++row) {
+         for (Int8_t col=0 ; col<nx ; ++col, ++elem) {
+            Int8_t gz = locDom.planeLoc()*nz + plane ;
+            Int8_t gy = locDom.rowLoc()*ny + row ;
+            Int8_t gx = locDom.colLoc()*nx + col ;
+            fprintf(fp, "%lld %.17e\n",
+                    (long long)((gz*globalY + gy)*globalX + gx),
+                    double(locDom.e(elem))) ;
+         }
+      }
+   }
+   fclose(fp) ;
+}
@@ -66,7 +66,7 @@ void DumpToVisit(Domain& domain, int numFiles, int myRank, int numRanks)
 
   PMPIO_baton_t *bat = PMPIO_Init(numFiles,
 				  PMPIO_WRITE,
-				  MPI_COMM_WORLD,
+				  domain.comm,
 				  10101,
 				  LULESH_PMPIO_Create,
 				  LULESH_PMPIO_Open,
@@ -146,6 +146,9 @@ Additional BSD Notice
 
 #include <climits>
 #include <vector>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
@@ -163,6 +166,50 @@ Additional BSD Notice
 
 /* Work Routines */
 
+/* Seconds on a monotonic clock, for the run-time measurements */
+static inline double WallClock()
+{
+   timespec ts ;
+   clock_gettime(CLOCK_MONOTONIC, &ts) ;
+   return double(ts.tv_sec) + 1.0e-9*double(ts.tv_nsec) ;
+}
+
+/******************************************/
+
+/* Local time step limit from the constraints of the last cycle */
+static inline
+Real_t CalcLocalNewDt(Domain& domain)
+{
+   Real_t gnewdt = Real_t(1.0e+20) ;
+   if (domain.dtcourant() < gnewdt) {
+      gnewdt = domain.dtcourant() / Real_t(2.0) ;
+   }
+   if (domain.dthydro() < gnewdt) {
+      gnewdt = domain.dthydro() * Real_t(2.0) / Real_t(3.0) ;
+   }
+   return gnewdt ;
+}
+
+/*
+ * Starts the global time step reduction as soon as the time constraints
+ * are known.  Nothing in the force calculation of the next cycle uses
+ * the time step, so TimeIncrement() only completes the reduction just
+ * before the velocity update, and the latency of the Allreduce is
+ * hidden behind the forces.  Called by thread 0.
+ */
+static inline
+void TimeIncrementStart(Domain& domain)
+{
+#if USE_MPI
+   if (domain.dtfixed() <= Real_t(0.0)) {
+      domain.dtLocal = CalcLocalNewDt(domain) ;
+      MPI_Iallreduce(&domain.dtLocal, &domain.dtGlobal, 1,
+                     ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE),
+                     MPI_MIN, domain.comm, &domain.dtRequest) ;
+   }
+#endif
+}
+
 static inline
 void TimeIncrement(Domain& domain)
 {
@@ -173,21 +220,14 @@ void TimeIncrement(Domain& domain)
       Real_t olddt = domain.deltatime() ;
 
       /* This will require a reduction in parallel */
-      Real_t gnewdt = Real_t(1.0e+20) ;
       Real_t newdt ;
-      if (domain.dtcourant() < gnewdt) {
-         gnewdt = domain.dtcourant() / Real_t(2.0) ;
-      }
-      if (domain.dthydro() < gnewdt) {
-         gnewdt = domain.dthydro() * Real_t(2.0) / Real_t(3.0) ;
-      }
 
 #if USE_MPI      
-      MPI_Allreduce(&gnewdt, &newdt, 1,
-                    ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE),
-                    MPI_MIN, MPI_COMM_WORLD) ;
+      // started by TimeIncrementStart at the end of the last cycle
+      MPI_Wait(&domain.dtRequest, MPI_STATUS_IGNORE) ;
+      newdt = domain.dtGlobal ;
 #else
-      newdt = gnewdt;
+      newdt = CalcLocalNewDt(domain) ;
 #endif
       
       ratio = newdt / olddt ;
@@ -279,10 +319,12 @@ void InitStressTermsForElems(Domain &domain,
    // pull in the stresses appropriate to the hydro integration
    //
 
-#pragma omp parallel for firstprivate(numElem)
-   for (Index_t i = 0 ; i < numElem ; ++i){
+   Index_t iBegin, iEnd ;
+   ParRange(0, numElem, &iBegin, &iEnd) ;
+   for (Index_t i=iBegin ; i<iEnd ; ++i) {
       sigxx[i] = sigyy[i] = sigzz[i] =  - domain.p(i) - domain.q(i) ;
    }
+   ParBarrier() ;
 }
 
 /******************************************/
@@ -496,30 +538,35 @@ void IntegrateStressForElems( Domain &domain,
                               Real_t *sigxx, Real_t *sigyy, Real_t *sigzz,
                               Real_t *determ, Index_t numElem, Index_t numNode)
 {
-#if _OPENMP
-   Index_t numthreads = omp_get_max_threads();
-#else
-   Index_t numthreads = 1;
-#endif
+   Index_t numthreads = ParNumThreads();
 
    Index_t numElem8 = numElem * 8 ;
-   Real_t *fx_elem;
-   Real_t *fy_elem;
-   Real_t *fz_elem;
+   Real_t *fx_elem = NULL ;
+   Real_t *fy_elem = NULL ;
+   Real_t *fz_elem = NULL ;
    Real_t fx_local[8] ;
    Real_t fy_local[8] ;
    Real_t fz_local[8] ;
+   const bool deterministic = (domain.deterministic() != 0) ;
 
 
-  if (numthreads > 1) {
-     fx_elem = Allocate<Real_t>(numElem8) ;
-     fy_elem = Allocate<Real_t>(numElem8) ;
-     fz_elem = Allocate<Real_t>(numElem8) ;
+  if (deterministic) {
+     // keep the corner forces; the hourglass forces are added to them
+     // and they are summed to the nodes in CalcForceForNodes
+     fx_elem = &domain.fxCorner(0) ;
+     fy_elem = &domain.fyCorner(0) ;
+     fz_elem = &domain.fzCorner(0) ;
+  }
+  else if (numthreads > 1) {
+     fx_elem = ParAllocate<Real_t>(numElem8) ;
+     fy_elem = ParAllocate<Real_t>(numElem8) ;
+     fz_elem = ParAllocate<Real_t>(numElem8) ;
   }
   // loop over all elements
 
-#pragma omp parallel for firstprivate(numElem)
-  for( Index_t k=0 ; k<numElem ; ++k )
+  Index_t kBegin, kEnd ;
+  ParRange(0, numElem, &kBegin, &kEnd) ;
+  for (Index_t k=kBegin ; k<kEnd ; ++k)
   {
     const Index_t* const elemToNode = domain.nodelist(k);
     Real_t B[3][8] ;// shape function derivatives
@@ -537,7 +584,7 @@ void IntegrateStressForElems( Domain &domain,
     CalcElemNodeNormals( B[0] , B[1], B[2],
                           x_local, y_local, z_local );
 
-    if (numthreads > 1) {
+    if (deterministic || numthreads > 1) {
        // Eliminate thread writing conflicts at the nodes by giving
        // each element its own copy to write to
        SumElemStressesToNodeForces( B, sigxx[k], sigyy[k], sigzz[k],
@@ -558,12 +605,14 @@ void IntegrateStressForElems( Domain &domain,
        }
     }
   }
+  ParBarrier() ;
 
-  if (numthreads > 1) {
+  if (!deterministic && numthreads > 1) {
      // If threaded, then we need to copy the data out of the temporary
      // arrays used above into the final forces field
-#pragma omp parallel for firstprivate(numNode)
-     for( Index_t gnode=0 ; gnode<numNode ; ++gnode )
+     Index_t gnodeBegin, gnodeEnd ;
+     ParRange(0, numNode, &gnodeBegin, &gnodeEnd) ;
+     for (Index_t gnode=gnodeBegin ; gnode<gnodeEnd ; ++gnode)
      {
         Index_t count = domain.nodeElemCount(gnode) ;
         Index_t *cornerList = domain.nodeElemCornerList(gnode) ;
@@ -580,9 +629,13 @@ void IntegrateStressForElems( Domain &domain,
         domain.fy(gnode) = fy_tmp ;
         domain.fz(gnode) = fz_tmp ;
      }
-     Release(&fz_elem) ;
-     Release(&fy_elem) ;
-     Release(&fx_elem) ;
+     ParBarrier() ;
+     if (ParThreadId() == 0)
+     {
+        Release(&fz_elem) ;
+        Release(&fy_elem) ;
+        Release(&fx_elem) ;
+     }
   }
 }
 
@@ -708,40 +761,8 @@ void CalcElemFBHourglassForce(Real_t *xd, Real_t *yd, Real_t *zd,  Real_t hourga
 /******************************************/
 
 static inline
-void CalcFBHourglassForceForElems( Domain &domain,
-                                   Real_t *determ,
-                                   Real_t *x8n, Real_t *y8n, Real_t *z8n,
-                                   Real_t *dvdx, Real_t *dvdy, Real_t *dvdz,
-                                   Real_t hourg, Index_t numElem,
-                                   Index_t numNode)
+void SetHourglassGamma(Real_t gamma[4][8])
 {
-
-#if _OPENMP
-   Index_t numthreads = omp_get_max_threads();
-#else
-   Index_t numthreads = 1;
-#endif
-   /*************************************************
-    *
-    *     FUNCTION: Calculates the Flanagan-Belytschko anti-hourglass
-    *               force.
-    *
-    *************************************************/
-  
-   Index_t numElem8 = numElem * 8 ;
-
-   Real_t *fx_elem; 
-   Real_t *fy_elem; 
-   Real_t *fz_elem; 
-
-   if(numthreads > 1) {
-      fx_elem = Allocate<Real_t>(numElem8) ;
-      fy_elem = Allocate<Real_t>(numElem8) ;
-      fz_elem = Allocate<Real_t>(numElem8) ;
-   }
-
-   Real_t  gamma[4][8];
-
    gamma[0][0] = Real_t( 1.);
    gamma[0][1] = Real_t( 1.);
    gamma[0][2] = Real_t(-1.);
@@ -774,13 +795,123 @@ void CalcFBHourglassForceForElems( Domain &domain,
    gamma[3][5] = Real_t(-1.);
    gamma[3][6] = Real_t( 1.);
    gamma[3][7] = Real_t(-1.);
+}
+
+/******************************************/
+
+/* Hourglass modes of one element from its nodal coordinates and volume
+ * derivatives */
+static inline
+void CalcElemHourglassModes(const Real_t *x8n, const Real_t *y8n,
+                            const Real_t *z8n, const Real_t *dvdx,
+                            const Real_t *dvdy, const Real_t *dvdz,
+                            Real_t volinv, const Real_t gamma[4][8],
+                            Real_t hourgam[8][4])
+{
+   for(Index_t i1=0;i1<4;++i1){
+
+      Real_t hourmodx =
+         x8n[0] * gamma[i1][0] + x8n[1] * gamma[i1][1] +
+         x8n[2] * gamma[i1][2] + x8n[3] * gamma[i1][3] +
+         x8n[4] * gamma[i1][4] + x8n[5] * gamma[i1][5] +
+         x8n[6] * gamma[i1][6] + x8n[7] * gamma[i1][7];
+
+      Real_t hourmody =
+         y8n[0] * gamma[i1][0] + y8n[1] * gamma[i1][1] +
+         y8n[2] * gamma[i1][2] + y8n[3] * gamma[i1][3] +
+         y8n[4] * gamma[i1][4] + y8n[5] * gamma[i1][5] +
+         y8n[6] * gamma[i1][6] + y8n[7] * gamma[i1][7];
+
+      Real_t hourmodz =
+         z8n[0] * gamma[i1][0] + z8n[1] * gamma[i1][1] +
+         z8n[2] * gamma[i1][2] + z8n[3] * gamma[i1][3] +
+         z8n[4] * gamma[i1][4] + z8n[5] * gamma[i1][5] +
+         z8n[6] * gamma[i1][6] + z8n[7] * gamma[i1][7];
+
+      hourgam[0][i1] = gamma[i1][0] -  volinv*(dvdx[0] * hourmodx +
+                                               dvdy[0] * hourmody +
+                                               dvdz[0] * hourmodz );
+
+      hourgam[1][i1] = gamma[i1][1] -  volinv*(dvdx[1] * hourmodx +
+                                               dvdy[1] * hourmody +
+                                               dvdz[1] * hourmodz );
+
+      hourgam[2][i1] = gamma[i1][2] -  volinv*(dvdx[2] * hourmodx +
+                                               dvdy[2] * hourmody +
+                                               dvdz[2] * hourmodz );
+
+      hourgam[3][i1] = gamma[i1][3] -  volinv*(dvdx[3] * hourmodx +
+                                               dvdy[3] * hourmody +
+                                               dvdz[3] * hourmodz );
+
+      hourgam[4][i1] = gamma[i1][4] -  volinv*(dvdx[4] * hourmodx +
+                                               dvdy[4] * hourmody +
+                                               dvdz[4] * hourmodz );
+
+      hourgam[5][i1] = gamma[i1][5] -  volinv*(dvdx[5] * hourmodx +
+                                               dvdy[5] * hourmody +
+                                               dvdz[5] * hourmodz );
+
+      hourgam[6][i1] = gamma[i1][6] -  volinv*(dvdx[6] * hourmodx +
+                                               dvdy[6] * hourmody +
+                                               dvdz[6] * hourmodz );
+
+      hourgam[7][i1] = gamma[i1][7] -  volinv*(dvdx[7] * hourmodx +
+                                               dvdy[7] * hourmody +
+                                               dvdz[7] * hourmodz );
+
+   }
+}
+
+/******************************************/
+
+static inline
+void CalcFBHourglassForceForElems( Domain &domain,
+                                   Real_t *determ,
+                                   Real_t *x8n, Real_t *y8n, Real_t *z8n,
+                                   Real_t *dvdx, Real_t *dvdy, Real_t *dvdz,
+                                   Real_t hourg, Index_t numElem,
+                                   Index_t numNode)
+{
+
+   Index_t numthreads = ParNumThreads();
+   /*************************************************
+    *
+    *     FUNCTION: Calculates the Flanagan-Belytschko anti-hourglass
+    *               force.
+    *
+    *************************************************/
+  
+   Index_t numElem8 = numElem * 8 ;
+
+   Real_t *fx_elem = NULL ;
+   Real_t *fy_elem = NULL ;
+   Real_t *fz_elem = NULL ;
+   const bool deterministic = (domain.deterministic() != 0) ;
+
+   if (deterministic) {
+      // add to the corner forces left by IntegrateStressForElems
+      fx_elem = &domain.fxCorner(0) ;
+      fy_elem = &domain.fyCorner(0) ;
+      fz_elem = &domain.fzCorner(0) ;
+   }
+   else if(numthreads > 1) {
+      fx_elem = ParAllocate<Real_t>(numElem8) ;
+      fy_elem = ParAllocate<Real_t>(numElem8) ;
+      fz_elem = ParAllocate<Real_t>(numElem8) ;
+   }
+
+   Real_t  gamma[4][8];
+
+   SetHourglassGamma(gamma) ;
 
 /*************************************************/
 /*    compute the hourglass modes */
 
 
-#pragma omp parallel for firstprivate(numElem, hourg)
-   for(Index_t i2=0;i2<numElem;++i2){
+   Index_t i2Begin, i2End ;
+   ParRange(0, numElem, &i2Begin, &i2End) ;
+   for (Index_t i2=i2Begin ; i2<i2End ; ++i2) {
       Real_t *fx_local, *fy_local, *fz_local ;
       Real_t hgfx[8], hgfy[8], hgfz[8] ;
 
@@ -793,59 +924,9 @@ void CalcFBHourglassForceForElems( Domain &domain,
       Index_t i3=8*i2;
       Real_t volinv=Real_t(1.0)/determ[i2];
       Real_t ss1, mass1, volume13 ;
-      for(Index_t i1=0;i1<4;++i1){
-
-         Real_t hourmodx =
-            x8n[i3] * gamma[i1][0] + x8n[i3+1] * gamma[i1][1] +
-            x8n[i3+2] * gamma[i1][2] + x8n[i3+3] * gamma[i1][3] +
-            x8n[i3+4] * gamma[i1][4] + x8n[i3+5] * gamma[i1][5] +
-            x8n[i3+6] * gamma[i1][6] + x8n[i3+7] * gamma[i1][7];
-
-         Real_t hourmody =
-            y8n[i3] * gamma[i1][0] + y8n[i3+1] * gamma[i1][1] +
-            y8n[i3+2] * gamma[i1][2] + y8n[i3+3] * gamma[i1][3] +
-            y8n[i3+4] * gamma[i1][4] + y8n[i3+5] * gamma[i1][5] +
-            y8n[i3+6] * gamma[i1][6] + y8n[i3+7] * gamma[i1][7];
-
-         Real_t hourmodz =
-            z8n[i3] * gamma[i1][0] + z8n[i3+1] * gamma[i1][1] +
-            z8n[i3+2] * gamma[i1][2] + z8n[i3+3] * gamma[i1][3] +
-            z8n[i3+4] * gamma[i1][4] + z8n[i3+5] * gamma[i1][5] +
-            z8n[i3+6] * gamma[i1][6] + z8n[i3+7] * gamma[i1][7];
-
-         hourgam[0][i1] = gamma[i1][0] -  volinv*(dvdx[i3  ] * hourmodx +
-                                                  dvdy[i3  ] * hourmody +
-                                                  dvdz[i3  ] * hourmodz );
-
-         hourgam[1][i1] = gamma[i1][1] -  volinv*(dvdx[i3+1] * hourmodx +
-                                                  dvdy[i3+1] * hourmody +
-                                                  dvdz[i3+1] * hourmodz );
-
-         hourgam[2][i1] = gamma[i1][2] -  volinv*(dvdx[i3+2] * hourmodx +
-                                                  dvdy[i3+2] * hourmody +
-                                                  dvdz[i3+2] * hourmodz );
-
-         hourgam[3][i1] = gamma[i1][3] -  volinv*(dvdx[i3+3] * hourmodx +
-                                                  dvdy[i3+3] * hourmody +
-                                                  dvdz[i3+3] * hourmodz );
-
-         hourgam[4][i1] = gamma[i1][4] -  volinv*(dvdx[i3+4] * hourmodx +
-                                                  dvdy[i3+4] * hourmody +
-                                                  dvdz[i3+4] * hourmodz );
-
-         hourgam[5][i1] = gamma[i1][5] -  volinv*(dvdx[i3+5] * hourmodx +
-                                                  dvdy[i3+5] * hourmody +
-                                                  dvdz[i3+5] * hourmodz );
-
-         hourgam[6][i1] = gamma[i1][6] -  volinv*(dvdx[i3+6] * hourmodx +
-                                                  dvdy[i3+6] * hourmody +
-                                                  dvdz[i3+6] * hourmodz );
-
-         hourgam[7][i1] = gamma[i1][7] -  volinv*(dvdx[i3+7] * hourmodx +
-                                                  dvdy[i3+7] * hourmody +
-                                                  dvdz[i3+7] * hourmodz );
-
-      }
+      CalcElemHourglassModes(&x8n[i3], &y8n[i3], &z8n[i3],
+                             &dvdx[i3], &dvdy[i3], &dvdz[i3],
+                             volinv, gamma, hourgam) ;
 
       /* compute forces */
       /* store forces into h arrays (force arrays) */
@@ -898,7 +979,14 @@ void CalcFBHourglassForceForElems( Domain &domain,
 
       // With the threaded version, we write into local arrays per elem
       // so we don't have to worry about race conditions
-      if (numthreads > 1) {
+      if (deterministic) {
+         for (Index_t l=0 ; l<8 ; ++l) {
+            fx_elem[i3+l] += hgfx[l] ;
+            fy_elem[i3+l] += hgfy[l] ;
+            fz_elem[i3+l] += hgfz[l] ;
+         }
+      }
+      else if (numthreads > 1) {
          fx_local = &fx_elem[i3] ;
          fx_local[0] = hgfx[0];
          fx_local[1] = hgfx[1];
@@ -963,11 +1051,13 @@ void CalcFBHourglassForceForElems( Domain &domain,
          domain.fz(n7si2) += hgfz[7];
       }
    }
+   ParBarrier() ;
 
-   if (numthreads > 1) {
+   if (!deterministic && numthreads > 1) {
      // Collect the data from the local arrays into the final force arrays
-#pragma omp parallel for firstprivate(numNode)
-      for( Index_t gnode=0 ; gnode<numNode ; ++gnode )
+      Index_t gnodeBegin, gnodeEnd ;
+      ParRange(0, numNode, &gnodeBegin, &gnodeEnd) ;
+      for (Index_t gnode=gnodeBegin ; gnode<gnodeEnd ; ++gnode)
       {
          Index_t count = domain.nodeElemCount(gnode) ;
          Index_t *cornerList = domain.nodeElemCornerList(gnode) ;
@@ -984,9 +1074,13 @@ void CalcFBHourglassForceForElems( Domain &domain,
          domain.fy(gnode) += fy_tmp ;
          domain.fz(gnode) += fz_tmp ;
       }
-      Release(&fz_elem) ;
-      Release(&fy_elem) ;
-      Release(&fx_elem) ;
+      ParBarrier() ;
+      if (ParThreadId() == 0)
+      {
+         Release(&fz_elem) ;
+         Release(&fy_elem) ;
+         Release(&fx_elem) ;
+      }
    }
 }
 
@@ -998,16 +1092,20 @@ void CalcHourglassControlForElems(Domain& domain,
 {
    Index_t numElem = domain.numElem() ;
    Index_t numElem8 = numElem * 8 ;
-   Real_t *dvdx = Allocate<Real_t>(numElem8) ;
-   Real_t *dvdy = Allocate<Real_t>(numElem8) ;
-   Real_t *dvdz = Allocate<Real_t>(numElem8) ;
-   Real_t *x8n  = Allocate<Real_t>(numElem8) ;
-   Real_t *y8n  = Allocate<Real_t>(numElem8) ;
-   Real_t *z8n  = Allocate<Real_t>(numElem8) ;
+   Real_t *dvdx, *dvdy, *dvdz ;
+   Real_t *x8n, *y8n, *z8n ;
+
+   dvdx = ParAllocate<Real_t>(numElem8) ;
+   dvdy = ParAllocate<Real_t>(numElem8) ;
+   dvdz = ParAllocate<Real_t>(numElem8) ;
+   x8n  = ParAllocate<Real_t>(numElem8) ;
+   y8n  = ParAllocate<Real_t>(numElem8) ;
+   z8n  = ParAllocate<Real_t>(numElem8) ;
 
    /* start loop over elements */
-#pragma omp parallel for firstprivate(numElem)
-   for (Index_t i=0 ; i<numElem ; ++i){
+   Index_t iBegin, iEnd ;
+   ParRange(0, numElem, &iBegin, &iEnd) ;
+   for (Index_t i=iBegin ; i<iEnd ; ++i) {
       Real_t  x1[8],  y1[8],  z1[8] ;
       Real_t pfx[8], pfy[8], pfz[8] ;
 
@@ -1039,6 +1137,7 @@ void CalcHourglassControlForElems(Domain& domain,
 #endif
       }
    }
+   ParBarrier() ;
 
    if ( hgcoef > Real_t(0.) ) {
       CalcFBHourglassForceForElems( domain,
@@ -1046,12 +1145,15 @@ void CalcHourglassControlForElems(Domain& domain,
                                     hgcoef, numElem, domain.numNode()) ;
    }
 
-   Release(&z8n) ;
-   Release(&y8n) ;
-   Release(&x8n) ;
-   Release(&dvdz) ;
-   Release(&dvdy) ;
-   Release(&dvdx) ;
+   if (ParThreadId() == 0)
+   {
+      Release(&z8n) ;
+      Release(&y8n) ;
+      Release(&x8n) ;
+      Release(&dvdz) ;
+      Release(&dvdy) ;
+      Release(&dvdx) ;
+   }
 
    return ;
 }
@@ -1064,10 +1166,12 @@ void CalcVolumeForceForElems(Domain& domain)
    Index_t numElem = domain.numElem() ;
    if (numElem != 0) {
       Real_t  hgcoef = domain.hgcoef() ;
-      Real_t *sigxx  = Allocate<Real_t>(numElem) ;
-      Real_t *sigyy  = Allocate<Real_t>(numElem) ;
-      Real_t *sigzz  = Allocate<Real_t>(numElem) ;
-      Real_t *determ = Allocate<Real_t>(numElem) ;
+      Real_t *sigxx, *sigyy, *sigzz, *determ ;
+
+      sigxx  = ParAllocate<Real_t>(numElem) ;
+      sigyy  = ParAllocate<Real_t>(numElem) ;
+      sigzz  = ParAllocate<Real_t>(numElem) ;
+      determ = ParAllocate<Real_t>(numElem) ;
 
       /* Sum contributions to total stress tensor */
       InitStressTermsForElems(domain, sigxx, sigyy, sigzz, numElem);
@@ -1079,8 +1183,9 @@ void CalcVolumeForceForElems(Domain& domain)
                                domain.numNode()) ;
 
       // check for negative element volume
-#pragma omp parallel for firstprivate(numElem)
-      for ( Index_t k=0 ; k<numElem ; ++k ) {
+      Index_t kBegin, kEnd ;
+      ParRange(0, numElem, &kBegin, &kEnd) ;
+      for (Index_t k=kBegin ; k<kEnd ; ++k) {
          if (determ[k] <= Real_t(0.0)) {
 #if USE_MPI            
             MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
@@ -1092,217 +1197,693 @@ void CalcVolumeForceForElems(Domain& domain)
 
       CalcHourglassControlForElems(domain, determ, hgcoef) ;
 
-      Release(&determ) ;
-      Release(&sigzz) ;
-      Release(&sigyy) ;
-      Release(&sigxx) ;
+      if (ParThreadId() == 0)
+      {
+         Release(&determ) ;
+         Release(&sigzz) ;
+         Release(&sigyy) ;
+         Release(&sigxx) ;
+      }
    }
 }
 
 /******************************************/
 
-static inline void CalcForceForNodes(Domain& domain)
+/*
+ * Deterministic mode (-det) node sums.  The contributions of the (up to)
+ * eight elements around a node are put in slots by the node's local
+ * number in each element and added up in slot order, starting from +0.
+ * The result depends neither on the thread count nor on how the mesh
+ * is split between ranks: instead of partial sums, ranks exchange the
+ * slots themselves, and since every slot is filled on exactly one rank
+ * and is zero on the others, the additions in CommSBN are exact.
+ */
+static inline
+void SumCornersToNodes(Domain& domain, const Real_t *corner,
+                       Domain_member dest, Int_t comp)
 {
-  Index_t numNode = domain.numNode() ;
-
-#if USE_MPI  
-  CommRecv(domain, MSG_COMM_SBN, 3,
-           domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
-           true, false) ;
-#endif  
-
-#pragma omp parallel for firstprivate(numNode)
-  for (Index_t i=0; i<numNode; ++i) {
-     domain.fx(i) = Real_t(0.0) ;
-     domain.fy(i) = Real_t(0.0) ;
-     domain.fz(i) = Real_t(0.0) ;
-  }
-
-  /* Calcforce calls partial, force, hourq */
-  CalcVolumeForceForElems(domain) ;
-
-#if USE_MPI  
-  Domain_member fieldData[3] ;
-  fieldData[0] = &Domain::fx ;
-  fieldData[1] = &Domain::fy ;
-  fieldData[2] = &Domain::fz ;
-  
-  CommSend(domain, MSG_COMM_SBN, 3, fieldData,
-           domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() +  1,
-           true, false) ;
-  CommSBN(domain, 3, fieldData) ;
-#endif  
+   Index_t numNode = domain.numNode() ;
+   const bool exchange = (domain.numRanks() > 1) ;
+   Real_t *slot = exchange ? &domain.nodeSlot<0>(comp*8*numNode) : 0 ;
+
+   Index_t gnodeBegin, gnodeEnd ;
+   ParRange(0, numNode, &gnodeBegin, &gnodeEnd) ;
+   for (Index_t gnode=gnodeBegin ; gnode<gnodeEnd ; ++gnode) {
+      Index_t count = domain.nodeElemCount(gnode) ;
+      Index_t *cornerList = domain.nodeElemCornerList(gnode) ;
+      Real_t s[8] ;
+      for (Index_t l=0 ; l<8 ; ++l) {
+         s[l] = Real_t(0.0) ;
+      }
+      for (Index_t i=0 ; i<count ; ++i) {
+         Index_t ielem = cornerList[i] ;
+         s[ielem & 7] = corner[ielem] ;
+      }
+      if (exchange) {
+         for (Index_t l=0 ; l<8 ; ++l) {
+            slot[l*numNode + gnode] = s[l] ;
+         }
+      }
+      else {
+         Real_t sum = Real_t(0.0) ;
+         for (Index_t l=0 ; l<8 ; ++l) {
+            sum += s[l] ;
+         }
+         (domain.*dest)(gnode) = sum ;
+      }
+   }
+   ParBarrier() ;
 }
 
-/******************************************/
+static inline
+void SumNodeSlots(Domain& domain, Domain_member dest, Int_t comp)
+{
+   Index_t numNode = domain.numNode() ;
+   const Real_t *slot = &domain.nodeSlot<0>(comp*8*numNode) ;
+
+   Index_t gnodeBegin, gnodeEnd ;
+   ParRange(0, numNode, &gnodeBegin, &gnodeEnd) ;
+   for (Index_t gnode=gnodeBegin ; gnode<gnodeEnd ; ++gnode) {
+      Real_t sum = Real_t(0.0) ;
+      for (Index_t l=0 ; l<8 ; ++l) {
+         sum += slot[l*numNode + gnode] ;
+      }
+      (domain.*dest)(gnode) = sum ;
+   }
+   ParBarrier() ;
+}
 
+#if USE_MPI
+/* Adds up the slots of the first numComp components across ranks.
+ * Call from the CommThread() threads. */
 static inline
-void CalcAccelerationForNodes(Domain &domain, Index_t numNode)
+void CommNodeSlots(Domain& domain, Int_t numComp)
 {
-   
-#pragma omp parallel for firstprivate(numNode)
-   for (Index_t i = 0; i < numNode; ++i) {
-      domain.xdd(i) = domain.fx(i) / domain.nodalMass(i);
-      domain.ydd(i) = domain.fy(i) / domain.nodalMass(i);
-      domain.zdd(i) = domain.fz(i) / domain.nodalMass(i);
+   static Domain_member const slotField[NODE_SLOTS] = {
+      &Domain::nodeSlot<0>, &Domain::nodeSlot<1>, &Domain::nodeSlot<2>, &Domain::nodeSlot<3>,
+      &Domain::nodeSlot<4>, &Domain::nodeSlot<5>, &Domain::nodeSlot<6>, &Domain::nodeSlot<7>,
+      &Domain::nodeSlot<8>, &Domain::nodeSlot<9>, &Domain::nodeSlot<10>, &Domain::nodeSlot<11>,
+      &Domain::nodeSlot<12>, &Domain::nodeSlot<13>, &Domain::nodeSlot<14>, &Domain::nodeSlot<15>,
+      &Domain::nodeSlot<16>, &Domain::nodeSlot<17>, &Domain::nodeSlot<18>, &Domain::nodeSlot<19>,
+      &Domain::nodeSlot<20>, &Domain::nodeSlot<21>, &Domain::nodeSlot<22>, &Domain::nodeSlot<23>
+   } ;
+   Int_t numSlot = 8*numComp ;
+
+   for (Int_t s0=0 ; s0<numSlot ; s0+=MAX_FIELDS_PER_MPI_COMM) {
+      Domain_member fieldData[MAX_FIELDS_PER_MPI_COMM] ;
+      Int_t xferFields = std::min(Int_t(MAX_FIELDS_PER_MPI_COMM), numSlot - s0) ;
+      for (Int_t fi=0 ; fi<xferFields ; ++fi) {
+         fieldData[fi] = slotField[s0 + fi] ;
+      }
+      CommRecv(domain, MSG_COMM_SBN, xferFields,
+               domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+               true, false) ;
+      CommSend(domain, MSG_COMM_SBN, xferFields, fieldData,
+               domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+               true, false) ;
+      CommSBN(domain, xferFields, fieldData) ;
    }
 }
+#endif
 
 /******************************************/
 
-static inline
-void ApplyAccelerationBoundaryConditionsForNodes(Domain& domain)
+/* Deterministic-mode replacement for the nodal mass sum of the Domain
+ * constructor (and its CommSBN) */
+static void CalcNodalMassForNodesBody(void *arg)
 {
-   Index_t size = domain.sizeX();
-   Index_t numNodeBC = (size+1)*(size+1) ;
+   Domain &domain = *static_cast<Domain *>(arg) ;
+   Index_t numElem = domain.numElem() ;
+   Real_t *corner = ParAllocate<Real_t>(8*numElem) ;
 
-#pragma omp parallel
-   {
-      if (!domain.symmXempty() != 0) {
-#pragma omp for nowait firstprivate(numNodeBC)
-         for(Index_t i=0 ; i<numNodeBC ; ++i)
-            domain.xdd(domain.symmX(i)) = Real_t(0.0) ;
+   Index_t iBegin, iEnd ;
+   ParRange(0, numElem, &iBegin, &iEnd) ;
+   for (Index_t i=iBegin ; i<iEnd ; ++i) {
+      for (Index_t l=0 ; l<8 ; ++l) {
+         corner[8*i + l] = domain.volo(i) / Real_t(8.0) ;
       }
+   }
+   ParBarrier() ;
 
-      if (!domain.symmYempty() != 0) {
-#pragma omp for nowait firstprivate(numNodeBC)
-         for(Index_t i=0 ; i<numNodeBC ; ++i)
-            domain.ydd(domain.symmY(i)) = Real_t(0.0) ;
+   SumCornersToNodes(domain, corner, &Domain::nodalMass, 0) ;
+#if USE_MPI
+   if (domain.numRanks() > 1) {
+      if (CommThread(domain)) {
+         CommNodeSlots(domain, 1) ;
       }
+      ParBarrier() ;
+      SumNodeSlots(domain, &Domain::nodalMass, 0) ;
+   }
+#endif
 
-      if (!domain.symmZempty() != 0) {
-#pragma omp for nowait firstprivate(numNodeBC)
-         for(Index_t i=0 ; i<numNodeBC ; ++i)
-            domain.zdd(domain.symmZ(i)) = Real_t(0.0) ;
-      }
+   if (ParThreadId() == 0) {
+      Release(&corner) ;
    }
 }
 
-/******************************************/
-
 static inline
-void CalcVelocityForNodes(Domain &domain, const Real_t dt, const Real_t u_cut,
-                          Index_t numNode)
+void CalcNodalMassForNodes(Domain& domain)
 {
+   ParRun(CalcNodalMassForNodesBody, &domain) ;
+}
 
-#pragma omp parallel for firstprivate(numNode)
-   for ( Index_t i = 0 ; i < numNode ; ++i )
-   {
-     Real_t xdtmp, ydtmp, zdtmp ;
-
-     xdtmp = domain.xd(i) + domain.xdd(i) * dt ;
-     if( FABS(xdtmp) < u_cut ) xdtmp = Real_t(0.0);
-     domain.xd(i) = xdtmp ;
-
-     ydtmp = domain.yd(i) + domain.ydd(i) * dt ;
-     if( FABS(ydtmp) < u_cut ) ydtmp = Real_t(0.0);
-     domain.yd(i) = ydtmp ;
+/******************************************/
 
-     zdtmp = domain.zd(i) + domain.zdd(i) * dt ;
-     if( FABS(zdtmp) < u_cut ) zdtmp = Real_t(0.0);
-     domain.zd(i) = zdtmp ;
+/*
+ * Boundary/interior split (-overlap).  Only nodes on the faces of the
+ * local node block are exchanged, and only the shell of elements
+ * touching a face contributes to them.  The forces of the shell
+ * elements are computed first and summed to the face nodes, the
+ * MSG_COMM_SBN sends are started, and the interior elements and nodes
+ * are done while the messages are in flight; the node update and the
+ * position/velocity sync are split the same way, and so is the
+ * monotonic q: the shell gradients are sent while the interior
+ * gradients and limiter run.  Element forces go
+ * to per-corner arrays and are summed per node in corner list order,
+ * as in the threaded path, so results are those of a threaded run for
+ * any thread count.
+ */
+static void BuildHaloSplit(Domain& domain)
+{
+   HaloSplit_t &split = domain.haloSplit() ;
+   Index_t edgeElems = domain.sizeX() ;
+   Index_t edgeNodes = edgeElems + 1 ;
+
+   for (Index_t plane=0 ; plane<edgeElems ; ++plane) {
+      for (Index_t row=0 ; row<edgeElems ; ++row) {
+         for (Index_t col=0 ; col<edgeElems ; ++col) {
+            Index_t k = (plane*edgeElems + row)*edgeElems + col ;
+            bool shell = (plane == 0 || plane == edgeElems-1 ||
+                          row == 0 || row == edgeElems-1 ||
+                          col == 0 || col == edgeElems-1) ;
+            (shell ? split.shellElem : split.interiorElem).push_back(k) ;
+         }
+      }
+   }
+   for (Index_t plane=0 ; plane<edgeNodes ; ++plane) {
+      for (Index_t row=0 ; row<edgeNodes ; ++row) {
+         for (Index_t col=0 ; col<edgeNodes ; ++col) {
+            Index_t i = (plane*edgeNodes + row)*edgeNodes + col ;
+            bool face = (plane == 0 || plane == edgeNodes-1 ||
+                         row == 0 || row == edgeNodes-1 ||
+                         col == 0 || col == edgeNodes-1) ;
+            (face ? split.faceNode : split.interiorNode).push_back(i) ;
+         }
+      }
    }
 }
 
-/******************************************/
+static inline bool HaloOverlap(Domain& domain)
+{
+   return (domain.haloOverlap() != 0) && (domain.numRanks() > 1) &&
+          !domain.deterministic() ;
+}
 
+/* Stress force of element k on its corners, as in
+ * IntegrateStressForElems */
 static inline
-void CalcPositionForNodes(Domain &domain, const Real_t dt, Index_t numNode)
+void IntegrateStressForElem(Domain& domain, Index_t k,
+                            Real_t *fx, Real_t *fy, Real_t *fz)
 {
-#pragma omp parallel for firstprivate(numNode)
-   for ( Index_t i = 0 ; i < numNode ; ++i )
-   {
-     domain.x(i) += domain.xd(i) * dt ;
-     domain.y(i) += domain.yd(i) * dt ;
-     domain.z(i) += domain.zd(i) * dt ;
+   const Index_t* const elemToNode = domain.nodelist(k);
+   Real_t B[3][8] ;
+   Real_t x_local[8] ;
+   Real_t y_local[8] ;
+   Real_t z_local[8] ;
+   Real_t determ ;
+   Real_t sig = - domain.p(k) - domain.q(k) ;
+
+   CollectDomainNodesToElemNodes(domain, elemToNode, x_local, y_local, z_local);
+   CalcElemShapeFunctionDerivatives(x_local, y_local, z_local, B, &determ);
+   CalcElemNodeNormals(B[0], B[1], B[2], x_local, y_local, z_local);
+   SumElemStressesToNodeForces(B, sig, sig, sig, fx, fy, fz) ;
+
+   if (determ <= Real_t(0.0)) {
+#if USE_MPI            
+      MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+      exit(VolumeError);
+#endif
    }
 }
 
-/******************************************/
-
+/* Hourglass force of element i on its corners, as in
+ * CalcHourglassControlForElems and CalcFBHourglassForceForElems */
 static inline
-void LagrangeNodal(Domain& domain)
+void CalcHourglassForceForElem(Domain& domain, Index_t i, Real_t hourg,
+                               const Real_t gamma[4][8],
+                               Real_t *fx, Real_t *fy, Real_t *fz)
 {
-#ifdef SEDOV_SYNC_POS_VEL_EARLY
-   Domain_member fieldData[6] ;
+   const Index_t *elemToNode = domain.nodelist(i);
+   Real_t x1[8], y1[8], z1[8] ;
+   Real_t pfx[8], pfy[8], pfz[8] ;
+   Real_t hourgam[8][4] ;
+   Real_t xd1[8], yd1[8], zd1[8] ;
+
+   CollectDomainNodesToElemNodes(domain, elemToNode, x1, y1, z1);
+   CalcElemVolumeDerivative(pfx, pfy, pfz, x1, y1, z1);
+
+   Real_t determ = domain.volo(i) * domain.v(i) ;
+   if (domain.v(i) <= Real_t(0.0)) {
+#if USE_MPI         
+      MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+      exit(VolumeError);
 #endif
+   }
+   if (hourg <= Real_t(0.)) {
+      return ;
+   }
 
-   const Real_t delt = domain.deltatime() ;
-   Real_t u_cut = domain.u_cut() ;
+   Real_t volinv = Real_t(1.0)/determ ;
+   CalcElemHourglassModes(x1, y1, z1, pfx, pfy, pfz, volinv, gamma, hourgam) ;
 
-  /* time of boundary condition evaluation is beginning of step for force and
-   * acceleration boundary conditions. */
-  CalcForceForNodes(domain);
+   for (Index_t l=0 ; l<8 ; ++l) {
+      xd1[l] = domain.xd(elemToNode[l]) ;
+      yd1[l] = domain.yd(elemToNode[l]) ;
+      zd1[l] = domain.zd(elemToNode[l]) ;
+   }
 
-#if USE_MPI  
-#ifdef SEDOV_SYNC_POS_VEL_EARLY
-   CommRecv(domain, MSG_SYNC_POS_VEL, 6,
-            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
-            false, false) ;
-#endif
-#endif
-   
-   CalcAccelerationForNodes(domain, domain.numNode());
-   
-   ApplyAccelerationBoundaryConditionsForNodes(domain);
+   Real_t coefficient = - hourg * Real_t(0.01) * domain.ss(i) *
+                        domain.elemMass(i) / CBRT(determ) ;
 
-   CalcVelocityForNodes( domain, delt, u_cut, domain.numNode()) ;
+   CalcElemFBHourglassForce(xd1, yd1, zd1, hourgam, coefficient, fx, fy, fz) ;
+}
 
-   CalcPositionForNodes( domain, delt, domain.numNode() );
 #if USE_MPI
-#ifdef SEDOV_SYNC_POS_VEL_EARLY
-  fieldData[0] = &Domain::x ;
-  fieldData[1] = &Domain::y ;
-  fieldData[2] = &Domain::z ;
-  fieldData[3] = &Domain::xd ;
-  fieldData[4] = &Domain::yd ;
-  fieldData[5] = &Domain::zd ;
-
-   CommSend(domain, MSG_SYNC_POS_VEL, 6, fieldData,
-            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
-            false, false) ;
-   CommSyncPosVel(domain) ;
-#endif
-#endif
-   
-  return;
+/* Corner forces of the listed elements: stress forces to corner[0..2],
+ * hourglass forces to corner[3..5] */
+static void CalcElemForcesForList(Domain& domain, const std::vector<Index_t>& elems,
+                                  const Real_t gamma[4][8], Real_t *corner[6])
+{
+   Real_t hgcoef = domain.hgcoef() ;
+   Index_t nBegin, nEnd ;
+   ParRange(0, Index_t(elems.size()), &nBegin, &nEnd) ;
+   for (Index_t n=nBegin ; n<nEnd ; ++n) {
+      Index_t k = elems[n] ;
+      IntegrateStressForElem(domain, k, &corner[0][8*k], &corner[1][8*k],
+                             &corner[2][8*k]) ;
+      CalcHourglassForceForElem(domain, k, hgcoef, gamma, &corner[3][8*k],
+                                &corner[4][8*k], &corner[5][8*k]) ;
+   }
+   ParBarrier() ;
 }
 
-/******************************************/
+/* Forces of the listed nodes from the corner arrays: the stress sum,
+ * then the hourglass sum added, in corner list order */
+static void SumCornerForcesForList(Domain& domain, const std::vector<Index_t>& nodes,
+                                   Real_t *corner[6])
+{
+   const bool hourglass = (domain.hgcoef() > Real_t(0.)) ;
+   Index_t nBegin, nEnd ;
+   ParRange(0, Index_t(nodes.size()), &nBegin, &nEnd) ;
+   for (Index_t n=nBegin ; n<nEnd ; ++n) {
+      Index_t gnode = nodes[n] ;
+      Index_t count = domain.nodeElemCount(gnode) ;
+      Index_t *cornerList = domain.nodeElemCornerList(gnode) ;
+      Real_t f[6] = { Real_t(0.0), Real_t(0.0), Real_t(0.0),
+                      Real_t(0.0), Real_t(0.0), Real_t(0.0) } ;
+      for (Index_t i=0 ; i < count ; ++i) {
+         Index_t ielem = cornerList[i] ;
+         for (Int_t c=0 ; c<6 ; ++c) {
+            f[c] += corner[c][ielem] ;
+         }
+      }
+      domain.fx(gnode) = f[0] ;
+      domain.fy(gnode) = f[1] ;
+      domain.fz(gnode) = f[2] ;
+      if (hourglass) {
+         domain.fx(gnode) += f[3] ;
+         domain.fy(gnode) += f[4] ;
+         domain.fz(gnode) += f[5] ;
+      }
+   }
+   ParBarrier() ;
+}
 
-static inline
-Real_t CalcElemVolume( const Real_t x0, const Real_t x1,
-               const Real_t x2, const Real_t x3,
-               const Real_t x4, const Real_t x5,
-               const Real_t x6, const Real_t x7,
-               const Real_t y0, const Real_t y1,
-               const Real_t y2, const Real_t y3,
-               const Real_t y4, const Real_t y5,
-               const Real_t y6, const Real_t y7,
-               const Real_t z0, const Real_t z1,
-               const Real_t z2, const Real_t z3,
-               const Real_t z4, const Real_t z5,
-               const Real_t z6, const Real_t z7 )
+static void CalcForceForNodesOverlapped(Domain& domain)
 {
-  Real_t twelveth = Real_t(1.0)/Real_t(12.0);
+   HaloSplit_t &split = domain.haloSplit() ;
+   Index_t numElem8 = 8*domain.numElem() ;
+   Real_t gamma[4][8] ;
+   Real_t *corner[6] ;
+   Domain_member fieldData[3] ;
+
+   fieldData[0] = &Domain::fx ;
+   fieldData[1] = &Domain::fy ;
+   fieldData[2] = &Domain::fz ;
+
+   SetHourglassGamma(gamma) ;
+
+   if (CommThread(domain)) {
+      CommRecv(domain, MSG_COMM_SBN, 3,
+               domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+               true, false) ;
+   }
 
-  Real_t dx61 = x6 - x1;
-  Real_t dy61 = y6 - y1;
-  Real_t dz61 = z6 - z1;
+   for (Int_t c=0 ; c<6 ; ++c) {
+      corner[c] = ParAllocate<Real_t>(numElem8) ;
+   }
 
-  Real_t dx70 = x7 - x0;
-  Real_t dy70 = y7 - y0;
-  Real_t dz70 = z7 - z0;
+   // boundary first, then start the exchange of the face nodes
+   CalcElemForcesForList(domain, split.shellElem, gamma, corner) ;
+   SumCornerForcesForList(domain, split.faceNode, corner) ;
+   if (CommThread(domain)) {
+      CommSendStart(domain, MSG_COMM_SBN, 3, fieldData,
+                    domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+                    true, false) ;
+   }
 
-  Real_t dx63 = x6 - x3;
-  Real_t dy63 = y6 - y3;
-  Real_t dz63 = z6 - z3;
+   // interior while the messages are in flight
+   CalcElemForcesForList(domain, split.interiorElem, gamma, corner) ;
+   SumCornerForcesForList(domain, split.interiorNode, corner) ;
 
-  Real_t dx20 = x2 - x0;
-  Real_t dy20 = y2 - y0;
-  Real_t dz20 = z2 - z0;
+   if (CommThread(domain)) {
+      CommSBN(domain, 3, fieldData) ;
+      CommSendFinish(domain) ;
+   }
+   ParBarrier() ;
 
-  Real_t dx50 = x5 - x0;
+   if (ParThreadId() == 0) {
+      for (Int_t c=5 ; c>=0 ; --c) {
+         Release(&corner[c]) ;
+      }
+   }
+}
+#endif
+
+/******************************************/
+
+static inline void CalcForceForNodes(Domain& domain)
+{
+  Index_t numNode = domain.numNode() ;
+
+  if (domain.deterministic()) {
+     CalcVolumeForceForElems(domain) ;
+
+     SumCornersToNodes(domain, &domain.fxCorner(0), &Domain::fx, 0) ;
+     SumCornersToNodes(domain, &domain.fyCorner(0), &Domain::fy, 1) ;
+     SumCornersToNodes(domain, &domain.fzCorner(0), &Domain::fz, 2) ;
+#if USE_MPI
+     if (domain.numRanks() > 1) {
+        if (CommThread(domain)) {
+           CommNodeSlots(domain, 3) ;
+        }
+        ParBarrier() ;
+
+        SumNodeSlots(domain, &Domain::fx, 0) ;
+        SumNodeSlots(domain, &Domain::fy, 1) ;
+        SumNodeSlots(domain, &Domain::fz, 2) ;
+     }
+#endif
+     return ;
+  }
+
+#if USE_MPI  
+  if (HaloOverlap(domain)) {
+     CalcForceForNodesOverlapped(domain) ;
+     return ;
+  }
+
+  if (CommThread(domain)) {
+     CommRecv(domain, MSG_COMM_SBN, 3,
+              domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+              true, false) ;
+  }
+#endif  
+
+  Index_t iBegin, iEnd ;
+  ParRange(0, numNode, &iBegin, &iEnd) ;
+  for (Index_t i=iBegin ; i<iEnd ; ++i) {
+     domain.fx(i) = Real_t(0.0) ;
+     domain.fy(i) = Real_t(0.0) ;
+     domain.fz(i) = Real_t(0.0) ;
+  }
+  ParBarrier() ;
+
+  /* Calcforce calls partial, force, hourq */
+  CalcVolumeForceForElems(domain) ;
+
+#if USE_MPI  
+  Domain_member fieldData[3] ;
+  fieldData[0] = &Domain::fx ;
+  fieldData[1] = &Domain::fy ;
+  fieldData[2] = &Domain::fz ;
+  
+  // all threads have finished accumulating into the force arrays
+  ParBarrier() ;
+  if (CommThread(domain))
+  {
+     CommSend(domain, MSG_COMM_SBN, 3, fieldData,
+              domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() +  1,
+              true, false) ;
+     CommSBN(domain, 3, fieldData) ;
+  }
+  ParBarrier() ;
+#endif  
+}
+
+/******************************************/
+
+/*
+ * Nodal update in a single sweep: acceleration from the nodal force,
+ * symmetry plane constraints (via the per-node mask), velocity and
+ * position.  Accelerations only live in registers.  With -hs the
+ * half-step coordinates used by the kinematics are emitted as well.
+ */
+static inline
+void CalcNodalUpdateForNode(Domain &domain, Index_t i, const Real_t dt,
+                            const Real_t dt2, const Real_t u_cut,
+                            const bool emitHalfStep)
+{
+   Real_t xddtmp, yddtmp, zddtmp ;
+   Real_t xdtmp, ydtmp, zdtmp ;
+   Int_t symm = domain.nodeSymm(i) ;
+   Real_t nodalMass = domain.nodalMass(i) ;
+
+   xddtmp = (symm & SYMM_X) ? Real_t(0.0) : domain.fx(i) / nodalMass ;
+   yddtmp = (symm & SYMM_Y) ? Real_t(0.0) : domain.fy(i) / nodalMass ;
+   zddtmp = (symm & SYMM_Z) ? Real_t(0.0) : domain.fz(i) / nodalMass ;
+
+   xdtmp = domain.xd(i) + xddtmp * dt ;
+   if( FABS(xdtmp) < u_cut ) xdtmp = Real_t(0.0);
+   domain.xd(i) = xdtmp ;
+
+   ydtmp = domain.yd(i) + yddtmp * dt ;
+   if( FABS(ydtmp) < u_cut ) ydtmp = Real_t(0.0);
+   domain.yd(i) = ydtmp ;
+
+   zdtmp = domain.zd(i) + zddtmp * dt ;
+   if( FABS(zdtmp) < u_cut ) zdtmp = Real_t(0.0);
+   domain.zd(i) = zdtmp ;
+
+   Real_t xtmp = domain.x(i) + xdtmp * dt ;
+   Real_t ytmp = domain.y(i) + ydtmp * dt ;
+   Real_t ztmp = domain.z(i) + zdtmp * dt ;
+   domain.x(i) = xtmp ;
+   domain.y(i) = ytmp ;
+   domain.z(i) = ztmp ;
+
+   if (emitHalfStep) {
+      domain.xh(i) = xtmp - dt2 * xdtmp ;
+      domain.yh(i) = ytmp - dt2 * ydtmp ;
+      domain.zh(i) = ztmp - dt2 * zdtmp ;
+   }
+}
+
+static inline
+void CalcNodalUpdateForNodes(Domain &domain, const Real_t dt,
+                             const Real_t u_cut, Index_t numNode)
+{
+   const bool emitHalfStep = (domain.halfStepCoords() != 0) ;
+   Real_t dt2 = Real_t(0.5) * dt ;
+
+   Index_t iBegin, iEnd ;
+   ParRange(0, numNode, &iBegin, &iEnd) ;
+   for (Index_t i=iBegin ; i<iEnd ; ++i)
+   {
+      CalcNodalUpdateForNode(domain, i, dt, dt2, u_cut, emitHalfStep) ;
+   }
+   ParBarrier() ;
+}
+
+/* CalcNodalUpdateForNodes for a list of nodes (-overlap) */
+static inline
+void CalcNodalUpdateForList(Domain &domain, const Real_t dt,
+                            const Real_t u_cut, const std::vector<Index_t>& nodes)
+{
+   const bool emitHalfStep = (domain.halfStepCoords() != 0) ;
+   Real_t dt2 = Real_t(0.5) * dt ;
+
+   Index_t nBegin, nEnd ;
+   ParRange(0, Index_t(nodes.size()), &nBegin, &nEnd) ;
+   for (Index_t n=nBegin ; n<nEnd ; ++n)
+   {
+      CalcNodalUpdateForNode(domain, nodes[n], dt, dt2, u_cut, emitHalfStep) ;
+   }
+   ParBarrier() ;
+}
+
+/******************************************/
+
+#if USE_MPI
+#ifdef SEDOV_SYNC_POS_VEL_EARLY
+/* CommSyncPosVel overwrites positions and velocities on the faces of
+ * the local node block with the neighbors' values, so the half-step
+ * coordinates (-hs) are formed again on the six faces, with the same
+ * expression as in CalcNodalUpdateForNode. */
+static inline
+void CalcHalfStepPositionForSurfaceNodes(Domain &domain, const Real_t dt)
+{
+   Index_t dx = domain.sizeX() + 1 ;
+   Index_t dy = domain.sizeY() + 1 ;
+   Index_t dz = domain.sizeZ() + 1 ;
+   Real_t dt2 = Real_t(0.5) * dt ;
+
+   Index_t planeBegin, planeEnd ;
+   ParRange(0, dz, &planeBegin, &planeEnd) ;
+   for (Index_t plane=planeBegin ; plane<planeEnd ; ++plane)
+   {
+      bool planeFace = (plane == 0 || plane == dz - 1) ;
+      for (Index_t row=0 ; row<dy ; ++row)
+      {
+         bool rowFace = (row == 0 || row == dy - 1) ;
+         // interior rows only have their two end nodes on a face
+         Index_t stride = (planeFace || rowFace) ? 1 : std::max(dx - 1, Index_t(1)) ;
+         for (Index_t col=0 ; col<dx ; col += stride)
+         {
+            Index_t i = (plane*dy + row)*dx + col ;
+            Real_t xdtmp = domain.xd(i) ;
+            Real_t ydtmp = domain.yd(i) ;
+            Real_t zdtmp = domain.zd(i) ;
+            domain.xh(i) = domain.x(i) - dt2 * xdtmp ;
+            domain.yh(i) = domain.y(i) - dt2 * ydtmp ;
+            domain.zh(i) = domain.z(i) - dt2 * zdtmp ;
+         }
+      }
+   }
+   ParBarrier() ;
+}
+#endif
+#endif
+
+/******************************************/
+
+static inline
+void LagrangeNodal(Domain& domain)
+{
+#ifdef SEDOV_SYNC_POS_VEL_EARLY
+   Domain_member fieldData[6] ;
+#endif
+
+   Real_t u_cut = domain.u_cut() ;
+
+  /* time of boundary condition evaluation is beginning of step for force and
+   * acceleration boundary conditions. */
+  CalcForceForNodes(domain);
+
+  /* the forces do not depend on the time step, whose reduction has been
+   * in flight since the end of the last cycle */
+  if (ParThreadId() == 0) {
+     TimeIncrement(domain) ;
+  }
+  ParBarrier() ;
+
+   const Real_t delt = domain.deltatime() ;
+
+#if USE_MPI  
+#ifdef SEDOV_SYNC_POS_VEL_EARLY
+   if (CommThread(domain)) {
+      CommRecv(domain, MSG_SYNC_POS_VEL, 6,
+               domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+               false, false) ;
+   }
+#endif
+#endif
+   
+#if USE_MPI
+#ifdef SEDOV_SYNC_POS_VEL_EARLY
+  fieldData[0] = &Domain::x ;
+  fieldData[1] = &Domain::y ;
+  fieldData[2] = &Domain::z ;
+  fieldData[3] = &Domain::xd ;
+  fieldData[4] = &Domain::yd ;
+  fieldData[5] = &Domain::zd ;
+
+   if (HaloOverlap(domain)) {
+      // face nodes first, interior nodes while they are sent
+      CalcNodalUpdateForList(domain, delt, u_cut, domain.haloSplit().faceNode) ;
+      if (CommThread(domain)) {
+         CommSendStart(domain, MSG_SYNC_POS_VEL, 6, fieldData,
+                       domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+                       false, false) ;
+      }
+      CalcNodalUpdateForList(domain, delt, u_cut, domain.haloSplit().interiorNode) ;
+      if (CommThread(domain)) {
+         CommSyncPosVel(domain) ;
+         CommSendFinish(domain) ;
+      }
+   }
+   else {
+      CalcNodalUpdateForNodes( domain, delt, u_cut, domain.numNode() ) ;
+      if (CommThread(domain))
+      {
+         CommSend(domain, MSG_SYNC_POS_VEL, 6, fieldData,
+                  domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+                  false, false) ;
+         CommSyncPosVel(domain) ;
+      }
+   }
+   ParBarrier() ;
+
+   if (domain.halfStepCoords()) {
+      CalcHalfStepPositionForSurfaceNodes(domain, delt) ;
+   }
+#else
+   CalcNodalUpdateForNodes( domain, delt, u_cut, domain.numNode() ) ;
+#endif
+#else
+   CalcNodalUpdateForNodes( domain, delt, u_cut, domain.numNode() ) ;
+#endif
+   
+  return;
+}
+
+/******************************************/
+
+static inline
+Real_t CalcElemVolume( const Real_t x0, const Real_t x1,
+               const Real_t x2, const Real_t x3,
+               const Real_t x4, const Real_t x5,
+               const Real_t x6, const Real_t x7,
+               const Real_t y0, const Real_t y1,
+               const Real_t y2, const Real_t y3,
+               const Real_t y4, const Real_t y5,
+               const Real_t y6, const Real_t y7,
+               const Real_t z0, const Real_t z1,
+               const Real_t z2, const Real_t z3,
+               const Real_t z4, const Real_t z5,
+               const Real_t z6, const Real_t z7 )
+{
+  Real_t twelveth = Real_t(1.0)/Real_t(12.0);
+
+  Real_t dx61 = x6 - x1;
+  Real_t dy61 = y6 - y1;
+  Real_t dz61 = z6 - z1;
+
+  Real_t dx70 = x7 - x0;
+  Real_t dy70 = y7 - y0;
+  Real_t dz70 = z7 - z0;
+
+  Real_t dx63 = x6 - x3;
+  Real_t dy63 = y6 - y3;
+  Real_t dz63 = z6 - z3;
+
+  Real_t dx20 = x2 - x0;
+  Real_t dy20 = y2 - y0;
+  Real_t dz20 = z2 - z0;
+
+  Real_t dx50 = x5 - x0;
   Real_t dy50 = y5 - y0;
   Real_t dz50 = z5 - z0;
 
@@ -1391,180 +1972,313 @@ Real_t AreaFace( const Real_t x0, const Real_t x1,
 
 /******************************************/
 
+/*
+ * Batched (structure-of-arrays) versions of the element geometry
+ * routines.  Corner data for KIN_BATCH_SIZE elements is stored as
+ * x[corner][lane], so the loops below run across elements and can be
+ * vectorized.  Each lane evaluates exactly the same expressions as the
+ * element-at-a-time code (CalcElemVolume, AreaFace,
+ * CalcElemShapeFunctionDerivatives), so results are bitwise identical
+ * to it as long as the compiler is not allowed to contract or
+ * reassociate floating point operations: no -ffast-math, and
+ * -ffp-contract=off, which the CMake and Makefile builds set.
+ */
+
 static inline
-Real_t CalcElemCharacteristicLength( const Real_t x[8],
-                                     const Real_t y[8],
-                                     const Real_t z[8],
-                                     const Real_t volume)
+void CalcElemVolumeBatch( const Real_t x[8][KIN_BATCH_SIZE],
+                          const Real_t y[8][KIN_BATCH_SIZE],
+                          const Real_t z[8][KIN_BATCH_SIZE],
+                          Real_t volume[KIN_BATCH_SIZE], Index_t len )
 {
-   Real_t a, charLength = Real_t(0.0);
-
-   a = AreaFace(x[0],x[1],x[2],x[3],
-                y[0],y[1],y[2],y[3],
-                z[0],z[1],z[2],z[3]) ;
-   charLength = std::max(a,charLength) ;
-
-   a = AreaFace(x[4],x[5],x[6],x[7],
-                y[4],y[5],y[6],y[7],
-                z[4],z[5],z[6],z[7]) ;
-   charLength = std::max(a,charLength) ;
-
-   a = AreaFace(x[0],x[1],x[5],x[4],
-                y[0],y[1],y[5],y[4],
-                z[0],z[1],z[5],z[4]) ;
-   charLength = std::max(a,charLength) ;
-
-   a = AreaFace(x[1],x[2],x[6],x[5],
-                y[1],y[2],y[6],y[5],
-                z[1],z[2],z[6],z[5]) ;
-   charLength = std::max(a,charLength) ;
-
-   a = AreaFace(x[2],x[3],x[7],x[6],
-                y[2],y[3],y[7],y[6],
-                z[2],z[3],z[7],z[6]) ;
-   charLength = std::max(a,charLength) ;
-
-   a = AreaFace(x[3],x[0],x[4],x[7],
-                y[3],y[0],y[4],y[7],
-                z[3],z[0],z[4],z[7]) ;
-   charLength = std::max(a,charLength) ;
+#pragma omp simd
+   for (Index_t l = 0 ; l < len ; ++l) {
+      volume[l] = CalcElemVolume(x[0][l], x[1][l], x[2][l], x[3][l],
+                                 x[4][l], x[5][l], x[6][l], x[7][l],
+                                 y[0][l], y[1][l], y[2][l], y[3][l],
+                                 y[4][l], y[5][l], y[6][l], y[7][l],
+                                 z[0][l], z[1][l], z[2][l], z[3][l],
+                                 z[4][l], z[5][l], z[6][l], z[7][l]) ;
+   }
+}
 
-   charLength = Real_t(4.0) * volume / SQRT(charLength);
+/******************************************/
 
-   return charLength;
+static inline
+void CalcElemCharacteristicLengthBatch( const Real_t x[8][KIN_BATCH_SIZE],
+                                        const Real_t y[8][KIN_BATCH_SIZE],
+                                        const Real_t z[8][KIN_BATCH_SIZE],
+                                        const Real_t volume[KIN_BATCH_SIZE],
+                                        Real_t *arealg, Index_t len )
+{
+#pragma omp simd
+   for (Index_t l = 0 ; l < len ; ++l) {
+      Real_t a, charLength = Real_t(0.0);
+
+      a = AreaFace(x[0][l],x[1][l],x[2][l],x[3][l],
+                   y[0][l],y[1][l],y[2][l],y[3][l],
+                   z[0][l],z[1][l],z[2][l],z[3][l]) ;
+      charLength = std::max(a,charLength) ;
+
+      a = AreaFace(x[4][l],x[5][l],x[6][l],x[7][l],
+                   y[4][l],y[5][l],y[6][l],y[7][l],
+                   z[4][l],z[5][l],z[6][l],z[7][l]) ;
+      charLength = std::max(a,charLength) ;
+
+      a = AreaFace(x[0][l],x[1][l],x[5][l],x[4][l],
+                   y[0][l],y[1][l],y[5][l],y[4][l],
+                   z[0][l],z[1][l],z[5][l],z[4][l]) ;
+      charLength = std::max(a,charLength) ;
+
+      a = AreaFace(x[1][l],x[2][l],x[6][l],x[5][l],
+                   y[1][l],y[2][l],y[6][l],y[5][l],
+                   z[1][l],z[2][l],z[6][l],z[5][l]) ;
+      charLength = std::max(a,charLength) ;
+
+      a = AreaFace(x[2][l],x[3][l],x[7][l],x[6][l],
+                   y[2][l],y[3][l],y[7][l],y[6][l],
+                   z[2][l],z[3][l],z[7][l],z[6][l]) ;
+      charLength = std::max(a,charLength) ;
+
+      a = AreaFace(x[3][l],x[0][l],x[4][l],x[7][l],
+                   y[3][l],y[0][l],y[4][l],y[7][l],
+                   z[3][l],z[0][l],z[4][l],z[7][l]) ;
+      charLength = std::max(a,charLength) ;
+
+      arealg[l] = FASTDIVSQRT(Real_t(4.0) * volume[l], charLength);
+   }
 }
 
 /******************************************/
 
+/* Only the diagonal of the velocity gradient is needed by the
+ * kinematics, so the shape function derivatives (b[0..2][0..3], the
+ * other four corners follow by symmetry) and D[0..2] are formed in
+ * place, lane by lane. */
 static inline
-void CalcElemVelocityGradient( const Real_t* const xvel,
-                                const Real_t* const yvel,
-                                const Real_t* const zvel,
-                                const Real_t b[][8],
-                                const Real_t detJ,
-                                Real_t* const d )
-{
-  const Real_t inv_detJ = Real_t(1.0) / detJ ;
-  Real_t dyddx, dxddy, dzddx, dxddz, dzddy, dyddz;
-  const Real_t* const pfx = b[0];
-  const Real_t* const pfy = b[1];
-  const Real_t* const pfz = b[2];
-
-  d[0] = inv_detJ * ( pfx[0] * (xvel[0]-xvel[6])
-                     + pfx[1] * (xvel[1]-xvel[7])
-                     + pfx[2] * (xvel[2]-xvel[4])
-                     + pfx[3] * (xvel[3]-xvel[5]) );
-
-  d[1] = inv_detJ * ( pfy[0] * (yvel[0]-yvel[6])
-                     + pfy[1] * (yvel[1]-yvel[7])
-                     + pfy[2] * (yvel[2]-yvel[4])
-                     + pfy[3] * (yvel[3]-yvel[5]) );
-
-  d[2] = inv_detJ * ( pfz[0] * (zvel[0]-zvel[6])
-                     + pfz[1] * (zvel[1]-zvel[7])
-                     + pfz[2] * (zvel[2]-zvel[4])
-                     + pfz[3] * (zvel[3]-zvel[5]) );
-
-  dyddx  = inv_detJ * ( pfx[0] * (yvel[0]-yvel[6])
-                      + pfx[1] * (yvel[1]-yvel[7])
-                      + pfx[2] * (yvel[2]-yvel[4])
-                      + pfx[3] * (yvel[3]-yvel[5]) );
-
-  dxddy  = inv_detJ * ( pfy[0] * (xvel[0]-xvel[6])
-                      + pfy[1] * (xvel[1]-xvel[7])
-                      + pfy[2] * (xvel[2]-xvel[4])
-                      + pfy[3] * (xvel[3]-xvel[5]) );
-
-  dzddx  = inv_detJ * ( pfx[0] * (zvel[0]-zvel[6])
-                      + pfx[1] * (zvel[1]-zvel[7])
-                      + pfx[2] * (zvel[2]-zvel[4])
-                      + pfx[3] * (zvel[3]-zvel[5]) );
-
-  dxddz  = inv_detJ * ( pfz[0] * (xvel[0]-xvel[6])
-                      + pfz[1] * (xvel[1]-xvel[7])
-                      + pfz[2] * (xvel[2]-xvel[4])
-                      + pfz[3] * (xvel[3]-xvel[5]) );
-
-  dzddy  = inv_detJ * ( pfy[0] * (zvel[0]-zvel[6])
-                      + pfy[1] * (zvel[1]-zvel[7])
-                      + pfy[2] * (zvel[2]-zvel[4])
-                      + pfy[3] * (zvel[3]-zvel[5]) );
-
-  dyddz  = inv_detJ * ( pfz[0] * (yvel[0]-yvel[6])
-                      + pfz[1] * (yvel[1]-yvel[7])
-                      + pfz[2] * (yvel[2]-yvel[4])
-                      + pfz[3] * (yvel[3]-yvel[5]) );
-  d[5]  = Real_t( .5) * ( dxddy + dyddx );
-  d[4]  = Real_t( .5) * ( dxddz + dzddx );
-  d[3]  = Real_t( .5) * ( dzddy + dyddz );
+void CalcElemVelocityGradientBatch( const Real_t x[8][KIN_BATCH_SIZE],
+                                    const Real_t y[8][KIN_BATCH_SIZE],
+                                    const Real_t z[8][KIN_BATCH_SIZE],
+                                    const Real_t xd[8][KIN_BATCH_SIZE],
+                                    const Real_t yd[8][KIN_BATCH_SIZE],
+                                    const Real_t zd[8][KIN_BATCH_SIZE],
+                                    Real_t *dxx, Real_t *dyy, Real_t *dzz,
+                                    Index_t len )
+{
+#pragma omp simd
+   for (Index_t l = 0 ; l < len ; ++l) {
+      const Real_t fjxxi = Real_t(.125) * ( (x[6][l]-x[0][l]) + (x[5][l]-x[3][l]) - (x[7][l]-x[1][l]) - (x[4][l]-x[2][l]) );
+      const Real_t fjxet = Real_t(.125) * ( (x[6][l]-x[0][l]) - (x[5][l]-x[3][l]) + (x[7][l]-x[1][l]) - (x[4][l]-x[2][l]) );
+      const Real_t fjxze = Real_t(.125) * ( (x[6][l]-x[0][l]) + (x[5][l]-x[3][l]) + (x[7][l]-x[1][l]) + (x[4][l]-x[2][l]) );
+
+      const Real_t fjyxi = Real_t(.125) * ( (y[6][l]-y[0][l]) + (y[5][l]-y[3][l]) - (y[7][l]-y[1][l]) - (y[4][l]-y[2][l]) );
+      const Real_t fjyet = Real_t(.125) * ( (y[6][l]-y[0][l]) - (y[5][l]-y[3][l]) + (y[7][l]-y[1][l]) - (y[4][l]-y[2][l]) );
+      const Real_t fjyze = Real_t(.125) * ( (y[6][l]-y[0][l]) + (y[5][l]-y[3][l]) + (y[7][l]-y[1][l]) + (y[4][l]-y[2][l]) );
+
+      const Real_t fjzxi = Real_t(.125) * ( (z[6][l]-z[0][l]) + (z[5][l]-z[3][l]) - (z[7][l]-z[1][l]) - (z[4][l]-z[2][l]) );
+      const Real_t fjzet = Real_t(.125) * ( (z[6][l]-z[0][l]) - (z[5][l]-z[3][l]) + (z[7][l]-z[1][l]) - (z[4][l]-z[2][l]) );
+      const Real_t fjzze = Real_t(.125) * ( (z[6][l]-z[0][l]) + (z[5][l]-z[3][l]) + (z[7][l]-z[1][l]) + (z[4][l]-z[2][l]) );
+
+      /* compute cofactors */
+      const Real_t cjxxi =    (fjyet * fjzze) - (fjzet * fjyze);
+      const Real_t cjxet =  - (fjyxi * fjzze) + (fjzxi * fjyze);
+      const Real_t cjxze =    (fjyxi * fjzet) - (fjzxi * fjyet);
+
+      const Real_t cjyxi =  - (fjxet * fjzze) + (fjzet * fjxze);
+      const Real_t cjyet =    (fjxxi * fjzze) - (fjzxi * fjxze);
+      const Real_t cjyze =  - (fjxxi * fjzet) + (fjzxi * fjxet);
+
+      const Real_t cjzxi =    (fjxet * fjyze) - (fjyet * fjxze);
+      const Real_t cjzet =  - (fjxxi * fjyze) + (fjyxi * fjxze);
+      const Real_t cjzze =    (fjxxi * fjyet) - (fjyxi * fjxet);
+
+      /* partials for corners 0..3 */
+      const Real_t bx0 =   -  cjxxi  -  cjxet  -  cjxze;
+      const Real_t bx1 =      cjxxi  -  cjxet  -  cjxze;
+      const Real_t bx2 =      cjxxi  +  cjxet  -  cjxze;
+      const Real_t bx3 =   -  cjxxi  +  cjxet  -  cjxze;
+
+      const Real_t by0 =   -  cjyxi  -  cjyet  -  cjyze;
+      const Real_t by1 =      cjyxi  -  cjyet  -  cjyze;
+      const Real_t by2 =      cjyxi  +  cjyet  -  cjyze;
+      const Real_t by3 =   -  cjyxi  +  cjyet  -  cjyze;
+
+      const Real_t bz0 =   -  cjzxi  -  cjzet  -  cjzze;
+      const Real_t bz1 =      cjzxi  -  cjzet  -  cjzze;
+      const Real_t bz2 =      cjzxi  +  cjzet  -  cjzze;
+      const Real_t bz3 =   -  cjzxi  +  cjzet  -  cjzze;
+
+      /* jacobian determinant (volume) */
+      const Real_t detJ = Real_t(8.) * ( fjxet * cjxet + fjyet * cjyet + fjzet * cjzet);
+      const Real_t inv_detJ = Real_t(1.0) / detJ ;
+
+      dxx[l] = inv_detJ * ( bx0 * (xd[0][l]-xd[6][l])
+                          + bx1 * (xd[1][l]-xd[7][l])
+                          + bx2 * (xd[2][l]-xd[4][l])
+                          + bx3 * (xd[3][l]-xd[5][l]) );
+
+      dyy[l] = inv_detJ * ( by0 * (yd[0][l]-yd[6][l])
+                          + by1 * (yd[1][l]-yd[7][l])
+                          + by2 * (yd[2][l]-yd[4][l])
+                          + by3 * (yd[3][l]-yd[5][l]) );
+
+      dzz[l] = inv_detJ * ( bz0 * (zd[0][l]-zd[6][l])
+                          + bz1 * (zd[1][l]-zd[7][l])
+                          + bz2 * (zd[2][l]-zd[4][l])
+                          + bz3 * (zd[3][l]-zd[5][l]) );
+   }
 }
 
 /******************************************/
 
-//static inline
-void CalcKinematicsForElems( Domain &domain,
-                             Real_t deltaTime, Index_t numElem )
+/* Kinematics for the KIN_BATCH_SIZE (or fewer) elements starting at k0.
+ * The velocity gradient is taken at the half-step coordinates
+ * x - dt/2 * xd.  Normally they are formed here from the gathered
+ * coordinates; with -hs the nodal update has stored them once per node,
+ * and the full-step coordinates for the volume and characteristic
+ * length are formed back as xh + dt/2 * xd, so the sweep gathers only
+ * xh and xd.  That rounds differently from the default path. */
+static inline
+void CalcKinematicsForElemBatch( Domain &domain, Real_t deltaTime,
+                                 Index_t k0, Index_t len, bool halfStep )
 {
+  Real_t x_batch[8][KIN_BATCH_SIZE] ;
+  Real_t y_batch[8][KIN_BATCH_SIZE] ;
+  Real_t z_batch[8][KIN_BATCH_SIZE] ;
+  Real_t xh_batch[8][KIN_BATCH_SIZE] ;
+  Real_t yh_batch[8][KIN_BATCH_SIZE] ;
+  Real_t zh_batch[8][KIN_BATCH_SIZE] ;
+  Real_t xd_batch[8][KIN_BATCH_SIZE] ;
+  Real_t yd_batch[8][KIN_BATCH_SIZE] ;
+  Real_t zd_batch[8][KIN_BATCH_SIZE] ;
+  Real_t volume[KIN_BATCH_SIZE] ;
+  Real_t dt2 = Real_t(0.5) * deltaTime;
+
+  // gather nodal coordinates and velocities of the batch into
+  // corner-major local arrays.
+  if (halfStep) {
+     for( Index_t l=0 ; l<len ; ++l )
+     {
+       const Index_t* const elemToNode = domain.nodelist(k0 + l) ;
+       for( Index_t lnode=0 ; lnode<8 ; ++lnode )
+       {
+         Index_t gnode = elemToNode[lnode];
+         xh_batch[lnode][l] = domain.xh(gnode);
+         yh_batch[lnode][l] = domain.yh(gnode);
+         zh_batch[lnode][l] = domain.zh(gnode);
+         xd_batch[lnode][l] = domain.xd(gnode);
+         yd_batch[lnode][l] = domain.yd(gnode);
+         zd_batch[lnode][l] = domain.zd(gnode);
+       }
+     }
 
-  // loop over all elements
-#pragma omp parallel for firstprivate(numElem, deltaTime)
-  for( Index_t k=0 ; k<numElem ; ++k )
-  {
-    Real_t B[3][8] ; /** shape function derivatives */
-    Real_t D[6] ;
-    Real_t x_local[8] ;
-    Real_t y_local[8] ;
-    Real_t z_local[8] ;
-    Real_t xd_local[8] ;
-    Real_t yd_local[8] ;
-    Real_t zd_local[8] ;
-    Real_t detJ = Real_t(0.0) ;
+     for ( Index_t j=0 ; j<8 ; ++j )
+     {
+#pragma omp simd
+        for( Index_t l=0 ; l<len ; ++l )
+        {
+           x_batch[j][l] = xh_batch[j][l] + dt2 * xd_batch[j][l];
+           y_batch[j][l] = yh_batch[j][l] + dt2 * yd_batch[j][l];
+           z_batch[j][l] = zh_batch[j][l] + dt2 * zd_batch[j][l];
+        }
+     }
+  }
+  else {
+     for( Index_t l=0 ; l<len ; ++l )
+     {
+       const Index_t* const elemToNode = domain.nodelist(k0 + l) ;
+       for( Index_t lnode=0 ; lnode<8 ; ++lnode )
+       {
+         Index_t gnode = elemToNode[lnode];
+         x_batch[lnode][l] = domain.x(gnode);
+         y_batch[lnode][l] = domain.y(gnode);
+         z_batch[lnode][l] = domain.z(gnode);
+         xd_batch[lnode][l] = domain.xd(gnode);
+         yd_batch[lnode][l] = domain.yd(gnode);
+         zd_batch[lnode][l] = domain.zd(gnode);
+       }
+     }
 
-    Real_t volume ;
-    Real_t relativeVolume ;
-    const Index_t* const elemToNode = domain.nodelist(k) ;
+     for ( Index_t j=0 ; j<8 ; ++j )
+     {
+#pragma omp simd
+        for( Index_t l=0 ; l<len ; ++l )
+        {
+           xh_batch[j][l] = x_batch[j][l] - dt2 * xd_batch[j][l];
+           yh_batch[j][l] = y_batch[j][l] - dt2 * yd_batch[j][l];
+           zh_batch[j][l] = z_batch[j][l] - dt2 * zd_batch[j][l];
+        }
+     }
+  }
 
-    // get nodal coordinates from global arrays and copy into local arrays.
-    CollectDomainNodesToElemNodes(domain, elemToNode, x_local, y_local, z_local);
+  // volume calculations
+  CalcElemVolumeBatch(x_batch, y_batch, z_batch, volume, len) ;
 
-    // volume calculations
-    volume = CalcElemVolume(x_local, y_local, z_local );
-    relativeVolume = volume / domain.volo(k) ;
+#pragma omp simd
+  for( Index_t l=0 ; l<len ; ++l )
+  {
+    Index_t k = k0 + l ;
+    Real_t relativeVolume = volume[l] / domain.volo(k) ;
     domain.vnew(k) = relativeVolume ;
     domain.delv(k) = relativeVolume - domain.v(k) ;
+  }
 
-    // set characteristic length
-    domain.arealg(k) = CalcElemCharacteristicLength(x_local, y_local, z_local,
-                                             volume);
+  // set characteristic length
+  CalcElemCharacteristicLengthBatch(x_batch, y_batch, z_batch, volume,
+                                    &domain.arealg(k0), len) ;
 
-    // get nodal velocities from global array and copy into local arrays.
-    for( Index_t lnode=0 ; lnode<8 ; ++lnode )
-    {
-      Index_t gnode = elemToNode[lnode];
-      xd_local[lnode] = domain.xd(gnode);
-      yd_local[lnode] = domain.yd(gnode);
-      zd_local[lnode] = domain.zd(gnode);
-    }
+  // put velocity gradient quantities into their global arrays.
+  CalcElemVelocityGradientBatch(xh_batch, yh_batch, zh_batch,
+                                xd_batch, yd_batch, zd_batch,
+                                &domain.dxx(k0), &domain.dyy(k0),
+                                &domain.dzz(k0), len) ;
+}
 
-    Real_t dt2 = Real_t(0.5) * deltaTime;
-    for ( Index_t j=0 ; j<8 ; ++j )
-    {
-       x_local[j] -= dt2 * xd_local[j];
-       y_local[j] -= dt2 * yd_local[j];
-       z_local[j] -= dt2 * zd_local[j];
-    }
+/******************************************/
 
-    CalcElemShapeFunctionDerivatives( x_local, y_local, z_local,
-                                      B, &detJ );
+//static inline
+void CalcKinematicsForElems( Domain &domain,
+                             Real_t deltaTime, Index_t numElem )
+{
+  Index_t numBatch = (numElem + KIN_BATCH_SIZE - 1) / KIN_BATCH_SIZE ;
+  const bool halfStep = (domain.halfStepCoords() != 0) ;
 
-    CalcElemVelocityGradient( xd_local, yd_local, zd_local,
-                               B, detJ, D );
+  // loop over all element batches
+  Index_t bBegin, bEnd ;
+  ParRange(0, numBatch, &bBegin, &bEnd) ;
+  for (Index_t b=bBegin ; b<bEnd ; ++b)
+  {
+    const Index_t k0 = b*KIN_BATCH_SIZE ;
+    const Index_t len = std::min(Index_t(KIN_BATCH_SIZE), numElem - k0) ;
 
-    // put velocity gradient quantities into their global arrays.
-    domain.dxx(k) = D[0];
-    domain.dyy(k) = D[1];
-    domain.dzz(k) = D[2];
+    CalcKinematicsForElemBatch(domain, deltaTime, k0, len, halfStep) ;
   }
+  ParBarrier() ;
+}
+
+/******************************************/
+
+static inline
+void CalcDeviatoricStrainForElem(Domain& domain, Index_t k)
+{
+   // calc strain rate and apply as constraint (only done in FB element)
+   Real_t vdov = domain.dxx(k) + domain.dyy(k) + domain.dzz(k) ;
+   Real_t vdovthird = vdov/Real_t(3.0) ;
+
+   // make the rate of deformation tensor deviatoric
+   domain.vdov(k) = vdov ;
+   domain.dxx(k) -= vdovthird ;
+   domain.dyy(k) -= vdovthird ;
+   domain.dzz(k) -= vdovthird ;
+
+   // See if any volumes are negative, and take appropriate action.
+   if (domain.vnew(k) <= Real_t(0.0))
+   {
+#if USE_MPI           
+      MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+      exit(VolumeError);
+#endif
+   }
 }
 
 /******************************************/
@@ -1576,190 +2290,366 @@ void CalcLagrangeElements(Domain& domain)
    if (numElem > 0) {
       const Real_t deltatime = domain.deltatime() ;
 
-      domain.AllocateStrains(numElem);
+      if (ParThreadId() == 0) {
+         domain.AllocateStrains(numElem);
+      }
+      ParBarrier() ;
 
       CalcKinematicsForElems(domain, deltatime, numElem) ;
 
       // element loop to do some stuff not included in the elemlib function.
-#pragma omp parallel for firstprivate(numElem)
-      for ( Index_t k=0 ; k<numElem ; ++k )
+      Index_t kBegin, kEnd ;
+      ParRange(0, numElem, &kBegin, &kEnd) ;
+      for (Index_t k=kBegin ; k<kEnd ; ++k)
       {
-         // calc strain rate and apply as constraint (only done in FB element)
-         Real_t vdov = domain.dxx(k) + domain.dyy(k) + domain.dzz(k) ;
-         Real_t vdovthird = vdov/Real_t(3.0) ;
-
-         // make the rate of deformation tensor deviatoric
-         domain.vdov(k) = vdov ;
-         domain.dxx(k) -= vdovthird ;
-         domain.dyy(k) -= vdovthird ;
-         domain.dzz(k) -= vdovthird ;
-
-        // See if any volumes are negative, and take appropriate action.
-         if (domain.vnew(k) <= Real_t(0.0))
-        {
-#if USE_MPI           
-           MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
-#else
-           exit(VolumeError);
-#endif
-        }
+         CalcDeviatoricStrainForElem(domain, k) ;
+      }
+      ParBarrier() ;
+      if (ParThreadId() == 0) {
+         domain.DeallocateStrains();
       }
-      domain.DeallocateStrains();
    }
 }
 
 /******************************************/
 
+static inline
+void CalcMonotonicQGradientsForElem(Domain& domain, Index_t i)
+{
+   const Real_t ptiny = Real_t(1.e-36) ;
+   Real_t ax,ay,az ;
+   Real_t dxv,dyv,dzv ;
+
+   const Index_t *elemToNode = domain.nodelist(i);
+   Index_t n0 = elemToNode[0] ;
+   Index_t n1 = elemToNode[1] ;
+   Index_t n2 = elemToNode[2] ;
+   Index_t n3 = elemToNode[3] ;
+   Index_t n4 = elemToNode[4] ;
+   Index_t n5 = elemToNode[5] ;
+   Index_t n6 = elemToNode[6] ;
+   Index_t n7 = elemToNode[7] ;
+
+   Real_t x0 = domain.x(n0) ;
+   Real_t x1 = domain.x(n1) ;
+   Real_t x2 = domain.x(n2) ;
+   Real_t x3 = domain.x(n3) ;
+   Real_t x4 = domain.x(n4) ;
+   Real_t x5 = domain.x(n5) ;
+   Real_t x6 = domain.x(n6) ;
+   Real_t x7 = domain.x(n7) ;
+
+   Real_t y0 = domain.y(n0) ;
+   Real_t y1 = domain.y(n1) ;
+   Real_t y2 = domain.y(n2) ;
+   Real_t y3 = domain.y(n3) ;
+   Real_t y4 = domain.y(n4) ;
+   Real_t y5 = domain.y(n5) ;
+   Real_t y6 = domain.y(n6) ;
+   Real_t y7 = domain.y(n7) ;
+
+   Real_t z0 = domain.z(n0) ;
+   Real_t z1 = domain.z(n1) ;
+   Real_t z2 = domain.z(n2) ;
+   Real_t z3 = domain.z(n3) ;
+   Real_t z4 = domain.z(n4) ;
+   Real_t z5 = domain.z(n5) ;
+   Real_t z6 = domain.z(n6) ;
+   Real_t z7 = domain.z(n7) ;
+
+   Real_t xv0 = domain.xd(n0) ;
+   Real_t xv1 = domain.xd(n1) ;
+   Real_t xv2 = domain.xd(n2) ;
+   Real_t xv3 = domain.xd(n3) ;
+   Real_t xv4 = domain.xd(n4) ;
+   Real_t xv5 = domain.xd(n5) ;
+   Real_t xv6 = domain.xd(n6) ;
+   Real_t xv7 = domain.xd(n7) ;
+
+   Real_t yv0 = domain.yd(n0) ;
+   Real_t yv1 = domain.yd(n1) ;
+   Real_t yv2 = domain.yd(n2) ;
+   Real_t yv3 = domain.yd(n3) ;
+   Real_t yv4 = domain.yd(n4) ;
+   Real_t yv5 = domain.yd(n5) ;
+   Real_t yv6 = domain.yd(n6) ;
+   Real_t yv7 = domain.yd(n7) ;
+
+   Real_t zv0 = domain.zd(n0) ;
+   Real_t zv1 = domain.zd(n1) ;
+   Real_t zv2 = domain.zd(n2) ;
+   Real_t zv3 = domain.zd(n3) ;
+   Real_t zv4 = domain.zd(n4) ;
+   Real_t zv5 = domain.zd(n5) ;
+   Real_t zv6 = domain.zd(n6) ;
+   Real_t zv7 = domain.zd(n7) ;
+
+   Real_t vol = domain.volo(i)*domain.vnew(i) ;
+   Real_t norm = Real_t(1.0) / ( vol + ptiny ) ;
+
+   Real_t dxj = Real_t(-0.25)*((x0+x1+x5+x4) - (x3+x2+x6+x7)) ;
+   Real_t dyj = Real_t(-0.25)*((y0+y1+y5+y4) - (y3+y2+y6+y7)) ;
+   Real_t dzj = Real_t(-0.25)*((z0+z1+z5+z4) - (z3+z2+z6+z7)) ;
+
+   Real_t dxi = Real_t( 0.25)*((x1+x2+x6+x5) - (x0+x3+x7+x4)) ;
+   Real_t dyi = Real_t( 0.25)*((y1+y2+y6+y5) - (y0+y3+y7+y4)) ;
+   Real_t dzi = Real_t( 0.25)*((z1+z2+z6+z5) - (z0+z3+z7+z4)) ;
+
+   Real_t dxk = Real_t( 0.25)*((x4+x5+x6+x7) - (x0+x1+x2+x3)) ;
+   Real_t dyk = Real_t( 0.25)*((y4+y5+y6+y7) - (y0+y1+y2+y3)) ;
+   Real_t dzk = Real_t( 0.25)*((z4+z5+z6+z7) - (z0+z1+z2+z3)) ;
+
+   /* find delvk and delxk ( i cross j ) */
+
+   ax = dyi*dzj - dzi*dyj ;
+   ay = dzi*dxj - dxi*dzj ;
+   az = dxi*dyj - dyi*dxj ;
+
+   domain.delx_zeta(i) = vol / SQRT(ax*ax + ay*ay + az*az + ptiny) ;
+
+   ax *= norm ;
+   ay *= norm ;
+   az *= norm ;
+
+   dxv = Real_t(0.25)*((xv4+xv5+xv6+xv7) - (xv0+xv1+xv2+xv3)) ;
+   dyv = Real_t(0.25)*((yv4+yv5+yv6+yv7) - (yv0+yv1+yv2+yv3)) ;
+   dzv = Real_t(0.25)*((zv4+zv5+zv6+zv7) - (zv0+zv1+zv2+zv3)) ;
+
+   domain.delv_zeta(i) = ax*dxv + ay*dyv + az*dzv ;
+
+   /* find delxi and delvi ( j cross k ) */
+
+   ax = dyj*dzk - dzj*dyk ;
+   ay = dzj*dxk - dxj*dzk ;
+   az = dxj*dyk - dyj*dxk ;
+
+   domain.delx_xi(i) = vol / SQRT(ax*ax + ay*ay + az*az + ptiny) ;
+
+   ax *= norm ;
+   ay *= norm ;
+   az *= norm ;
+
+   dxv = Real_t(0.25)*((xv1+xv2+xv6+xv5) - (xv0+xv3+xv7+xv4)) ;
+   dyv = Real_t(0.25)*((yv1+yv2+yv6+yv5) - (yv0+yv3+yv7+yv4)) ;
+   dzv = Real_t(0.25)*((zv1+zv2+zv6+zv5) - (zv0+zv3+zv7+zv4)) ;
+
+   domain.delv_xi(i) = ax*dxv + ay*dyv + az*dzv ;
+
+   /* find delxj and delvj ( k cross i ) */
+
+   ax = dyk*dzi - dzk*dyi ;
+   ay = dzk*dxi - dxk*dzi ;
+   az = dxk*dyi - dyk*dxi ;
+
+   domain.delx_eta(i) = vol / SQRT(ax*ax + ay*ay + az*az + ptiny) ;
+
+   ax *= norm ;
+   ay *= norm ;
+   az *= norm ;
+
+   dxv = Real_t(-0.25)*((xv0+xv1+xv5+xv4) - (xv3+xv2+xv6+xv7)) ;
+   dyv = Real_t(-0.25)*((yv0+yv1+yv5+yv4) - (yv3+yv2+yv6+yv7)) ;
+   dzv = Real_t(-0.25)*((zv0+zv1+zv5+zv4) - (zv3+zv2+zv6+zv7)) ;
+
+   domain.delv_eta(i) = ax*dxv + ay*dyv + az*dzv ;
+}
+
+/******************************************/
+
 static inline
 void CalcMonotonicQGradientsForElems(Domain& domain)
 {
    Index_t numElem = domain.numElem();
 
-#pragma omp parallel for firstprivate(numElem)
-   for (Index_t i = 0 ; i < numElem ; ++i ) {
-      const Real_t ptiny = Real_t(1.e-36) ;
-      Real_t ax,ay,az ;
-      Real_t dxv,dyv,dzv ;
-
-      const Index_t *elemToNode = domain.nodelist(i);
-      Index_t n0 = elemToNode[0] ;
-      Index_t n1 = elemToNode[1] ;
-      Index_t n2 = elemToNode[2] ;
-      Index_t n3 = elemToNode[3] ;
-      Index_t n4 = elemToNode[4] ;
-      Index_t n5 = elemToNode[5] ;
-      Index_t n6 = elemToNode[6] ;
-      Index_t n7 = elemToNode[7] ;
-
-      Real_t x0 = domain.x(n0) ;
-      Real_t x1 = domain.x(n1) ;
-      Real_t x2 = domain.x(n2) ;
-      Real_t x3 = domain.x(n3) ;
-      Real_t x4 = domain.x(n4) ;
-      Real_t x5 = domain.x(n5) ;
-      Real_t x6 = domain.x(n6) ;
-      Real_t x7 = domain.x(n7) ;
-
-      Real_t y0 = domain.y(n0) ;
-      Real_t y1 = domain.y(n1) ;
-      Real_t y2 = domain.y(n2) ;
-      Real_t y3 = domain.y(n3) ;
-      Real_t y4 = domain.y(n4) ;
-      Real_t y5 = domain.y(n5) ;
-      Real_t y6 = domain.y(n6) ;
-      Real_t y7 = domain.y(n7) ;
-
-      Real_t z0 = domain.z(n0) ;
-      Real_t z1 = domain.z(n1) ;
-      Real_t z2 = domain.z(n2) ;
-      Real_t z3 = domain.z(n3) ;
-      Real_t z4 = domain.z(n4) ;
-      Real_t z5 = domain.z(n5) ;
-      Real_t z6 = domain.z(n6) ;
-      Real_t z7 = domain.z(n7) ;
-
-      Real_t xv0 = domain.xd(n0) ;
-      Real_t xv1 = domain.xd(n1) ;
-      Real_t xv2 = domain.xd(n2) ;
-      Real_t xv3 = domain.xd(n3) ;
-      Real_t xv4 = domain.xd(n4) ;
-      Real_t xv5 = domain.xd(n5) ;
-      Real_t xv6 = domain.xd(n6) ;
-      Real_t xv7 = domain.xd(n7) ;
-
-      Real_t yv0 = domain.yd(n0) ;
-      Real_t yv1 = domain.yd(n1) ;
-      Real_t yv2 = domain.yd(n2) ;
-      Real_t yv3 = domain.yd(n3) ;
-      Real_t yv4 = domain.yd(n4) ;
-      Real_t yv5 = domain.yd(n5) ;
-      Real_t yv6 = domain.yd(n6) ;
-      Real_t yv7 = domain.yd(n7) ;
-
-      Real_t zv0 = domain.zd(n0) ;
-      Real_t zv1 = domain.zd(n1) ;
-      Real_t zv2 = domain.zd(n2) ;
-      Real_t zv3 = domain.zd(n3) ;
-      Real_t zv4 = domain.zd(n4) ;
-      Real_t zv5 = domain.zd(n5) ;
-      Real_t zv6 = domain.zd(n6) ;
-      Real_t zv7 = domain.zd(n7) ;
-
-      Real_t vol = domain.volo(i)*domain.vnew(i) ;
-      Real_t norm = Real_t(1.0) / ( vol + ptiny ) ;
-
-      Real_t dxj = Real_t(-0.25)*((x0+x1+x5+x4) - (x3+x2+x6+x7)) ;
-      Real_t dyj = Real_t(-0.25)*((y0+y1+y5+y4) - (y3+y2+y6+y7)) ;
-      Real_t dzj = Real_t(-0.25)*((z0+z1+z5+z4) - (z3+z2+z6+z7)) ;
-
-      Real_t dxi = Real_t( 0.25)*((x1+x2+x6+x5) - (x0+x3+x7+x4)) ;
-      Real_t dyi = Real_t( 0.25)*((y1+y2+y6+y5) - (y0+y3+y7+y4)) ;
-      Real_t dzi = Real_t( 0.25)*((z1+z2+z6+z5) - (z0+z3+z7+z4)) ;
-
-      Real_t dxk = Real_t( 0.25)*((x4+x5+x6+x7) - (x0+x1+x2+x3)) ;
-      Real_t dyk = Real_t( 0.25)*((y4+y5+y6+y7) - (y0+y1+y2+y3)) ;
-      Real_t dzk = Real_t( 0.25)*((z4+z5+z6+z7) - (z0+z1+z2+z3)) ;
-
-      /* find delvk and delxk ( i cross j ) */
-
-      ax = dyi*dzj - dzi*dyj ;
-      ay = dzi*dxj - dxi*dzj ;
-      az = dxi*dyj - dyi*dxj ;
-
-      domain.delx_zeta(i) = vol / SQRT(ax*ax + ay*ay + az*az + ptiny) ;
-
-      ax *= norm ;
-      ay *= norm ;
-      az *= norm ;
-
-      dxv = Real_t(0.25)*((xv4+xv5+xv6+xv7) - (xv0+xv1+xv2+xv3)) ;
-      dyv = Real_t(0.25)*((yv4+yv5+yv6+yv7) - (yv0+yv1+yv2+yv3)) ;
-      dzv = Real_t(0.25)*((zv4+zv5+zv6+zv7) - (zv0+zv1+zv2+zv3)) ;
-
-      domain.delv_zeta(i) = ax*dxv + ay*dyv + az*dzv ;
-
-      /* find delxi and delvi ( j cross k ) */
-
-      ax = dyj*dzk - dzj*dyk ;
-      ay = dzj*dxk - dxj*dzk ;
-      az = dxj*dyk - dyj*dxk ;
-
-      domain.delx_xi(i) = vol / SQRT(ax*ax + ay*ay + az*az + ptiny) ;
-
-      ax *= norm ;
-      ay *= norm ;
-      az *= norm ;
+   Index_t iBegin, iEnd ;
+   ParRange(0, numElem, &iBegin, &iEnd) ;
+   for (Index_t i=iBegin ; i<iEnd ; ++i) {
+      CalcMonotonicQGradientsForElem(domain, i) ;
+   }
+   ParBarrier() ;
+}
+
+/******************************************/
+
+static inline
+void CalcMonotonicQForElem(Domain &domain, Index_t ielem, Real_t ptiny,
+                           Real_t qlc_monoq, Real_t qqc_monoq,
+                           Real_t monoq_limiter_mult, Real_t monoq_max_slope)
+{
+   Real_t qlin, qquad ;
+   Real_t phixi, phieta, phizeta ;
+   Int_t bcMask = domain.elemBC(ielem) ;
+   Real_t delvm = 0.0, delvp =0.0;
+
+   /*  phixi     */
+   Real_t norm = Real_t(1.) / (domain.delv_xi(ielem)+ ptiny ) ;
+
+   switch (bcMask & XI_M) {
+      case XI_M_COMM: /* needs comm data */
+      case 0:         delvm = domain.delv_xi(domain.lxim(ielem)); break ;
+      case XI_M_SYMM: delvm = domain.delv_xi(ielem) ;       break ;
+      case XI_M_FREE: delvm = Real_t(0.0) ;      break ;
+      default:          fprintf(stderr, "Error in switch at %s line %d\n",
+                                __FILE__, __LINE__);
+         delvm = 0; /* ERROR - but quiets the compiler */
+         break;
+   }
+   switch (bcMask & XI_P) {
+      case XI_P_COMM: /* needs comm data */
+      case 0:         delvp = domain.delv_xi(domain.lxip(ielem)) ; break ;
+      case XI_P_SYMM: delvp = domain.delv_xi(ielem) ;       break ;
+      case XI_P_FREE: delvp = Real_t(0.0) ;      break ;
+      default:          fprintf(stderr, "Error in switch at %s line %d\n",
+                                __FILE__, __LINE__);
+         delvp = 0; /* ERROR - but quiets the compiler */
+         break;
+   }
+
+   delvm = delvm * norm ;
+   delvp = delvp * norm ;
+
+   phixi = Real_t(.5) * ( delvm + delvp ) ;
+
+   delvm *= monoq_limiter_mult ;
+   delvp *= monoq_limiter_mult ;
+
+   if ( delvm < phixi ) phixi = delvm ;
+   if ( delvp < phixi ) phixi = delvp ;
+   if ( phixi < Real_t(0.)) phixi = Real_t(0.) ;
+   if ( phixi > monoq_max_slope) phixi = monoq_max_slope;
+
+
+   /*  phieta     */
+   norm = Real_t(1.) / ( domain.delv_eta(ielem) + ptiny ) ;
+
+   switch (bcMask & ETA_M) {
+      case ETA_M_COMM: /* needs comm data */
+      case 0:          delvm = domain.delv_eta(domain.letam(ielem)) ; break ;
+      case ETA_M_SYMM: delvm = domain.delv_eta(ielem) ;        break ;
+      case ETA_M_FREE: delvm = Real_t(0.0) ;        break ;
+      default:          fprintf(stderr, "Error in switch at %s line %d\n",
+                                __FILE__, __LINE__);
+         delvm = 0; /* ERROR - but quiets the compiler */
+         break;
+   }
+   switch (bcMask & ETA_P) {
+      case ETA_P_COMM: /* needs comm data */
+      case 0:          delvp = domain.delv_eta(domain.letap(ielem)) ; break ;
+      case ETA_P_SYMM: delvp = domain.delv_eta(ielem) ;        break ;
+      case ETA_P_FREE: delvp = Real_t(0.0) ;        break ;
+      default:          fprintf(stderr, "Error in switch at %s line %d\n",
+                                __FILE__, __LINE__);
+         delvp = 0; /* ERROR - but quiets the compiler */
+         break;
+   }
+
+   delvm = delvm * norm ;
+   delvp = delvp * norm ;
+
+   phieta = Real_t(.5) * ( delvm + delvp ) ;
+
+   delvm *= monoq_limiter_mult ;
+   delvp *= monoq_limiter_mult ;
 
-      dxv = Real_t(0.25)*((xv1+xv2+xv6+xv5) - (xv0+xv3+xv7+xv4)) ;
-      dyv = Real_t(0.25)*((yv1+yv2+yv6+yv5) - (yv0+yv3+yv7+yv4)) ;
-      dzv = Real_t(0.25)*((zv1+zv2+zv6+zv5) - (zv0+zv3+zv7+zv4)) ;
+   if ( delvm  < phieta ) phieta = delvm ;
+   if ( delvp  < phieta ) phieta = delvp ;
+   if ( phieta < Real_t(0.)) phieta = Real_t(0.) ;
+   if ( phieta > monoq_max_slope)  phieta = monoq_max_slope;
 
-      domain.delv_xi(i) = ax*dxv + ay*dyv + az*dzv ;
+   /*  phizeta     */
+   norm = Real_t(1.) / ( domain.delv_zeta(ielem) + ptiny ) ;
 
-      /* find delxj and delvj ( k cross i ) */
+   switch (bcMask & ZETA_M) {
+      case ZETA_M_COMM: /* needs comm data */
+      case 0:           delvm = domain.delv_zeta(domain.lzetam(ielem)) ; break ;
+      case ZETA_M_SYMM: delvm = domain.delv_zeta(ielem) ;         break ;
+      case ZETA_M_FREE: delvm = Real_t(0.0) ;          break ;
+      default:          fprintf(stderr, "Error in switch at %s line %d\n",
+                                __FILE__, __LINE__);
+         delvm = 0; /* ERROR - but quiets the compiler */
+         break;
+   }
+   switch (bcMask & ZETA_P) {
+      case ZETA_P_COMM: /* needs comm data */
+      case 0:           delvp = domain.delv_zeta(domain.lzetap(ielem)) ; break ;
+      case ZETA_P_SYMM: delvp = domain.delv_zeta(ielem) ;         break ;
+      case ZETA_P_FREE: delvp = Real_t(0.0) ;          break ;
+      default:          fprintf(stderr, "Error in switch at %s line %d\n",
+                                __FILE__, __LINE__);
+         delvp = 0; /* ERROR - but quiets the compiler */
+         break;
+   }
 
-      ax = dyk*dzi - dzk*dyi ;
-      ay = dzk*dxi - dxk*dzi ;
-      az = dxk*dyi - dyk*dxi ;
+   delvm = delvm * norm ;
+   delvp = delvp * norm ;
 
-      domain.delx_eta(i) = vol / SQRT(ax*ax + ay*ay + az*az + ptiny) ;
+   phizeta = Real_t(.5) * ( delvm + delvp ) ;
 
-      ax *= norm ;
-      ay *= norm ;
-      az *= norm ;
+   delvm *= monoq_limiter_mult ;
+   delvp *= monoq_limiter_mult ;
 
-      dxv = Real_t(-0.25)*((xv0+xv1+xv5+xv4) - (xv3+xv2+xv6+xv7)) ;
-      dyv = Real_t(-0.25)*((yv0+yv1+yv5+yv4) - (yv3+yv2+yv6+yv7)) ;
-      dzv = Real_t(-0.25)*((zv0+zv1+zv5+zv4) - (zv3+zv2+zv6+zv7)) ;
+   if ( delvm   < phizeta ) phizeta = delvm ;
+   if ( delvp   < phizeta ) phizeta = delvp ;
+   if ( phizeta < Real_t(0.)) phizeta = Real_t(0.);
+   if ( phizeta > monoq_max_slope  ) phizeta = monoq_max_slope;
 
-      domain.delv_eta(i) = ax*dxv + ay*dyv + az*dzv ;
+   /* Remove length scale */
+
+   if ( domain.vdov(ielem) > Real_t(0.) )  {
+      qlin  = Real_t(0.) ;
+      qquad = Real_t(0.) ;
+   }
+   else {
+      Real_t delvxxi   = domain.delv_xi(ielem)   * domain.delx_xi(ielem)   ;
+      Real_t delvxeta  = domain.delv_eta(ielem)  * domain.delx_eta(ielem)  ;
+      Real_t delvxzeta = domain.delv_zeta(ielem) * domain.delx_zeta(ielem) ;
+
+      if ( delvxxi   > Real_t(0.) ) delvxxi   = Real_t(0.) ;
+      if ( delvxeta  > Real_t(0.) ) delvxeta  = Real_t(0.) ;
+      if ( delvxzeta > Real_t(0.) ) delvxzeta = Real_t(0.) ;
+
+      Real_t rho = domain.elemMass(ielem) / (domain.volo(ielem) * domain.vnew(ielem)) ;
+
+      qlin = -qlc_monoq * rho *
+         (  delvxxi   * (Real_t(1.) - phixi) +
+            delvxeta  * (Real_t(1.) - phieta) +
+            delvxzeta * (Real_t(1.) - phizeta)  ) ;
+
+      qquad = qqc_monoq * rho *
+         (  delvxxi*delvxxi     * (Real_t(1.) - phixi*phixi) +
+            delvxeta*delvxeta   * (Real_t(1.) - phieta*phieta) +
+            delvxzeta*delvxzeta * (Real_t(1.) - phizeta*phizeta)  ) ;
    }
+
+   domain.qq(ielem) = qquad ;
+   domain.ql(ielem) = qlin  ;
 }
 
 /******************************************/
 
+/*
+ * Small regions.  CreateRegionIndexSets can leave regions of a handful
+ * of elements on a rank, and cutting those into a piece per thread costs
+ * more than it saves.  At startup CalibrateSmallRegions() measures the
+ * cost of a team barrier and the fixed cost of an EOS call (task
+ * dispatch and scratch allocation); the first cycle measures the cost
+ * per element of the monotonic q and of the EOS.  From the second cycle
+ *
+ *   - regions smaller than monoqCutoff elements get their monotonic q
+ *     from a single thread (round robin over the small regions)
+ *   - regions smaller than eosCutoff are never split into several EOS
+ *     tasks, and with -batch the small regions of equal rep are
+ *     concatenated and evaluated with one EvalEOSForElems call; the
+ *     small regions of the monotonic q then go through one combined
+ *     sweep shared by the team
+ *
+ * Elements are independent, so none of this changes results.
+ */
+/******************************************/
+
 static inline
 void CalcMonotonicQRegionForElems(Domain &domain, Int_t r,
+                                  Index_t begin, Index_t end,
                                   Real_t ptiny)
 {
    Real_t monoq_limiter_mult = domain.monoq_limiter_mult();
@@ -1767,156 +2657,10 @@ void CalcMonotonicQRegionForElems(Domain &domain, Int_t r,
    Real_t qlc_monoq = domain.qlc_monoq();
    Real_t qqc_monoq = domain.qqc_monoq();
 
-#pragma omp parallel for firstprivate(qlc_monoq, qqc_monoq, monoq_limiter_mult, monoq_max_slope, ptiny)
-   for ( Index_t i = 0 ; i < domain.regElemSize(r); ++i ) {
-      Index_t ielem = domain.regElemlist(r,i);
-      Real_t qlin, qquad ;
-      Real_t phixi, phieta, phizeta ;
-      Int_t bcMask = domain.elemBC(ielem) ;
-      Real_t delvm = 0.0, delvp =0.0;
-
-      /*  phixi     */
-      Real_t norm = Real_t(1.) / (domain.delv_xi(ielem)+ ptiny ) ;
-
-      switch (bcMask & XI_M) {
-         case XI_M_COMM: /* needs comm data */
-         case 0:         delvm = domain.delv_xi(domain.lxim(ielem)); break ;
-         case XI_M_SYMM: delvm = domain.delv_xi(ielem) ;       break ;
-         case XI_M_FREE: delvm = Real_t(0.0) ;      break ;
-         default:          fprintf(stderr, "Error in switch at %s line %d\n",
-                                   __FILE__, __LINE__);
-            delvm = 0; /* ERROR - but quiets the compiler */
-            break;
-      }
-      switch (bcMask & XI_P) {
-         case XI_P_COMM: /* needs comm data */
-         case 0:         delvp = domain.delv_xi(domain.lxip(ielem)) ; break ;
-         case XI_P_SYMM: delvp = domain.delv_xi(ielem) ;       break ;
-         case XI_P_FREE: delvp = Real_t(0.0) ;      break ;
-         default:          fprintf(stderr, "Error in switch at %s line %d\n",
-                                   __FILE__, __LINE__);
-            delvp = 0; /* ERROR - but quiets the compiler */
-            break;
-      }
-
-      delvm = delvm * norm ;
-      delvp = delvp * norm ;
-
-      phixi = Real_t(.5) * ( delvm + delvp ) ;
-
-      delvm *= monoq_limiter_mult ;
-      delvp *= monoq_limiter_mult ;
-
-      if ( delvm < phixi ) phixi = delvm ;
-      if ( delvp < phixi ) phixi = delvp ;
-      if ( phixi < Real_t(0.)) phixi = Real_t(0.) ;
-      if ( phixi > monoq_max_slope) phixi = monoq_max_slope;
-
-
-      /*  phieta     */
-      norm = Real_t(1.) / ( domain.delv_eta(ielem) + ptiny ) ;
-
-      switch (bcMask & ETA_M) {
-         case ETA_M_COMM: /* needs comm data */
-         case 0:          delvm = domain.delv_eta(domain.letam(ielem)) ; break ;
-         case ETA_M_SYMM: delvm = domain.delv_eta(ielem) ;        break ;
-         case ETA_M_FREE: delvm = Real_t(0.0) ;        break ;
-         default:          fprintf(stderr, "Error in switch at %s line %d\n",
-                                   __FILE__, __LINE__);
-            delvm = 0; /* ERROR - but quiets the compiler */
-            break;
-      }
-      switch (bcMask & ETA_P) {
-         case ETA_P_COMM: /* needs comm data */
-         case 0:          delvp = domain.delv_eta(domain.letap(ielem)) ; break ;
-         case ETA_P_SYMM: delvp = domain.delv_eta(ielem) ;        break ;
-         case ETA_P_FREE: delvp = Real_t(0.0) ;        break ;
-         default:          fprintf(stderr, "Error in switch at %s line %d\n",
-                                   __FILE__, __LINE__);
-            delvp = 0; /* ERROR - but quiets the compiler */
-            break;
-      }
-
-      delvm = delvm * norm ;
-      delvp = delvp * norm ;
-
-      phieta = Real_t(.5) * ( delvm + delvp ) ;
-
-      delvm *= monoq_limiter_mult ;
-      delvp *= monoq_limiter_mult ;
-
-      if ( delvm  < phieta ) phieta = delvm ;
-      if ( delvp  < phieta ) phieta = delvp ;
-      if ( phieta < Real_t(0.)) phieta = Real_t(0.) ;
-      if ( phieta > monoq_max_slope)  phieta = monoq_max_slope;
-
-      /*  phizeta     */
-      norm = Real_t(1.) / ( domain.delv_zeta(ielem) + ptiny ) ;
-
-      switch (bcMask & ZETA_M) {
-         case ZETA_M_COMM: /* needs comm data */
-         case 0:           delvm = domain.delv_zeta(domain.lzetam(ielem)) ; break ;
-         case ZETA_M_SYMM: delvm = domain.delv_zeta(ielem) ;         break ;
-         case ZETA_M_FREE: delvm = Real_t(0.0) ;          break ;
-         default:          fprintf(stderr, "Error in switch at %s line %d\n",
-                                   __FILE__, __LINE__);
-            delvm = 0; /* ERROR - but quiets the compiler */
-            break;
-      }
-      switch (bcMask & ZETA_P) {
-         case ZETA_P_COMM: /* needs comm data */
-         case 0:           delvp = domain.delv_zeta(domain.lzetap(ielem)) ; break ;
-         case ZETA_P_SYMM: delvp = domain.delv_zeta(ielem) ;         break ;
-         case ZETA_P_FREE: delvp = Real_t(0.0) ;          break ;
-         default:          fprintf(stderr, "Error in switch at %s line %d\n",
-                                   __FILE__, __LINE__);
-            delvp = 0; /* ERROR - but quiets the compiler */
-            break;
-      }
-
-      delvm = delvm * norm ;
-      delvp = delvp * norm ;
-
-      phizeta = Real_t(.5) * ( delvm + delvp ) ;
-
-      delvm *= monoq_limiter_mult ;
-      delvp *= monoq_limiter_mult ;
-
-      if ( delvm   < phizeta ) phizeta = delvm ;
-      if ( delvp   < phizeta ) phizeta = delvp ;
-      if ( phizeta < Real_t(0.)) phizeta = Real_t(0.);
-      if ( phizeta > monoq_max_slope  ) phizeta = monoq_max_slope;
-
-      /* Remove length scale */
-
-      if ( domain.vdov(ielem) > Real_t(0.) )  {
-         qlin  = Real_t(0.) ;
-         qquad = Real_t(0.) ;
-      }
-      else {
-         Real_t delvxxi   = domain.delv_xi(ielem)   * domain.delx_xi(ielem)   ;
-         Real_t delvxeta  = domain.delv_eta(ielem)  * domain.delx_eta(ielem)  ;
-         Real_t delvxzeta = domain.delv_zeta(ielem) * domain.delx_zeta(ielem) ;
-
-         if ( delvxxi   > Real_t(0.) ) delvxxi   = Real_t(0.) ;
-         if ( delvxeta  > Real_t(0.) ) delvxeta  = Real_t(0.) ;
-         if ( delvxzeta > Real_t(0.) ) delvxzeta = Real_t(0.) ;
-
-         Real_t rho = domain.elemMass(ielem) / (domain.volo(ielem) * domain.vnew(ielem)) ;
-
-         qlin = -qlc_monoq * rho *
-            (  delvxxi   * (Real_t(1.) - phixi) +
-               delvxeta  * (Real_t(1.) - phieta) +
-               delvxzeta * (Real_t(1.) - phizeta)  ) ;
-
-         qquad = qqc_monoq * rho *
-            (  delvxxi*delvxxi     * (Real_t(1.) - phixi*phixi) +
-               delvxeta*delvxeta   * (Real_t(1.) - phieta*phieta) +
-               delvxzeta*delvxzeta * (Real_t(1.) - phizeta*phizeta)  ) ;
-      }
-
-      domain.qq(ielem) = qquad ;
-      domain.ql(ielem) = qlin  ;
+   for (Index_t i=begin ; i<end ; ++i) {
+      CalcMonotonicQForElem(domain, domain.regElemlist(r,i), ptiny,
+                            qlc_monoq, qqc_monoq,
+                            monoq_limiter_mult, monoq_max_slope) ;
    }
 }
 
@@ -1930,16 +2674,142 @@ void CalcMonotonicQForElems(Domain& domain)
    // 
    const Real_t ptiny = Real_t(1.e-36) ;
 
+   SmallRegion_t &small = domain.smallRegions() ;
+   const bool batch = (domain.regionBatch() != 0) ;
+   const Index_t cutoff = small.monoqCutoff ;
+   Int_t tid = ParThreadId() ;
+   Int_t team = ParTeamSize() ;
+   Int_t numSmall = 0 ;
+   Index_t numSmallElem = 0 ;
+   Index_t iBegin, iEnd ;
+   double start = WallClock() ;
+
    //
-   // calculate the monotonic q for all regions
+   // calculate the monotonic q for all regions; regions are disjoint,
+   // so no barrier is needed between them
    //
    for (Index_t r=0 ; r<domain.numReg() ; ++r) {
-      if (domain.regElemSize(r) > 0) {
-         CalcMonotonicQRegionForElems(domain, r, ptiny) ;
+      Index_t size = domain.regElemSize(r) ;
+      if (size == 0) {
+         continue ;
+      }
+      if (size >= cutoff) {
+         ParRange(0, size, &iBegin, &iEnd) ;
+         CalcMonotonicQRegionForElems(domain, r, iBegin, iEnd, ptiny) ;
+      }
+      else {
+         if (!batch && (numSmall % team) == tid) {
+            CalcMonotonicQRegionForElems(domain, r, 0, size, ptiny) ;
+         }
+         numSmallElem += size ;
+         ++numSmall ;
       }
    }
+
+   // with -batch the small regions are one sweep over their
+   // concatenated element lists
+   if (batch && numSmall > 0) {
+      ParRange(0, numSmallElem, &iBegin, &iEnd) ;
+      Index_t offset = 0 ;
+      for (Index_t r=0 ; r<domain.numReg() && offset<iEnd ; ++r) {
+         Index_t size = domain.regElemSize(r) ;
+         if (size == 0 || size >= cutoff) {
+            continue ;
+         }
+         Index_t b = std::max(iBegin, offset) - offset ;
+         Index_t e = std::min(iEnd, offset + size) - offset ;
+         if (b < e) {
+            CalcMonotonicQRegionForElems(domain, r, b, e, ptiny) ;
+         }
+         offset += size ;
+      }
+   }
+   ParBarrier() ;
+
+   if (tid == 0) {
+      if (!small.measured) {
+         small.monoqElemCost = (WallClock() - start)*double(team) /
+                               double(domain.numElem()) ;
+      }
+      small.monoqSmall = numSmall ;
+   }
+}
+
+#if USE_MPI
+/* Velocity gradients of a list of elements (-overlap) */
+static inline
+void CalcMonotonicQGradientsForList(Domain& domain,
+                                    const std::vector<Index_t>& elems)
+{
+   Index_t kBegin, kEnd ;
+   ParRange(0, Index_t(elems.size()), &kBegin, &kEnd) ;
+   for (Index_t k=kBegin ; k<kEnd ; ++k) {
+      CalcMonotonicQGradientsForElem(domain, elems[k]) ;
+   }
+   ParBarrier() ;
+}
+
+/* Monotonic q of a list of elements (-overlap); elements are
+ * independent, so this equals the sweep over the region lists */
+static inline
+void CalcMonotonicQForList(Domain& domain, const std::vector<Index_t>& elems)
+{
+   const Real_t ptiny = Real_t(1.e-36) ;
+   Real_t monoq_limiter_mult = domain.monoq_limiter_mult();
+   Real_t monoq_max_slope = domain.monoq_max_slope();
+   Real_t qlc_monoq = domain.qlc_monoq();
+   Real_t qqc_monoq = domain.qqc_monoq();
+
+   Index_t kBegin, kEnd ;
+   ParRange(0, Index_t(elems.size()), &kBegin, &kEnd) ;
+   for (Index_t k=kBegin ; k<kEnd ; ++k) {
+      CalcMonotonicQForElem(domain, elems[k], ptiny,
+                            qlc_monoq, qqc_monoq,
+                            monoq_limiter_mult, monoq_max_slope) ;
+   }
+   ParBarrier() ;
 }
 
+/* Pipelined monotonic q (-overlap): only the shell elements send
+ * gradients and only they read ghost gradients, so the interior
+ * gradients and limiter run while MSG_MONOQ is in flight */
+static void CalcMonotonicQOverlapped(Domain& domain)
+{
+   HaloSplit_t &split = domain.haloSplit() ;
+   Domain_member fieldData[3] ;
+
+   fieldData[0] = &Domain::delv_xi ;
+   fieldData[1] = &Domain::delv_eta ;
+   fieldData[2] = &Domain::delv_zeta ;
+
+   if (CommThread(domain)) {
+      CommRecv(domain, MSG_MONOQ, 3,
+               domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+               true, true) ;
+   }
+
+   // boundary gradients first, then start sending them
+   CalcMonotonicQGradientsForList(domain, split.shellElem) ;
+   if (CommThread(domain)) {
+      CommSendStart(domain, MSG_MONOQ, 3, fieldData,
+                    domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+                    true, true) ;
+   }
+
+   // interior neighbors are all local
+   CalcMonotonicQGradientsForList(domain, split.interiorElem) ;
+   CalcMonotonicQForList(domain, split.interiorElem) ;
+
+   if (CommThread(domain)) {
+      CommMonoQ(domain) ;
+      CommSendFinish(domain) ;
+   }
+   ParBarrier() ;
+
+   CalcMonotonicQForList(domain, split.shellElem) ;
+}
+#endif
+
 /******************************************/
 
 static inline
@@ -1957,55 +2827,76 @@ void CalcQForElems(Domain& domain)
             2*domain.sizeX()*domain.sizeZ() + /* row ghosts */
             2*domain.sizeY()*domain.sizeZ() ; /* col ghosts */
 
-      domain.AllocateGradients(numElem, allElem);
+      if (ParThreadId() == 0) {
+         domain.AllocateGradients(numElem, allElem);
+      }
+      ParBarrier() ;
 
 #if USE_MPI      
-      CommRecv(domain, MSG_MONOQ, 3,
-               domain.sizeX(), domain.sizeY(), domain.sizeZ(),
-               true, true) ;
+      if (HaloOverlap(domain)) {
+         CalcMonotonicQOverlapped(domain) ;
+      }
+      else
+#endif      
+      {
+#if USE_MPI      
+         if (CommThread(domain)) {
+            CommRecv(domain, MSG_MONOQ, 3,
+                     domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+                     true, true) ;
+         }
 #endif      
 
-      /* Calculate velocity gradients */
-      CalcMonotonicQGradientsForElems(domain);
+         /* Calculate velocity gradients */
+         CalcMonotonicQGradientsForElems(domain);
 
 #if USE_MPI      
-      Domain_member fieldData[3] ;
+         Domain_member fieldData[3] ;
       
-      /* Transfer veloctiy gradients in the first order elements */
-      /* problem->commElements->Transfer(CommElements::monoQ) ; */
+         /* Transfer veloctiy gradients in the first order elements */
+         /* problem->commElements->Transfer(CommElements::monoQ) ; */
 
-      fieldData[0] = &Domain::delv_xi ;
-      fieldData[1] = &Domain::delv_eta ;
-      fieldData[2] = &Domain::delv_zeta ;
+         fieldData[0] = &Domain::delv_xi ;
+         fieldData[1] = &Domain::delv_eta ;
+         fieldData[2] = &Domain::delv_zeta ;
 
-      CommSend(domain, MSG_MONOQ, 3, fieldData,
-               domain.sizeX(), domain.sizeY(), domain.sizeZ(),
-               true, true) ;
+         if (CommThread(domain))
+         {
+            CommSend(domain, MSG_MONOQ, 3, fieldData,
+                     domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+                     true, true) ;
 
-      CommMonoQ(domain) ;
+            CommMonoQ(domain) ;
+         }
+         ParBarrier() ;
 #endif      
 
-      CalcMonotonicQForElems(domain);
-
-      // Free up memory
-      domain.DeallocateGradients();
+         CalcMonotonicQForElems(domain);
+      }
 
-      /* Don't allow excessive artificial viscosity */
-      Index_t idx = -1; 
-      for (Index_t i=0; i<numElem; ++i) {
-         if ( domain.q(i) > domain.qstop() ) {
-            idx = i ;
-            break ;
+      if (ParThreadId() == 0)
+      {
+         // Free up memory
+         domain.DeallocateGradients();
+
+         /* Don't allow excessive artificial viscosity */
+         Index_t idx = -1; 
+         for (Index_t i=0; i<numElem; ++i) {
+            if ( domain.q(i) > domain.qstop() ) {
+               idx = i ;
+               break ;
+            }
          }
-      }
 
-      if(idx >= 0) {
+         if(idx >= 0) {
 #if USE_MPI         
-         MPI_Abort(MPI_COMM_WORLD, QStopError) ;
+            MPI_Abort(MPI_COMM_WORLD, QStopError) ;
 #else
-         exit(QStopError);
+            exit(QStopError);
 #endif
+         }
       }
+      ParBarrier() ;
    }
 }
 
@@ -2019,14 +2910,12 @@ void CalcPressureForElems(Real_t* p_new, Real_t* bvc,
                           Real_t p_cut, Real_t eosvmax,
                           Index_t length, Index_t *regElemList)
 {
-#pragma omp parallel for firstprivate(length)
    for (Index_t i = 0; i < length ; ++i) {
       Real_t c1s = Real_t(2.0)/Real_t(3.0) ;
       bvc[i] = c1s * (compression[i] + Real_t(1.));
       pbvc[i] = c1s;
    }
 
-#pragma omp parallel for firstprivate(length, pmin, p_cut, eosvmax)
    for (Index_t i = 0 ; i < length ; ++i){
       Index_t ielem = regElemList[i];
       
@@ -2059,7 +2948,6 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
 {
    Real_t *pHalfStep = Allocate<Real_t>(length) ;
 
-#pragma omp parallel for firstprivate(length, emin)
    for (Index_t i = 0 ; i < length ; ++i) {
       e_new[i] = e_old[i] - Real_t(0.5) * delvc[i] * (p_old[i] + q_old[i])
          + Real_t(0.5) * work[i];
@@ -2072,7 +2960,6 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
    CalcPressureForElems(pHalfStep, bvc, pbvc, e_new, compHalfStep, vnewc,
                         pmin, p_cut, eosvmax, length, regElemList);
 
-#pragma omp parallel for firstprivate(length, rho0)
    for (Index_t i = 0 ; i < length ; ++i) {
       Real_t vhalf = Real_t(1.) / (Real_t(1.) + compHalfStep[i]) ;
 
@@ -2086,7 +2973,7 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
          if ( ssc <= Real_t(.1111111e-36) ) {
             ssc = Real_t(.3333333e-18) ;
          } else {
-            ssc = SQRT(ssc) ;
+            ssc = FASTSQRT(ssc) ;
          }
 
          q_new[i] = (ssc*ql_old[i] + qq_old[i]) ;
@@ -2097,7 +2984,6 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
               - Real_t(4.0)*(pHalfStep[i] + q_new[i])) ;
    }
 
-#pragma omp parallel for firstprivate(length, emin, e_cut)
    for (Index_t i = 0 ; i < length ; ++i) {
 
       e_new[i] += Real_t(0.5) * work[i];
@@ -2113,7 +2999,6 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
    CalcPressureForElems(p_new, bvc, pbvc, e_new, compression, vnewc,
                         pmin, p_cut, eosvmax, length, regElemList);
 
-#pragma omp parallel for firstprivate(length, rho0, emin, e_cut)
    for (Index_t i = 0 ; i < length ; ++i){
       const Real_t sixth = Real_t(1.0) / Real_t(6.0) ;
       Index_t ielem = regElemList[i];
@@ -2129,7 +3014,7 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
          if ( ssc <= Real_t(.1111111e-36) ) {
             ssc = Real_t(.3333333e-18) ;
          } else {
-            ssc = SQRT(ssc) ;
+            ssc = FASTSQRT(ssc) ;
          }
 
          q_tilde = (ssc*ql_old[i] + qq_old[i]) ;
@@ -2150,7 +3035,6 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
    CalcPressureForElems(p_new, bvc, pbvc, e_new, compression, vnewc,
                         pmin, p_cut, eosvmax, length, regElemList);
 
-#pragma omp parallel for firstprivate(length, rho0, q_cut)
    for (Index_t i = 0 ; i < length ; ++i){
       Index_t ielem = regElemList[i];
 
@@ -2161,7 +3045,7 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
          if ( ssc <= Real_t(.1111111e-36) ) {
             ssc = Real_t(.3333333e-18) ;
          } else {
-            ssc = SQRT(ssc) ;
+            ssc = FASTSQRT(ssc) ;
          }
 
          q_new[i] = (ssc*ql_old[i] + qq_old[i]) ;
@@ -2184,7 +3068,6 @@ void CalcSoundSpeedForElems(Domain &domain,
                             Real_t *bvc, Real_t ss4o3,
                             Index_t len, Index_t *regElemList)
 {
-#pragma omp parallel for firstprivate(rho0, ss4o3)
    for (Index_t i = 0; i < len ; ++i) {
       Index_t ielem = regElemList[i];
       Real_t ssTmp = (pbvc[i] * enewc[i] + vnewc[ielem] * vnewc[ielem] *
@@ -2193,7 +3076,7 @@ void CalcSoundSpeedForElems(Domain &domain,
          ssTmp = Real_t(.3333333e-18);
       }
       else {
-         ssTmp = SQRT(ssTmp);
+         ssTmp = FASTSQRT(ssTmp);
       }
       domain.ss(ielem) = ssTmp ;
    }
@@ -2201,6 +3084,9 @@ void CalcSoundSpeedForElems(Domain &domain,
 
 /******************************************/
 
+/* Evaluates the EOS for numElemReg elements of a region (or a piece of
+ * one) on the calling thread.  Elements are independent, so any split of
+ * the element list gives the same result. */
 static inline
 void EvalEOSForElems(Domain& domain, Real_t *vnewc,
                      Int_t numElemReg, Index_t *regElemList, Int_t rep)
@@ -2237,55 +3123,48 @@ void EvalEOSForElems(Domain& domain, Real_t *vnewc,
    //loop to add load imbalance based on region number 
    for(Int_t j = 0; j < rep; j++) {
       /* compress data, minimal set */
-#pragma omp parallel
-      {
-#pragma omp for nowait firstprivate(numElemReg)
-         for (Index_t i=0; i<numElemReg; ++i) {
-            Index_t ielem = regElemList[i];
-            e_old[i] = domain.e(ielem) ;
-            delvc[i] = domain.delv(ielem) ;
-            p_old[i] = domain.p(ielem) ;
-            q_old[i] = domain.q(ielem) ;
-            qq_old[i] = domain.qq(ielem) ;
-            ql_old[i] = domain.ql(ielem) ;
-         }
+      for (Index_t i=0; i<numElemReg; ++i) {
+         Index_t ielem = regElemList[i];
+         e_old[i] = domain.e(ielem) ;
+         delvc[i] = domain.delv(ielem) ;
+         p_old[i] = domain.p(ielem) ;
+         q_old[i] = domain.q(ielem) ;
+         qq_old[i] = domain.qq(ielem) ;
+         ql_old[i] = domain.ql(ielem) ;
+      }
 
-#pragma omp for firstprivate(numElemReg)
-         for (Index_t i = 0; i < numElemReg ; ++i) {
-            Index_t ielem = regElemList[i];
-            Real_t vchalf ;
-            compression[i] = Real_t(1.) / vnewc[ielem] - Real_t(1.);
-            vchalf = vnewc[ielem] - delvc[i] * Real_t(.5);
-            compHalfStep[i] = Real_t(1.) / vchalf - Real_t(1.);
-         }
+      for (Index_t i = 0; i < numElemReg ; ++i) {
+         Index_t ielem = regElemList[i];
+         Real_t vchalf ;
+         compression[i] = Real_t(1.) / vnewc[ielem] - Real_t(1.);
+         vchalf = vnewc[ielem] - delvc[i] * Real_t(.5);
+         compHalfStep[i] = Real_t(1.) / vchalf - Real_t(1.);
+      }
 
       /* Check for v > eosvmax or v < eosvmin */
-         if ( eosvmin != Real_t(0.) ) {
-#pragma omp for nowait firstprivate(numElemReg, eosvmin)
-            for(Index_t i=0 ; i<numElemReg ; ++i) {
-               Index_t ielem = regElemList[i];
-               if (vnewc[ielem] <= eosvmin) { /* impossible due to calling func? */
-                  compHalfStep[i] = compression[i] ;
-               }
+      if ( eosvmin != Real_t(0.) ) {
+         for(Index_t i=0 ; i<numElemReg ; ++i) {
+            Index_t ielem = regElemList[i];
+            if (vnewc[ielem] <= eosvmin) { /* impossible due to calling func? */
+               compHalfStep[i] = compression[i] ;
             }
          }
-         if ( eosvmax != Real_t(0.) ) {
-#pragma omp for nowait firstprivate(numElemReg, eosvmax)
-            for(Index_t i=0 ; i<numElemReg ; ++i) {
-               Index_t ielem = regElemList[i];
-               if (vnewc[ielem] >= eosvmax) { /* impossible due to calling func? */
-                  p_old[i]        = Real_t(0.) ;
-                  compression[i]  = Real_t(0.) ;
-                  compHalfStep[i] = Real_t(0.) ;
-               }
+      }
+      if ( eosvmax != Real_t(0.) ) {
+         for(Index_t i=0 ; i<numElemReg ; ++i) {
+            Index_t ielem = regElemList[i];
+            if (vnewc[ielem] >= eosvmax) { /* impossible due to calling func? */
+               p_old[i]        = Real_t(0.) ;
+               compression[i]  = Real_t(0.) ;
+               compHalfStep[i] = Real_t(0.) ;
             }
          }
+      }
 
-#pragma omp for nowait firstprivate(numElemReg)
-         for (Index_t i = 0 ; i < numElemReg ; ++i) {
-            work[i] = Real_t(0.) ; 
-         }
+      for (Index_t i = 0 ; i < numElemReg ; ++i) {
+         work[i] = Real_t(0.) ; 
       }
+
       CalcEnergyForElems(p_new, e_new, q_new, bvc, pbvc,
                          p_old, e_old,  q_old, compression, compHalfStep,
                          vnewc, work,  delvc, pmin,
@@ -2294,7 +3173,6 @@ void EvalEOSForElems(Domain& domain, Real_t *vnewc,
                          numElemReg, regElemList);
    }
 
-#pragma omp parallel for firstprivate(numElemReg)
    for (Index_t i=0; i<numElemReg; ++i) {
       Index_t ielem = regElemList[i];
       domain.p(ielem) = p_new[i] ;
@@ -2325,6 +3203,389 @@ void EvalEOSForElems(Domain& domain, Real_t *vnewc,
 
 /******************************************/
 
+static inline
+Int_t CalcRegionRep(Domain& domain, Int_t r)
+{
+   Int_t rep;
+   //Determine load imbalance for this region
+   //round down the number with lowest cost
+   if(r < domain.numReg()/2)
+     rep = 1;
+   //you don't get an expensive region unless you at least have 5 regions
+   else if(r < (domain.numReg() - (domain.numReg()+15)/20))
+     rep = 1 + domain.cost();
+   //very expensive regions
+   else
+     rep = 10 * (1+ domain.cost());
+   return rep ;
+}
+
+/******************************************/
+
+static void EvalEOSTask(void *arg)
+{
+   EOSTask_t *task = static_cast<EOSTask_t *>(arg) ;
+   EvalEOSForElems(*task->domain, task->vnewc, task->len,
+                   task->elems, task->rep) ;
+}
+
+static inline
+bool RegionCheaper(const std::pair<Int_t, Int_t> &a,
+                   const std::pair<Int_t, Int_t> &b)
+{
+   return a.first < b.first ;
+}
+
+static inline
+bool EOSTaskHeavier(const EOSTask_t &a, const EOSTask_t &b)
+{
+   return (a.weight > b.weight) ||
+          (a.weight == b.weight && a.reg < b.reg) ||
+          (a.weight == b.weight && a.reg == b.reg && a.start < b.start) ;
+}
+
+/* Cuts the regions into EOS tasks, heaviest first.  Regions lighter
+ * than the target task weight (total / (EOS_TASKS_PER_THREAD*threads))
+ * stay whole and run on a single thread; heavier regions are split into
+ * pieces of roughly the target weight, but no smaller than the small
+ * region cutoff (EOS_MIN_TASK_ELEMS until it is measured).  With -batch
+ * the regions below the cutoff are grouped by rep into tasks of up to
+ * the target weight instead.  The region lists do not change, so this
+ * runs in the first cycle and once more after the cutoffs are measured;
+ * the tasks and the batched element lists are kept in the domain. */
+static inline
+void BuildEOSTasks(Domain& domain)
+{
+   std::vector<EOSTask_t> &tasks = domain.eosTasks() ;
+   std::vector<Index_t> &batchElems = domain.eosBatchElems() ;
+   SmallRegion_t &small = domain.smallRegions() ;
+   const bool batch = (domain.regionBatch() != 0) ;
+   const Index_t cutoff = small.eosCutoff ;
+   Int_t numThreads = ParNumThreads() ;
+   Int_t numReg = domain.numReg() ;
+   Int8_t totalWeight = 0 ;
+
+   // (rep, region) of the regions to batch
+   std::vector<std::pair<Int_t, Int_t> > smallReg ;
+   Index_t numBatchElem = 0 ;
+
+   for (Int_t r=0 ; r<numReg ; ++r) {
+      totalWeight += Int8_t(domain.regElemSize(r)) * CalcRegionRep(domain, r) ;
+   }
+
+   Int8_t target = totalWeight / (Int8_t(EOS_TASKS_PER_THREAD)*numThreads) ;
+   if (target < 1) {
+      target = 1 ;
+   }
+
+   tasks.clear() ;
+   for (Int_t r=0 ; r<numReg ; ++r) {
+      Index_t size = domain.regElemSize(r) ;
+      Int_t rep = CalcRegionRep(domain, r) ;
+      if (size == 0) {
+         continue ;
+      }
+      if (batch && size < cutoff) {
+         smallReg.push_back(std::make_pair(rep, r)) ;
+         numBatchElem += size ;
+         continue ;
+      }
+      Int8_t numPieces = (Int8_t(size)*rep + target - 1) / target ;
+      Int8_t maxPieces = (size + cutoff - 1) / cutoff ;
+      if (numPieces > maxPieces) {
+         numPieces = maxPieces ;
+      }
+      if (numThreads == 1 || numPieces < 1) {
+         numPieces = 1 ;
+      }
+      for (Int8_t p=0 ; p<numPieces ; ++p) {
+         EOSTask_t task ;
+         task.reg = r ;
+         task.start = Index_t((p*size)/numPieces) ;
+         task.len = Index_t(((p+1)*size)/numPieces) - task.start ;
+         task.rep = rep ;
+         task.weight = Int8_t(task.len) * rep ;
+         task.elems = domain.regElemlist(r) + task.start ;
+         task.domain = &domain ;
+         task.vnewc = NULL ;
+         tasks.push_back(task) ;
+      }
+   }
+
+   // batches of small regions of equal rep, in region order
+   std::stable_sort(smallReg.begin(), smallReg.end(), RegionCheaper) ;
+   batchElems.resize(numBatchElem) ;
+   small.eosBatched = Int_t(smallReg.size()) ;
+   small.eosBatches = 0 ;
+   Index_t offset = 0 ;
+   for (size_t i=0 ; i<smallReg.size() ; ) {
+      EOSTask_t task ;
+      task.reg = smallReg[i].second ;
+      task.start = offset ;
+      task.len = 0 ;
+      task.rep = smallReg[i].first ;
+      task.weight = 0 ;
+      do {
+         Int_t r = smallReg[i].second ;
+         Index_t size = domain.regElemSize(r) ;
+         std::copy(domain.regElemlist(r), domain.regElemlist(r) + size,
+                   batchElems.begin() + offset) ;
+         offset += size ;
+         task.len += size ;
+         task.weight += Int8_t(size) * task.rep ;
+         ++i ;
+      } while (i < smallReg.size() && smallReg[i].first == task.rep &&
+               task.weight < target) ;
+      task.elems = &batchElems[task.start] ;
+      task.domain = &domain ;
+      task.vnewc = NULL ;
+      tasks.push_back(task) ;
+      ++small.eosBatches ;
+   }
+
+   std::sort(tasks.begin(), tasks.end(), EOSTaskHeavier) ;
+}
+
+/******************************************/
+
+/*
+ * Cost-weighted static EOS partitioning (-part).  During the first
+ * window of PART_WINDOW_CYCLES cycles the concatenated region element
+ * lists are cut into one contiguous piece per thread with equal element
+ * counts, as schedule(static) would, and every thread times each region
+ * piece it evaluates.  The measured time per element of each region
+ * then weights a new cut of equal measured cost.  Timing goes on; at
+ * the end of every later window the current cut is re-evaluated with
+ * the new costs and rebuilt if its predicted imbalance (max/mean thread
+ * time) exceeds PART_DRIFT_TOL.  Elements are independent, so the cut
+ * does not change results.
+ */
+/* Cuts the concatenated region lists into ParNumThreads() contiguous
+ * pieces of equal weight; regWeight is the weight of one element of
+ * each region. */
+static void BuildEOSPartition(Domain& domain, const std::vector<double>& regWeight,
+                              EOSPartition_t& part)
+{
+   Int_t numThreads = ParNumThreads() ;
+   Int_t numReg = domain.numReg() ;
+   Index_t numElem = 0 ;
+
+   for (Int_t r=0 ; r<numReg ; ++r) {
+      numElem += domain.regElemSize(r) ;
+   }
+
+   // weight of the first k elements of the concatenated lists
+   std::vector<double> prefix(numElem + 1) ;
+   Index_t k = 0 ;
+   prefix[0] = 0.0 ;
+   for (Int_t r=0 ; r<numReg ; ++r) {
+      for (Index_t i=0 ; i<domain.regElemSize(r) ; ++i, ++k) {
+         prefix[k+1] = prefix[k] + regWeight[r] ;
+      }
+   }
+
+   std::vector<Index_t> bound(numThreads + 1) ;
+   bound[0] = 0 ;
+   bound[numThreads] = numElem ;
+   for (Int_t t=1 ; t<numThreads ; ++t) {
+      double target = prefix[numElem]*double(t)/double(numThreads) ;
+      bound[t] = Index_t(std::lower_bound(prefix.begin(), prefix.end(), target)
+                         - prefix.begin()) ;
+      if (bound[t] < bound[t-1]) {
+         bound[t] = bound[t-1] ;
+      }
+   }
+
+   part.piece.clear() ;
+   part.first.assign(numThreads + 1, 0) ;
+   for (Int_t t=0 ; t<numThreads ; ++t) {
+      Index_t regBegin = 0 ;
+      for (Int_t r=0 ; r<numReg ; ++r) {
+         Index_t regEnd = regBegin + domain.regElemSize(r) ;
+         Index_t b = std::max(bound[t], regBegin) ;
+         Index_t e = std::min(bound[t+1], regEnd) ;
+         if (b < e) {
+            EOSTask_t piece ;
+            piece.reg = r ;
+            piece.start = b - regBegin ;
+            piece.len = e - b ;
+            piece.rep = CalcRegionRep(domain, r) ;
+            piece.weight = Int8_t(piece.len) * piece.rep ;
+            piece.elems = domain.regElemlist(r) + piece.start ;
+            piece.domain = &domain ;
+            piece.vnewc = NULL ;
+            part.piece.push_back(piece) ;
+         }
+         regBegin = regEnd ;
+      }
+      part.first[t+1] = Int_t(part.piece.size()) ;
+   }
+}
+
+/* Max over mean of the per-thread times */
+static double PartImbalance(const std::vector<double>& thrTime)
+{
+   double maxTime = 0.0 ;
+   double sumTime = 0.0 ;
+   for (size_t t=0 ; t<thrTime.size() ; ++t) {
+      maxTime = std::max(maxTime, thrTime[t]) ;
+      sumTime += thrTime[t] ;
+   }
+   return (sumTime > 0.0) ? maxTime*double(thrTime.size())/sumTime : 1.0 ;
+}
+
+/* End of a measurement window: update the region costs, and switch to
+ * (or rebuild) the cost-weighted cut */
+static void UpdateEOSPartition(Domain& domain, EOSPartition_t& part)
+{
+   Int_t numThreads = ParNumThreads() ;
+   Int_t numReg = domain.numReg() ;
+   double imbalance = PartImbalance(part.thrTime) ;
+
+   for (Int_t r=0 ; r<numReg ; ++r) {
+      double time = 0.0 ;
+      for (Int_t t=0 ; t<numThreads ; ++t) {
+         time += part.regTime[t*numReg + r] ;
+      }
+      Index_t size = domain.regElemSize(r) ;
+      if (size > 0 && time > 0.0) {
+         part.cost[r] = time / (double(size)*double(part.windowCycles)) ;
+      }
+   }
+
+   if (!part.weighted) {
+      part.imbalanceCount = imbalance ;
+      BuildEOSPartition(domain, part.cost, part) ;
+      part.weighted = true ;
+   }
+   else {
+      part.imbalanceCost = imbalance ;
+
+      // how the current cut fares with the new costs
+      std::vector<double> predicted(numThreads, 0.0) ;
+      for (Int_t t=0 ; t<numThreads ; ++t) {
+         for (Int_t p=part.first[t] ; p<part.first[t+1] ; ++p) {
+            predicted[t] += double(part.piece[p].len)*part.cost[part.piece[p].reg] ;
+         }
+      }
+      if (PartImbalance(predicted) > PART_DRIFT_TOL) {
+         BuildEOSPartition(domain, part.cost, part) ;
+         ++part.numRebuild ;
+      }
+   }
+
+   part.regTime.assign(numThreads*numReg, 0.0) ;
+   part.thrTime.assign(numThreads, 0.0) ;
+   part.windowCycles = 0 ;
+}
+
+/* Evaluates this thread's part of the EOS; called by every thread */
+static void EvalEOSPartition(Domain& domain, Real_t *vnewc)
+{
+   EOSPartition_t &part = domain.eosPartitionState() ;
+   Int_t tid = ParThreadId() ;
+   Int_t numReg = domain.numReg() ;
+
+   if (tid == 0 && part.first.empty()) {
+      Int_t numThreads = ParNumThreads() ;
+      part.regTime.assign(numThreads*numReg, 0.0) ;
+      part.thrTime.assign(numThreads, 0.0) ;
+      part.cost.assign(numReg, 1.0) ;
+      part.windowCycles = 0 ;
+      part.numRebuild = 0 ;
+      part.weighted = false ;
+      part.imbalanceCount = -1.0 ;
+      part.imbalanceCost = -1.0 ;
+      BuildEOSPartition(domain, part.cost, part) ;
+   }
+   ParBarrier() ;
+
+   double start = WallClock() ;
+   for (Int_t p=part.first[tid] ; p<part.first[tid+1] ; ++p) {
+      const EOSTask_t &piece = part.piece[p] ;
+      double pieceStart = WallClock() ;
+      EvalEOSForElems(domain, vnewc, piece.len, piece.elems, piece.rep) ;
+      part.regTime[tid*numReg + piece.reg] += WallClock() - pieceStart ;
+   }
+   part.thrTime[tid] += WallClock() - start ;
+   ParBarrier() ;
+
+   if (tid == 0 && ++part.windowCycles == PART_WINDOW_CYCLES) {
+      UpdateEOSPartition(domain, part) ;
+   }
+}
+
+/* Prints the EOS imbalance with the count-based and the cost-weighted
+ * cut (worst rank) */
+static void ReportEOSPartition(Domain& domain, Int_t myRank)
+{
+   const EOSPartition_t &part = domain.eosPartitionState() ;
+   double local[3] = { part.imbalanceCount, part.imbalanceCost,
+                       double(part.numRebuild) } ;
+   double global[3] ;
+#if USE_MPI
+   MPI_Reduce(local, global, 3, MPI_DOUBLE, MPI_MAX, 0, domain.comm) ;
+#else
+   for (Int_t i=0 ; i<3 ; ++i) {
+      global[i] = local[i] ;
+   }
+#endif
+   if (myRank == 0) {
+      printf("EOS partition imbalance (max/mean thread time)\n") ;
+      if (global[0] > 0.0) {
+         printf("   count-based cut     = %.3f\n", global[0]) ;
+      }
+      if (global[1] > 0.0) {
+         printf("   cost-weighted cut   = %.3f (%d rebuilds)\n",
+                global[1], int(global[2])) ;
+      }
+      else {
+         printf("   run too short for a cost-weighted window (%d cycles each)\n",
+                int(PART_WINDOW_CYCLES)) ;
+      }
+      printf("\n") ;
+   }
+}
+
+/******************************************/
+
+/* Called by thread 0 after the EOS of the first cycle, which took
+ * eosTime seconds: the cutoffs are the region sizes whose work equals
+ * the overhead of splitting them (a team barrier for the monotonic q,
+ * an EOS call for the EOS) */
+static void SetSmallRegionCutoffs(Domain& domain,
+                                  const std::vector<EOSTask_t>& tasks,
+                                  double eosTime)
+{
+   SmallRegion_t &small = domain.smallRegions() ;
+   Int8_t weight = 0 ;
+
+   for (size_t t=0 ; t<tasks.size() ; ++t) {
+      weight += tasks[t].weight ;
+   }
+   double busy = eosTime*double(ParNumThreads()) -
+                 double(tasks.size())*small.callCost ;
+   if (weight > 0 && busy > 0.0) {
+      small.eosElemCost = busy / double(weight) ;
+   }
+
+   Index_t numElem = domain.numElem() ;
+   if (small.monoqElemCost > 0.0) {
+      double cutoff = small.barrierCost / small.monoqElemCost ;
+      small.monoqCutoff = Index_t(std::min(cutoff, double(numElem))) ;
+   }
+   if (small.eosElemCost > 0.0) {
+      double cutoff = small.callCost / small.eosElemCost ;
+      small.eosCutoff = Index_t(std::min(cutoff, double(numElem))) ;
+   }
+   if (small.eosCutoff < 1) {
+      small.eosCutoff = 1 ;
+   }
+   small.measured = true ;
+}
+
+/******************************************/
+
 static inline
 void ApplyMaterialPropertiesForElems(Domain& domain)
 {
@@ -2334,74 +3595,91 @@ void ApplyMaterialPropertiesForElems(Domain& domain)
     /* Expose all of the variables needed for material evaluation */
     Real_t eosvmin = domain.eosvmin() ;
     Real_t eosvmax = domain.eosvmax() ;
-    Real_t *vnewc = Allocate<Real_t>(numElem) ;
+    Real_t *vnewc ;
 
-#pragma omp parallel
-    {
-#pragma omp for firstprivate(numElem)
-       for(Index_t i=0 ; i<numElem ; ++i) {
-          vnewc[i] = domain.vnew(i) ;
+    vnewc = ParAllocate<Real_t>(numElem) ;
+
+    Index_t iBegin, iEnd ;
+    ParRange(0, numElem, &iBegin, &iEnd) ;
+    for (Index_t i=iBegin ; i<iEnd ; ++i) {
+       vnewc[i] = domain.vnew(i) ;
+    }
+    ParBarrier() ;
+
+    // Bound the updated relative volumes with eosvmin/max
+    if (eosvmin != Real_t(0.)) {
+       for (Index_t i=iBegin ; i<iEnd ; ++i) {
+          if (vnewc[i] < eosvmin)
+             vnewc[i] = eosvmin ;
        }
+    }
 
-       // Bound the updated relative volumes with eosvmin/max
-       if (eosvmin != Real_t(0.)) {
-#pragma omp for nowait firstprivate(numElem)
-          for(Index_t i=0 ; i<numElem ; ++i) {
-             if (vnewc[i] < eosvmin)
-                vnewc[i] = eosvmin ;
-          }
+    if (eosvmax != Real_t(0.)) {
+       for (Index_t i=iBegin ; i<iEnd ; ++i) {
+          if (vnewc[i] > eosvmax)
+             vnewc[i] = eosvmax ;
        }
+    }
 
+    // This check may not make perfect sense in LULESH, but
+    // it's representative of something in the full code -
+    // just leave it in, please
+    for (Index_t i=iBegin ; i<iEnd ; ++i) {
+       Real_t vc = domain.v(i) ;
+       if (eosvmin != Real_t(0.)) {
+          if (vc < eosvmin)
+             vc = eosvmin ;
+       }
        if (eosvmax != Real_t(0.)) {
-#pragma omp for nowait firstprivate(numElem)
-          for(Index_t i=0 ; i<numElem ; ++i) {
-             if (vnewc[i] > eosvmax)
-                vnewc[i] = eosvmax ;
-          }
+          if (vc > eosvmax)
+             vc = eosvmax ;
        }
-
-       // This check may not make perfect sense in LULESH, but
-       // it's representative of something in the full code -
-       // just leave it in, please
-#pragma omp for nowait firstprivate(numElem)
-       for (Index_t i=0; i<numElem; ++i) {
-          Real_t vc = domain.v(i) ;
-          if (eosvmin != Real_t(0.)) {
-             if (vc < eosvmin)
-                vc = eosvmin ;
-          }
-          if (eosvmax != Real_t(0.)) {
-             if (vc > eosvmax)
-                vc = eosvmax ;
-          }
-          if (vc <= 0.) {
+       if (vc <= 0.) {
 #if USE_MPI
-             MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+          MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
 #else
-             exit(VolumeError);
+          exit(VolumeError);
 #endif
-          }
        }
     }
 
-    for (Int_t r=0 ; r<domain.numReg() ; r++) {
-       Index_t numElemReg = domain.regElemSize(r);
-       Index_t *regElemList = domain.regElemlist(r);
-       Int_t rep;
-       //Determine load imbalance for this region
-       //round down the number with lowest cost
-       if(r < domain.numReg()/2)
-	 rep = 1;
-       //you don't get an expensive region unless you at least have 5 regions
-       else if(r < (domain.numReg() - (domain.numReg()+15)/20))
-         rep = 1 + domain.cost();
-       //very expensive regions
-       else
-	 rep = 10 * (1+ domain.cost());
-       EvalEOSForElems(domain, vnewc, numElemReg, regElemList, rep);
+    // vnewc is read through region index lists below
+    ParBarrier() ;
+
+    if (domain.eosPartition()) {
+       EvalEOSPartition(domain, vnewc) ;
+       if (ParThreadId() == 0) {
+          Release(&vnewc) ;
+       }
+       return ;
     }
 
-    Release(&vnewc) ;
+    std::vector<EOSTask_t> &tasks = domain.eosTasks() ;
+    double start = WallClock() ;
+
+    if (ParThreadId() == 0) {
+       if (tasks.empty()) {
+          BuildEOSTasks(domain) ;
+       }
+       Int_t numTasks = Int_t(tasks.size()) ;
+
+       // tasks are created longest-first; idle threads of the team pick
+       // them up at the task barrier below
+       for (Int_t t=0 ; t<numTasks ; ++t) {
+          tasks[t].vnewc = vnewc ;
+          ParTaskSpawn(EvalEOSTask, &tasks[t]) ;
+       }
+    }
+    ParTaskBarrier() ;
+
+    if (ParThreadId() == 0) {
+       Release(&vnewc) ;
+       if (!domain.smallRegions().measured) {
+          SetSmallRegionCutoffs(domain, tasks, WallClock() - start) ;
+          // cut again with the measured cutoffs next cycle
+          tasks.clear() ;
+       }
+    }
   }
 }
 
@@ -2412,8 +3690,9 @@ void UpdateVolumesForElems(Domain &domain,
                            Real_t v_cut, Index_t length)
 {
    if (length != 0) {
-#pragma omp parallel for firstprivate(length, v_cut)
-      for(Index_t i=0 ; i<length ; ++i) {
+      Index_t iBegin, iEnd ;
+      ParRange(0, length, &iBegin, &iEnd) ;
+      for (Index_t i=iBegin ; i<iEnd ; ++i) {
          Real_t tmpV = domain.vnew(i) ;
 
          if ( FABS(tmpV - Real_t(1.0)) < v_cut )
@@ -2421,6 +3700,7 @@ void UpdateVolumesForElems(Domain &domain,
 
          domain.v(i) = tmpV ;
       }
+      ParBarrier() ;
    }
 
    return ;
@@ -2445,161 +3725,496 @@ void LagrangeElements(Domain& domain, Index_t numElem)
 /******************************************/
 
 static inline
-void CalcCourantConstraintForElems(Domain &domain, Index_t length,
-                                   Index_t *regElemlist,
-                                   Real_t qqc, Real_t& dtcourant)
+void MinLocCombine(MinLoc_t &out, const MinLoc_t &in)
 {
-#if _OPENMP
-   const Index_t threads = omp_get_max_threads();
-   Index_t courant_elem_per_thread[threads];
-   Real_t dtcourant_per_thread[threads];
-#else
-   Index_t threads = 1;
-   Index_t courant_elem_per_thread[1];
-   Real_t  dtcourant_per_thread[1];
-#endif
+   if (in.val < out.val || (in.val == out.val && in.loc >= 0 &&
+                            (out.loc < 0 || in.loc < out.loc))) {
+      out = in ;
+   }
+}
 
-#pragma omp parallel firstprivate(length, qqc)
-   {
-      Real_t   qqc2 = Real_t(64.0) * qqc * qqc ;
-      Real_t   dtcourant_tmp = dtcourant;
-      Index_t  courant_elem  = -1 ;
+/******************************************/
 
-#if _OPENMP
-      Index_t thread_num = omp_get_thread_num();
-#else
-      Index_t thread_num = 0;
-#endif      
+/* Courant and hydro constraints of the elements [begin, end), combined
+ * into courant and hydro.  The update is written with selects so the
+ * lane loop vectorizes: every lane computes both constraints and keeps
+ * them only where vdov != 0.  Within a lane the indices increase and
+ * only a strictly smaller value replaces the minimum, so after
+ * MinLocCombine the result is the first minimum, as in a sequential
+ * scan. */
+static inline
+void CalcTimeConstraintsForRange(const Real_t *ss, const Real_t *vdov,
+                                 const Real_t *arealg,
+                                 Index_t begin, Index_t end,
+                                 Real_t qqc2, Real_t dvovmax,
+                                 MinLoc_t &courant, MinLoc_t &hydro)
+{
+   Real_t  courantVal[DT_LANES], hydroVal[DT_LANES] ;
+   Index_t courantLoc[DT_LANES], hydroLoc[DT_LANES] ;
+
+   for (Index_t l=0 ; l<DT_LANES ; ++l) {
+      courantVal[l] = Real_t(1.0e+20) ; courantLoc[l] = -1 ;
+      hydroVal[l]   = Real_t(1.0e+20) ; hydroLoc[l]   = -1 ;
+   }
 
-#pragma omp for 
-      for (Index_t i = 0 ; i < length ; ++i) {
-         Index_t indx = regElemlist[i] ;
-         Real_t dtf = domain.ss(indx) * domain.ss(indx) ;
+   for (Index_t i0=begin ; i0<end ; i0+=DT_LANES) {
+      const Index_t len = std::min(Index_t(DT_LANES), end - i0) ;
+#pragma omp simd
+      for (Index_t l=0 ; l<len ; ++l) {
+         const Index_t i = i0 + l ;
+         const Real_t ssi = ss[i] ;
+         const Real_t vdovi = vdov[i] ;
+         const Real_t areai = arealg[i] ;
+
+         /* evaluate time constraint; the q term is zero unless the
+          * element is compressed, and adding it is then exact */
+         Real_t vneg = (vdovi < Real_t(0.)) ? vdovi : Real_t(0.) ;
+         Real_t dtf = ssi * ssi + qqc2 * areai * areai * vneg * vneg ;
+         dtf = FASTDIVSQRT(areai, dtf) ;
+
+         /* check hydro constraint */
+         Real_t dtdvov = dvovmax / (FABS(vdovi)+Real_t(1.e-20)) ;
+
+         bool active = (vdovi != Real_t(0.)) ;
+         bool newCourant = active & (dtf < courantVal[l]) ;
+         bool newHydro = active & (dtdvov < hydroVal[l]) ;
+         courantVal[l] = newCourant ? dtf : courantVal[l] ;
+         courantLoc[l] = newCourant ? i : courantLoc[l] ;
+         hydroVal[l] = newHydro ? dtdvov : hydroVal[l] ;
+         hydroLoc[l] = newHydro ? i : hydroLoc[l] ;
+      }
+   }
 
-         if ( domain.vdov(indx) < Real_t(0.) ) {
-            dtf = dtf
-                + qqc2 * domain.arealg(indx) * domain.arealg(indx)
-                * domain.vdov(indx) * domain.vdov(indx) ;
-         }
+   for (Index_t l=0 ; l<DT_LANES ; ++l) {
+      MinLoc_t lane ;
+      lane.val = courantVal[l] ; lane.loc = courantLoc[l] ;
+      MinLocCombine(courant, lane) ;
+      lane.val = hydroVal[l] ; lane.loc = hydroLoc[l] ;
+      MinLocCombine(hydro, lane) ;
+   }
+}
 
-         dtf = SQRT(dtf) ;
-         dtf = domain.arealg(indx) / dtf ;
+/******************************************/
 
-         if (domain.vdov(indx) != Real_t(0.)) {
-            if ( dtf < dtcourant_tmp ) {
-               dtcourant_tmp = dtf ;
-               courant_elem  = indx ;
-            }
-         }
-      }
+static inline
+void CalcTimeConstraintsForElems(Domain& domain) {
 
-      dtcourant_per_thread[thread_num]    = dtcourant_tmp ;
-      courant_elem_per_thread[thread_num] = courant_elem ;
+   // The regions partition the element set, and qqc and dvovmax do not
+   // depend on the region, so both constraints are computed in a single
+   // pass over all elements.
+   Index_t numElem = domain.numElem() ;
+   Real_t qqc2 = Real_t(64.0) * domain.qqc() * domain.qqc() ;
+   Real_t dvovmax = domain.dvovmax() ;
+
+   // per-thread results, combined in thread order by thread 0
+   std::vector<MinLoc_t> &partial = domain.dtPartial() ;
+   Int_t tid = ParThreadId() ;
+
+   if (tid == 0) {
+      partial.resize(2*ParNumThreads()) ;
    }
+   ParBarrier() ;
 
-   for (Index_t i = 1; i < threads; ++i) {
-      if (dtcourant_per_thread[i] < dtcourant_per_thread[0] ) {
-         dtcourant_per_thread[0]    = dtcourant_per_thread[i];
-         courant_elem_per_thread[0] = courant_elem_per_thread[i];
+   // Initialize conditions to a very large value
+   MinLoc_t courant, hydro ;
+   courant.val = Real_t(1.0e+20) ; courant.loc = -1 ;
+   hydro.val   = Real_t(1.0e+20) ; hydro.loc   = -1 ;
+
+   Index_t iBegin, iEnd ;
+   ParRange(0, numElem, &iBegin, &iEnd) ;
+   CalcTimeConstraintsForRange(&domain.ss(0), &domain.vdov(0),
+                               &domain.arealg(0), iBegin, iEnd,
+                               qqc2, dvovmax, courant, hydro) ;
+   partial[2*tid] = courant ;
+   partial[2*tid+1] = hydro ;
+   ParBarrier() ;
+
+   if (tid == 0) {
+      for (Int_t t=1 ; t<ParNumThreads() ; ++t) {
+         MinLocCombine(courant, partial[2*t]) ;
+         MinLocCombine(hydro, partial[2*t+1]) ;
       }
+      domain.dtcourant() = courant.val ;
+      domain.dthydro() = hydro.val ;
    }
+}
 
-   if (courant_elem_per_thread[0] != -1) {
-      dtcourant = dtcourant_per_thread[0] ;
-   }
+/******************************************/
 
-   return ;
+/*
+ * Task-graph (-tg) version of the element phase.  The elements are cut
+ * into blocks of whole z-planes and each block goes through two tasks
+ *
+ *   grad[b] : kinematics, strain rate, EOS volume bounds, velocity
+ *             gradients for the monotonic q
+ *   q[b]    : monotonic q limiter, EOS of every region piece in the
+ *             block, volume update, partial time constraints
+ *
+ * The limiter only looks one element away, so q[b] may start as soon as
+ * grad[b-1], grad[b] and grad[b+1] are done, instead of waiting for the
+ * whole mesh at a barrier: each block counts its missing neighbor
+ * gradients, and the grad task that brings the count to zero spawns
+ * q[b].  With more than one rank the MonoQ gradient exchange is still a
+ * synchronization point between the two stages.
+ */
+
+static inline
+void CalcKinematicsForElemRange(Domain& domain, Real_t *vnewc,
+                                Index_t begin, Index_t end)
+{
+   const Real_t deltatime = domain.deltatime() ;
+   const bool halfStep = (domain.halfStepCoords() != 0) ;
+   Real_t eosvmin = domain.eosvmin() ;
+   Real_t eosvmax = domain.eosvmax() ;
+
+   for (Index_t k0=begin ; k0<end ; k0+=KIN_BATCH_SIZE) {
+      const Index_t len = std::min(Index_t(KIN_BATCH_SIZE), end - k0) ;
+      CalcKinematicsForElemBatch(domain, deltatime, k0, len, halfStep) ;
+   }
 
+   for (Index_t k=begin ; k<end ; ++k) {
+      CalcDeviatoricStrainForElem(domain, k) ;
+
+      // same bounds and check as ApplyMaterialPropertiesForElems
+      Real_t vnewk = domain.vnew(k) ;
+      Real_t vc = domain.v(k) ;
+      if (eosvmin != Real_t(0.)) {
+         if (vnewk < eosvmin)
+            vnewk = eosvmin ;
+         if (vc < eosvmin)
+            vc = eosvmin ;
+      }
+      if (eosvmax != Real_t(0.)) {
+         if (vnewk > eosvmax)
+            vnewk = eosvmax ;
+         if (vc > eosvmax)
+            vc = eosvmax ;
+      }
+      vnewc[k] = vnewk ;
+      if (vc <= 0.) {
+#if USE_MPI
+         MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+         exit(VolumeError);
+#endif
+      }
+   }
 }
 
 /******************************************/
 
 static inline
-void CalcHydroConstraintForElems(Domain &domain, Index_t length,
-                                 Index_t *regElemlist, Real_t dvovmax, Real_t& dthydro)
+void CalcMonotonicQForElemRange(Domain& domain, Index_t begin, Index_t end)
 {
-#if _OPENMP
-   const Index_t threads = omp_get_max_threads();
-   Index_t hydro_elem_per_thread[threads];
-   Real_t dthydro_per_thread[threads];
+   const Real_t ptiny = Real_t(1.e-36) ;
+   Real_t monoq_limiter_mult = domain.monoq_limiter_mult();
+   Real_t monoq_max_slope = domain.monoq_max_slope();
+   Real_t qlc_monoq = domain.qlc_monoq();
+   Real_t qqc_monoq = domain.qqc_monoq();
+
+   for (Index_t i=begin ; i<end ; ++i) {
+      CalcMonotonicQForElem(domain, i, ptiny, qlc_monoq, qqc_monoq,
+                            monoq_limiter_mult, monoq_max_slope) ;
+   }
+
+   /* Don't allow excessive artificial viscosity */
+   for (Index_t i=begin ; i<end ; ++i) {
+      if ( domain.q(i) > domain.qstop() ) {
+#if USE_MPI         
+         MPI_Abort(MPI_COMM_WORLD, QStopError) ;
 #else
-   Index_t threads = 1;
-   Index_t hydro_elem_per_thread[1];
-   Real_t  dthydro_per_thread[1];
+         exit(QStopError);
 #endif
+      }
+   }
+}
 
-#pragma omp parallel firstprivate(length, dvovmax)
-   {
-      Real_t dthydro_tmp = dthydro ;
-      Index_t hydro_elem = -1 ;
+/******************************************/
 
-#if _OPENMP
-      Index_t thread_num = omp_get_thread_num();
-#else      
-      Index_t thread_num = 0;
-#endif      
+static inline
+void EvalEOSForElemRange(Domain& domain, Real_t *vnewc,
+                         Index_t begin, Index_t end)
+{
+   // region element lists are sorted, so the part of a region that
+   // falls in [begin, end) is contiguous
+   for (Int_t r=0 ; r<domain.numReg() ; ++r) {
+      Index_t *list = domain.regElemlist(r) ;
+      Index_t size = domain.regElemSize(r) ;
+      Index_t *first = std::lower_bound(list, list + size, begin) ;
+      Index_t *last = std::lower_bound(first, list + size, end) ;
+      if (last != first) {
+         EvalEOSForElems(domain, vnewc, Int_t(last - first), first,
+                         CalcRegionRep(domain, r)) ;
+      }
+   }
 
-#pragma omp for
-      for (Index_t i = 0 ; i < length ; ++i) {
-         Index_t indx = regElemlist[i] ;
+   Real_t v_cut = domain.v_cut() ;
+   for (Index_t i=begin ; i<end ; ++i) {
+      Real_t tmpV = domain.vnew(i) ;
 
-         if (domain.vdov(indx) != Real_t(0.)) {
-            Real_t dtdvov = dvovmax / (FABS(domain.vdov(indx))+Real_t(1.e-20)) ;
+      if ( FABS(tmpV - Real_t(1.0)) < v_cut )
+         tmpV = Real_t(1.0) ;
 
-            if ( dthydro_tmp > dtdvov ) {
-                  dthydro_tmp = dtdvov ;
-                  hydro_elem = indx ;
-            }
+      domain.v(i) = tmpV ;
+   }
+}
+
+/******************************************/
+
+static inline
+void CalcTimeConstraintsForElemRange(Domain& domain, Index_t begin,
+                                     Index_t end, MinLoc_t *dt)
+{
+   Real_t qqc2 = Real_t(64.0) * domain.qqc() * domain.qqc() ;
+   Real_t dvovmax = domain.dvovmax() ;
+   MinLoc_t courant, hydro ;
+
+   courant.val = Real_t(1.0e+20) ; courant.loc = -1 ;
+   hydro.val   = Real_t(1.0e+20) ; hydro.loc   = -1 ;
+
+   CalcTimeConstraintsForRange(&domain.ss(0), &domain.vdov(0),
+                               &domain.arealg(0), begin, end,
+                               qqc2, dvovmax, courant, hydro) ;
+   dt[0] = courant ;
+   dt[1] = hydro ;
+}
+
+/******************************************/
+
+static void TaskGraphQTask(void *arg)
+{
+   TaskGraphBlock_t *blk = static_cast<TaskGraphBlock_t *>(arg) ;
+   TaskGraph_t *graph = blk->graph ;
+   Domain &domain = *graph->domain ;
+
+   CalcMonotonicQForElemRange(domain, blk->begin, blk->end) ;
+   EvalEOSForElemRange(domain, graph->vnewc, blk->begin, blk->end) ;
+   CalcTimeConstraintsForElemRange(domain, blk->begin, blk->end,
+                                   &graph->dt[2*blk->b]) ;
+}
+
+static void TaskGraphGradTask(void *arg)
+{
+   TaskGraphBlock_t *blk = static_cast<TaskGraphBlock_t *>(arg) ;
+   TaskGraph_t *graph = blk->graph ;
+   Domain &domain = *graph->domain ;
+
+   CalcKinematicsForElemRange(domain, graph->vnewc, blk->begin, blk->end) ;
+   for (Index_t i=blk->begin ; i<blk->end ; ++i) {
+      CalcMonotonicQGradientsForElem(domain, i) ;
+   }
+
+   if (graph->chained) {
+      Int_t first = (blk->b > 0) ? blk->b-1 : blk->b ;
+      Int_t last = (blk->b < graph->numBlock-1) ? blk->b+1 : blk->b ;
+      for (Int_t nb=first ; nb<=last ; ++nb) {
+         if (graph->gradWait[nb].fetch_sub(1) == 1) {
+            ParTaskSpawn(TaskGraphQTask, &graph->block[nb]) ;
          }
       }
+   }
+}
+
+static inline
+void LagrangeElementsTaskGraph(Domain& domain)
+{
+   Index_t numElem = domain.numElem() ;
+
+   if (numElem == 0) {
+      return ;
+   }
+
+   // shared by the team
+   TaskGraph_t &graph = domain.taskGraphState() ;
+   std::vector<TaskGraphBlock_t> &block = domain.taskGraphBlocks() ;
+   std::vector<MinLoc_t> &dtPart = domain.dtPartial() ;
 
-      dthydro_per_thread[thread_num]    = dthydro_tmp ;
-      hydro_elem_per_thread[thread_num] = hydro_elem ;
+#if USE_MPI      
+   if (CommThread(domain)) {
+      CommRecv(domain, MSG_MONOQ, 3,
+               domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+               true, true) ;
    }
+#endif      
+
+   if (ParThreadId() == 0) {
+      Index_t planeSize = domain.sizeX()*domain.sizeY() ;
+      Index_t numPlane = domain.sizeZ() ;
+      Int_t numBlock = std::min(Int_t(numPlane),
+                                Int_t(TG_BLOCKS_PER_THREAD*ParNumThreads())) ;
+
+      Int_t allElem = numElem +  /* local elem */
+            2*domain.sizeX()*domain.sizeY() + /* plane ghosts */
+            2*domain.sizeX()*domain.sizeZ() + /* row ghosts */
+            2*domain.sizeY()*domain.sizeZ() ; /* col ghosts */
+
+      domain.AllocateStrains(numElem);
+      domain.AllocateGradients(numElem, allElem);
+
+      block.resize(numBlock) ;
+      dtPart.resize(2*numBlock) ;
+      graph.domain = &domain ;
+      graph.vnewc = Allocate<Real_t>(numElem) ;
+      graph.numBlock = numBlock ;
+      graph.chained = (domain.numRanks() == 1) ;
+      graph.gradWait = new std::atomic<Int_t>[numBlock] ;
+      graph.block = &block[0] ;
+      graph.dt = &dtPart[0] ;
+
+      for (Int_t b=0 ; b<numBlock ; ++b) {
+         block[b].graph = &graph ;
+         block[b].b = b ;
+         block[b].begin = planeSize*Index_t((Int8_t(b)*numPlane)/numBlock) ;
+         block[b].end = planeSize*Index_t((Int8_t(b+1)*numPlane)/numBlock) ;
+         graph.gradWait[b] = 1 + ((b > 0) ? 1 : 0) + ((b < numBlock-1) ? 1 : 0) ;
+      }
 
-   for (Index_t i = 1; i < threads; ++i) {
-      if(dthydro_per_thread[i] < dthydro_per_thread[0]) {
-         dthydro_per_thread[0]    = dthydro_per_thread[i];
-         hydro_elem_per_thread[0] =  hydro_elem_per_thread[i];
+      for (Int_t b=0 ; b<numBlock ; ++b) {
+         ParTaskSpawn(TaskGraphGradTask, &block[b]) ;
       }
    }
+   ParTaskBarrier() ;
 
-   if (hydro_elem_per_thread[0] != -1) {
-      dthydro =  dthydro_per_thread[0] ;
+#if USE_MPI      
+   if (!graph.chained) {
+      if (CommThread(domain)) {
+         Domain_member fieldData[3] ;
+
+         fieldData[0] = &Domain::delv_xi ;
+         fieldData[1] = &Domain::delv_eta ;
+         fieldData[2] = &Domain::delv_zeta ;
+
+         CommSend(domain, MSG_MONOQ, 3, fieldData,
+                  domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+                  true, true) ;
+
+         CommMonoQ(domain) ;
+      }
+      // the ghost gradients may have been unpacked by several threads
+      ParBarrier() ;
+
+      if (ParThreadId() == 0) {
+         for (Int_t b=0 ; b<graph.numBlock ; ++b) {
+            ParTaskSpawn(TaskGraphQTask, &block[b]) ;
+         }
+      }
+      ParTaskBarrier() ;
    }
+#endif      
 
-   return ;
+   if (ParThreadId() == 0) {
+      MinLoc_t courant = dtPart[0] ;
+      MinLoc_t hydro = dtPart[1] ;
+      for (Int_t b=1 ; b<graph.numBlock ; ++b) {
+         MinLocCombine(courant, dtPart[2*b]) ;
+         MinLocCombine(hydro, dtPart[2*b+1]) ;
+      }
+      domain.dtcourant() = courant.val ;
+      domain.dthydro() = hydro.val ;
+
+      delete [] graph.gradWait ;
+      Release(&graph.vnewc) ;
+      domain.DeallocateGradients();
+      domain.DeallocateStrains();
+   }
+   ParBarrier() ;
 }
 
 /******************************************/
 
-static inline
-void CalcTimeConstraintsForElems(Domain& domain) {
+static void CalibrateNoop(void *)
+{
+}
 
-   // Initialize conditions to a very large value
-   domain.dtcourant() = 1.0e+20;
-   domain.dthydro() = 1.0e+20;
+static void CalibrateSmallRegionsBody(void *arg)
+{
+   SmallRegion_t &small = static_cast<Domain *>(arg)->smallRegions() ;
+   const Int_t iters = SMALL_REGION_CALIB_ITERS ;
+   double start ;
+
+   ParBarrier() ;
+   start = WallClock() ;
+   for (Int_t i=0 ; i<iters ; ++i) {
+      ParBarrier() ;
+   }
+
+   if (ParThreadId() == 0) {
+      small.barrierCost = (WallClock() - start) / double(iters) ;
+      start = WallClock() ;
+      for (Int_t i=0 ; i<iters ; ++i) {
+         ParTaskSpawn(CalibrateNoop, NULL) ;
+      }
+   }
+   ParTaskBarrier() ;
+
+   if (ParThreadId() == 0) {
+      double dispatch = (WallClock() - start) / double(iters) ;
+
+      // the scratch arrays of an EvalEOSForElems call
+      const Int_t numScratch = 14 ;
+      Real_t *scratch[numScratch] ;
+      start = WallClock() ;
+      for (Int_t i=0 ; i<iters ; ++i) {
+         for (Int_t k=0 ; k<numScratch ; ++k) {
+            scratch[k] = Allocate<Real_t>(EOS_MIN_TASK_ELEMS) ;
+         }
+         for (Int_t k=numScratch-1 ; k>=0 ; --k) {
+            Release(&scratch[k]) ;
+         }
+      }
+      small.callCost = dispatch + (WallClock() - start) / double(iters) ;
+   }
+}
 
-   for (Index_t r=0 ; r < domain.numReg() ; ++r) {
-      /* evaluate time constraint */
-      CalcCourantConstraintForElems(domain, domain.regElemSize(r),
-                                    domain.regElemlist(r),
-                                    domain.qqc(),
-                                    domain.dtcourant()) ;
+/* Measures the overheads the small region cutoffs are derived from */
+static inline
+void CalibrateSmallRegions(Domain& domain)
+{
+   ParRun(CalibrateSmallRegionsBody, &domain) ;
+}
 
-      /* check hydro constraint */
-      CalcHydroConstraintForElems(domain, domain.regElemSize(r),
-                                  domain.regElemlist(r),
-                                  domain.dvovmax(),
-                                  domain.dthydro()) ;
+/* Prints the small region cutoffs and the overhead saved per cycle
+ * (worst rank) */
+static void ReportSmallRegions(Domain& domain, Int_t myRank)
+{
+   const SmallRegion_t &small = domain.smallRegions() ;
+   double saved = double(small.eosBatched - small.eosBatches)*small.callCost ;
+   double local[6] = { double(small.monoqCutoff), double(small.eosCutoff),
+                       double(small.monoqSmall), double(small.eosBatched),
+                       double(small.eosBatches), saved } ;
+   double global[6] ;
+#if USE_MPI
+   MPI_Reduce(local, global, 6, MPI_DOUBLE, MPI_MAX, 0, domain.comm) ;
+#else
+   for (Int_t i=0 ; i<6 ; ++i) {
+      global[i] = local[i] ;
+   }
+#endif
+   if (myRank == 0) {
+      printf("Small regions (per cycle, worst rank)\n") ;
+      printf("   cutoff monotonic q  = %d elements\n", int(global[0])) ;
+      printf("   cutoff EOS          = %d elements\n", int(global[1])) ;
+      printf("   monotonic q         = %d regions in one sweep\n",
+             int(global[2])) ;
+      printf("   EOS                 = %d regions in %d calls\n",
+             int(global[3]), int(global[4])) ;
+      printf("   saved call overhead = %.2f us\n\n", global[5]*1.0e6) ;
    }
 }
 
 /******************************************/
 
-static inline
-void LagrangeLeapFrog(Domain& domain)
+/*
+ * The whole time step runs as one ParRun() region.  All routines called
+ * from here are executed by every thread of the team and share out
+ * their loops with ParRange(); temporaries are allocated by thread 0
+ * and broadcast with ParAllocate(), and MPI calls are made by thread 0
+ * only (MPI_THREAD_FUNNELED).
+ */
+static void LagrangeLeapFrogBody(void *arg)
 {
+   Domain &domain = *static_cast<Domain *>(arg) ;
+
 #ifdef SEDOV_SYNC_POS_VEL_LATE
    Domain_member fieldData[6] ;
 #endif
@@ -2614,36 +4229,58 @@ void LagrangeLeapFrog(Domain& domain)
 
    /* calculate element quantities (i.e. velocity gradient & q), and update
     * material states */
-   LagrangeElements(domain, domain.numElem());
+   if (domain.taskGraph()) {
+      /* also computes the time constraints */
+      LagrangeElementsTaskGraph(domain);
+   }
+   else {
+      LagrangeElements(domain, domain.numElem());
+   }
 
 #if USE_MPI   
 #ifdef SEDOV_SYNC_POS_VEL_LATE
-   CommRecv(domain, MSG_SYNC_POS_VEL, 6,
-            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
-            false, false) ;
-
-   fieldData[0] = &Domain::x ;
-   fieldData[1] = &Domain::y ;
-   fieldData[2] = &Domain::z ;
-   fieldData[3] = &Domain::xd ;
-   fieldData[4] = &Domain::yd ;
-   fieldData[5] = &Domain::zd ;
+   if (CommThread(domain)) {
+      CommRecv(domain, MSG_SYNC_POS_VEL, 6,
+               domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+               false, false) ;
+
+      fieldData[0] = &Domain::x ;
+      fieldData[1] = &Domain::y ;
+      fieldData[2] = &Domain::z ;
+      fieldData[3] = &Domain::xd ;
+      fieldData[4] = &Domain::yd ;
+      fieldData[5] = &Domain::zd ;
    
-   CommSend(domain, MSG_SYNC_POS_VEL, 6, fieldData,
-            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
-            false, false) ;
+      CommSend(domain, MSG_SYNC_POS_VEL, 6, fieldData,
+               domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+               false, false) ;
+   }
 #endif
 #endif   
 
-   CalcTimeConstraintsForElems(domain);
+   if (!domain.taskGraph()) {
+      CalcTimeConstraintsForElems(domain);
+   }
+
+   if (ParThreadId() == 0) {
+      TimeIncrementStart(domain) ;
+   }
 
 #if USE_MPI   
 #ifdef SEDOV_SYNC_POS_VEL_LATE
-   CommSyncPosVel(domain) ;
+   if (CommThread(domain)) {
+      CommSyncPosVel(domain) ;
+   }
 #endif
 #endif   
 }
 
+static inline
+void LagrangeLeapFrog(Domain& domain)
+{
+   ParRun(LagrangeLeapFrogBody, &domain) ;
+}
+
 
 /******************************************/
 
@@ -2657,19 +4294,18 @@ int main(int argc, char *argv[])
 #if USE_MPI   
    Domain_member fieldData ;
    
-#ifdef _OPENMP
+   // Only thread 0 calls MPI, whichever threading backend is used,
+   // unless the hybrid exchange is asked for.  Thread-multiple can make
+   // every MPI call more expensive, so it is only requested then.
    int thread_support;
+   int thread_required = MPI_THREAD_FUNNELED;
 
-   MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support);
-   if (thread_support==MPI_THREAD_SINGLE)
-    {
-        fprintf(stderr,"The MPI implementation has no support for threading\n");
-        MPI_Finalize();
-        exit(1);
-    }
-#else
-   MPI_Init(&argc, &argv);
-#endif
+   for (int i = 1; i < argc; ++i) {
+      if (strcmp(argv[i], "-hybrid") == 0) {
+         thread_required = MPI_THREAD_MULTIPLE;
+      }
+   }
+   MPI_Init_thread(&argc, &argv, thread_required, &thread_support);
     
    MPI_Comm_size(MPI_COMM_WORLD, &numRanks) ;
    MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
@@ -2688,16 +4324,96 @@ int main(int argc, char *argv[])
    opts.viz = 0;
    opts.balance = 1;
    opts.cost = 1;
+   opts.halfStep = 0;
+   opts.taskGraph = 0;
+   opts.deterministic = 0;
+   opts.bind = BIND_NONE;
+   opts.par = PAR_OPENMP;
+   opts.spin = PAR_SPIN_COUNT;
+   opts.hybrid = 0;
+   opts.part = 0;
+   opts.persist = 0;
+   opts.dtype = 0;
+   opts.neighbor = 0;
+   opts.overlap = 0;
+   opts.shm = 0;
+   opts.rma = COMM_RMA_NONE;
+   opts.commBench = 0;
+   opts.teamPack = 0;
+   opts.packBench = 0;
+   opts.sweep = 0;
+   opts.batch = 0;
+   opts.grid[0] = opts.grid[1] = opts.grid[2] = 0;
+   opts.dumpFile = NULL;
 
    ParseCommandLineOptions(argc, argv, myRank, &opts);
 
+   // Start the threads; the pool takes its size from OMP_NUM_THREADS
+   // too, so both backends can be compared at equal thread counts
+   Int_t poolThreads ;
+#if _OPENMP
+   poolThreads = omp_get_max_threads() ;
+#else
+   const char *envThreads = getenv("OMP_NUM_THREADS") ;
+   poolThreads = (envThreads != NULL) ? atoi(envThreads)
+                                      : Int_t(std::thread::hardware_concurrency()) ;
+#endif
+   // Spinning only pays off when every thread has a CPU of its own
+   Int_t numCpu = Int_t(std::thread::hardware_concurrency()) ;
+   if (numCpu > 0 && poolThreads > numCpu) {
+      opts.spin = 0 ;
+   }
+   ParInit(opts.par, poolThreads, opts.spin) ;
+
+#if USE_MPI
+   if (thread_support==MPI_THREAD_SINGLE && ParNumThreads() > 1)
+    {
+        fprintf(stderr,"The MPI implementation has no support for threading\n");
+        MPI_Finalize();
+        exit(1);
+    }
+   if (opts.hybrid && thread_support < MPI_THREAD_MULTIPLE) {
+      if ((myRank == 0) && (opts.quiet == 0)) {
+         std::cout << "MPI_THREAD_MULTIPLE not available, "
+                   << "using the funneled halo exchange\n";
+      }
+      opts.hybrid = 0;
+   }
+   if (opts.sweep && (opts.persist || opts.dtype || opts.neighbor ||
+                      opts.shm || opts.rma != COMM_RMA_NONE)) {
+      if ((myRank == 0) && (opts.quiet == 0)) {
+         std::cout << "The dimension sweep replaces the -persist, -dtype, "
+                   << "-neighbor, -shm and -rma exchanges\n";
+      }
+      opts.persist = 0;
+      opts.dtype = 0;
+      opts.neighbor = 0;
+      opts.shm = 0;
+      opts.rma = COMM_RMA_NONE;
+   }
+#endif
+
    if ((myRank == 0) && (opts.quiet == 0)) {
       std::cout << "Running problem size " << opts.nx << "^3 per domain until completion\n";
       std::cout << "Num processors: "      << numRanks << "\n";
 #if _OPENMP
-      std::cout << "Num threads: " << omp_get_max_threads() << "\n";
+      std::cout << "Num threads: " << ParNumThreads() << "\n";
+#else
+      if (opts.par == PAR_POOL) {
+         std::cout << "Num threads: " << ParNumThreads() << "\n";
+      }
 #endif
+      if (opts.par == PAR_POOL) {
+         std::cout << "Thread pool backend (spin " << opts.spin << ")\n";
+      }
+      if (opts.hybrid && numRanks > 1) {
+         std::cout << "Hybrid halo exchange (MPI_THREAD_MULTIPLE)\n";
+      }
       std::cout << "Total number of elements: " << ((Int8_t)numRanks*opts.nx*opts.nx*opts.nx) << " \n\n";
+#if LULESH_APPROX_MATH
+      std::cout << "Approximate math enabled (" << LULESH_APPROX_SEED
+                << " seed, " << LULESH_APPROX_NEWTON << " Newton steps)\n\n";
+#endif
       std::cout << "To run other sizes, use -s <integer>.\n";
       std::cout << "To run a fixed number of iterations, use -i <integer>.\n";
       std::cout << "To run a more or less balanced region set, use -b <integer>.\n";
@@ -2707,29 +4423,106 @@ int main(int argc, char *argv[])
       std::cout << "See help (-h) for more options\n\n";
    }
 
-   // Set up the mesh and decompose. Assumes regular cubes for now
-   Int_t col, row, plane, side;
-   InitMeshDecomp(numRanks, myRank, &col, &row, &plane, &side);
+   // Place the threads before the Domain is first touched
+   SetupThreadBinding(opts.bind, myRank, numRanks, opts.quiet == 0) ;
+
+   // Set up the mesh and decompose into a px x py x pz grid of cubes
+   Int_t col, row, plane, side[3];
+   InitMeshDecomp(numRanks, myRank, opts.grid, &col, &row, &plane, side);
+#if USE_MPI
+   // with -neighbor the domains follow the ranks of the Cartesian
+   // communicator, which the MPI library may have reordered
+   MPI_Comm comm = MPI_COMM_WORLD ;
+   if (opts.neighbor && numRanks > 1) {
+      comm = CommCreateCart(side) ;
+      MPI_Comm_rank(comm, &myRank) ;
+      InitMeshDecomp(numRanks, myRank, opts.grid, &col, &row, &plane, side);
+   }
+#endif
+
+   if ((myRank == 0) && (opts.quiet == 0) && (numRanks > 1)) {
+      std::cout << "Process grid: " << side[0] << " x " << side[1]
+                << " x " << side[2] << "\n\n";
+   }
 
    // Build the main data structure and initialize it
    locDom = new Domain(numRanks, col, row, plane, opts.nx,
-                       side, opts.numReg, opts.balance, opts.cost) ;
+                       side[0], side[1], side[2],
+                       opts.numReg, opts.balance, opts.cost) ;
+
+   if (opts.halfStep) {
+      locDom->halfStepCoords() = 1 ;
+      locDom->AllocateNodeHalfStep(locDom->numNode()) ;
+   }
+   locDom->taskGraph() = opts.taskGraph ;
+   locDom->commHybrid() = opts.hybrid ;
+   locDom->eosPartition() = opts.part ;
+   locDom->regionBatch() = opts.batch ;
+   locDom->commPersistent() = opts.persist ;
+   locDom->commDatatypes() = opts.dtype ;
+   locDom->commTeamPack() = opts.teamPack && !opts.hybrid ;
+   if (opts.overlap && !opts.deterministic && numRanks > 1) {
+      locDom->haloOverlap() = 1 ;
+      locDom->SetupNodeElemCornerList() ;
+      BuildHaloSplit(*locDom) ;
+   }
+#if USE_MPI
+   locDom->comm = comm ;
+   if (comm != MPI_COMM_WORLD) {
+      locDom->commNeighbor() = 1 ;
+      CommSetupNeighborhood(*locDom) ;
+   }
+   if (opts.shm && numRanks > 1) {
+      locDom->commShared() = 1 ;
+      CommSetupShared(*locDom) ;
+   }
+   if (opts.rma != COMM_RMA_NONE && numRanks > 1) {
+      locDom->commRma() = opts.rma ;
+      CommSetupRma(*locDom, opts.rma) ;
+   }
+   if (opts.sweep && numRanks > 1) {
+      locDom->commSweep() = 1 ;
+      CommSetupSweep(*locDom) ;
+   }
+#endif
+   if (opts.deterministic) {
+      locDom->deterministic() = 1 ;
+      locDom->SetupNodeElemCornerList() ;
+      locDom->AllocateCornerForces(locDom->numElem()) ;
+      if (numRanks > 1) {
+         locDom->AllocateNodeSlots(locDom->numNode()) ;
+      }
+      CalcNodalMassForNodes(*locDom) ;
+   }
 
+   if (!opts.taskGraph) {
+      CalibrateSmallRegions(*locDom) ;
+   }
 
 #if USE_MPI   
    fieldData = &Domain::nodalMass ;
 
    // Initial domain boundary communication 
-   CommRecv(*locDom, MSG_COMM_SBN, 1,
-            locDom->sizeX() + 1, locDom->sizeY() + 1, locDom->sizeZ() + 1,
-            true, false) ;
-   CommSend(*locDom, MSG_COMM_SBN, 1, &fieldData,
-            locDom->sizeX() + 1, locDom->sizeY() + 1, locDom->sizeZ() +  1,
-            true, false) ;
-   CommSBN(*locDom, 1, &fieldData) ;
+   // (already done by CalcNodalMassForNodes in deterministic mode)
+   if (!locDom->deterministic()) {
+      CommRecv(*locDom, MSG_COMM_SBN, 1,
+               locDom->sizeX() + 1, locDom->sizeY() + 1, locDom->sizeZ() + 1,
+               true, false) ;
+      CommSend(*locDom, MSG_COMM_SBN, 1, &fieldData,
+               locDom->sizeX() + 1, locDom->sizeY() + 1, locDom->sizeZ() +  1,
+               true, false) ;
+      CommSBN(*locDom, 1, &fieldData) ;
+   }
+
+   if (opts.commBench > 0 && numRanks > 1) {
+      CommBenchmark(*locDom, opts.commBench, myRank) ;
+   }
+   if (opts.packBench > 0) {
+      CommPackBenchmark(*locDom, opts.packBench, myRank) ;
+   }
 
    // End initialization
-   MPI_Barrier(MPI_COMM_WORLD);
+   MPI_Barrier(locDom->comm);
 #endif   
    
    // BEGIN timestep to solution */
@@ -2744,7 +4537,7 @@ int main(int argc, char *argv[])
 //      std::cout << "region" << i + 1<< "size" << locDom->regElemSize(i) <<std::endl;
    while((locDom->time() < locDom->stoptime()) && (locDom->cycle() < opts.its)) {
 
-      TimeIncrement(*locDom) ;
+      // also advances the time, after the force calculation
       LagrangeLeapFrog(*locDom) ;
 
       if ((opts.showProg != 0) && (opts.quiet == 0) && (myRank == 0)) {
@@ -2756,6 +4549,11 @@ int main(int argc, char *argv[])
       }
    }
 
+#if USE_MPI
+   // the reduction started by the last cycle has no cycle to feed
+   MPI_Wait(&locDom->dtRequest, MPI_STATUS_IGNORE) ;
+#endif
+
    // Use reduced max elapsed time
    double elapsed_time;
 #if USE_MPI   
@@ -2768,7 +4566,7 @@ int main(int argc, char *argv[])
    double elapsed_timeG;
 #if USE_MPI   
    MPI_Reduce(&elapsed_time, &elapsed_timeG, 1, MPI_DOUBLE,
-              MPI_MAX, 0, MPI_COMM_WORLD);
+              MPI_MAX, 0, locDom->comm);
 #else
    elapsed_timeG = elapsed_time;
 #endif
@@ -2777,13 +4575,31 @@ int main(int argc, char *argv[])
    if (opts.viz) {
       DumpToVisit(*locDom, opts.numFiles, myRank, numRanks) ;
    }
+
+   if (opts.dumpFile != NULL) {
+      DumpElemEnergy(*locDom, opts.dumpFile, myRank) ;
+   }
    
    if ((myRank == 0) && (opts.quiet == 0)) {
       VerifyAndWriteFinalOutput(elapsed_timeG, *locDom, opts.nx, numRanks);
    }
 
+   if (opts.part && (opts.quiet == 0) && !opts.taskGraph) {
+      ReportEOSPartition(*locDom, myRank) ;
+   }
+
+   if (opts.batch && (opts.quiet == 0) && !opts.taskGraph) {
+      ReportSmallRegions(*locDom, myRank) ;
+   }
+
+#if USE_MPI
+   CommFreeResources(*locDom) ;
+#endif
+
    delete locDom; 
 
+   ParFinalize() ;
+
 #if USE_MPI
    MPI_Finalize() ;
 #endif
@@ -18,9 +18,15 @@
 
 #include <math.h>
 #include <stdlib.h>
-#include <stdint.h>
+#include <string.h>
+#include <cstdint>
+#include <atomic>
 #include <vector>
 
+#if !defined(UINT32_MAX) || !defined(UINT64_MAX)
+# error "LULESH needs the exact-width types uint32_t and uint64_t"
+#endif
+
 //**************************************************
 // Allow flexibility for arithmetic representations 
 //**************************************************
@@ -53,6 +59,104 @@ inline real4  FABS(real4  arg) { return fabsf(arg) ; }
 inline real8  FABS(real8  arg) { return fabs(arg) ; }
 inline real10 FABS(real10 arg) { return fabsl(arg) ; }
 
+// Optional approximate math.  When LULESH_APPROX_MATH is set, FASTSQRT
+// and FASTDIVSQRT start from the hardware reciprocal square root
+// estimate (rsqrt14, 14 bits, with AVX-512; rsqrtss, 12 bits, with SSE)
+// and refine it with LULESH_APPROX_NEWTON Newton steps, each of which
+// roughly squares the relative error.  Without SSE the seed is a
+// bit-level estimate (~3.4e-2) and one more step is taken by default.
+// Otherwise they are exactly SQRT(arg) and num/SQRT(arg).  Arguments
+// must be > 0; with SSE but no AVX-512 the real8 seed goes through
+// real4, so they must also be in the normal real4 range, which the
+// sound speed and time constraint guards in lulesh.cc ensure.
+#if LULESH_APPROX_MATH
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#define LULESH_APPROX_SEED "rsqrt14"
+#elif defined(__SSE__)
+#include <immintrin.h>
+#define LULESH_APPROX_SEED "rsqrtss"
+#else
+#define LULESH_APPROX_SEED "bit estimate"
+#endif
+
+#ifndef LULESH_APPROX_NEWTON
+#if defined(__AVX512F__) || defined(__SSE__)
+#define LULESH_APPROX_NEWTON 1
+#else
+#define LULESH_APPROX_NEWTON 2
+#endif
+#endif
+
+inline real4 RSQRTSeed(real4 arg)
+{
+#if defined(__AVX512F__)
+   __m128 a = _mm_set_ss(arg) ;
+   return _mm_cvtss_f32(_mm_rsqrt14_ss(a, a)) ;
+#elif defined(__SSE__)
+   return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(arg))) ;
+#else
+   uint32_t i ;
+   memcpy(&i, &arg, sizeof(i)) ;
+   i = uint32_t(0x5f375a86) - (i >> 1) ;
+   real4 y ;
+   memcpy(&y, &i, sizeof(y)) ;
+   return y ;
+#endif
+}
+
+inline real8 RSQRTSeed(real8 arg)
+{
+#if defined(__AVX512F__)
+   __m128d a = _mm_set_sd(arg) ;
+   return _mm_cvtsd_f64(_mm_rsqrt14_sd(a, a)) ;
+#elif defined(__SSE__)
+   return real8(RSQRTSeed(real4(arg))) ;
+#else
+   uint64_t i ;
+   memcpy(&i, &arg, sizeof(i)) ;
+   i = uint64_t(0x5fe6eb50c7b537a9ULL) - (i >> 1) ;
+   real8 y ;
+   memcpy(&y, &i, sizeof(y)) ;
+   return y ;
+#endif
+}
+
+inline real4 RSQRT(real4 arg)
+{
+   real4 y = RSQRTSeed(arg) ;
+   for (int n = 0 ; n < LULESH_APPROX_NEWTON ; ++n) {
+      y = y * (real4(1.5) - real4(0.5) * arg * y * y) ;
+   }
+   return y ;
+}
+
+inline real8 RSQRT(real8 arg)
+{
+   real8 y = RSQRTSeed(arg) ;
+   for (int n = 0 ; n < LULESH_APPROX_NEWTON ; ++n) {
+      y = y * (real8(1.5) - real8(0.5) * arg * y * y) ;
+   }
+   return y ;
+}
+
+inline real10 RSQRT(real10 arg) { return real10(1.0) / sqrtl(arg) ; }
+
+template <typename T>
+inline T FASTSQRT(T arg) { return arg * RSQRT(arg) ; }
+template <typename T>
+inline T FASTDIVSQRT(T num, T arg) { return num * RSQRT(arg) ; }
+
+#else
+
+template <typename T>
+inline T FASTSQRT(T arg) { return SQRT(arg) ; }
+template <typename T>
+inline T FASTDIVSQRT(T num, T arg) { return num / SQRT(arg) ; }
+
+#endif
+
 
 // Stuff needed for boundary conditions
 // 2 BCs on each of 6 hexahedral faces (12 bits)
@@ -86,10 +190,17 @@ inline real10 FABS(real10 arg) { return fabsl(arg) ; }
 #define ZETA_P_FREE 0x10000
 #define ZETA_P_COMM 0x20000
 
+// Per-node symmetry plane mask
+#define SYMM_X      0x1
+#define SYMM_Y      0x2
+#define SYMM_Z      0x4
+
 // MPI Message Tags
 #define MSG_COMM_SBN      1024
 #define MSG_SYNC_POS_VEL  2048
 #define MSG_MONOQ         3072
+// buffer offsets of the one-sided exchange, added to the tag above
+#define MSG_RMA_OFFSET    4096
 
 #define MAX_FIELDS_PER_MPI_COMM 6
 
@@ -100,6 +211,70 @@ inline real10 FABS(real10 arg) { return fabsl(arg) ; }
 #define CACHE_ALIGN_REAL(n) \
    (((n) + (CACHE_COHERENCE_PAD_REAL - 1)) & ~(CACHE_COHERENCE_PAD_REAL-1))
 
+// Number of elements processed together by the batched (SIMD)
+// kinematics kernels.  Should be a multiple of the vector width.
+#ifndef KIN_BATCH_SIZE
+#define KIN_BATCH_SIZE 8
+#endif
+
+// Number of lanes of the time constraint min-loc reduction; every lane
+// keeps its own minimum, and the lanes are combined at the end.
+#ifndef DT_LANES
+#define DT_LANES 8
+#endif
+
+// Region EOS scheduling: target number of EOS tasks per thread, and
+// smallest piece a region is split into.
+#ifndef EOS_TASKS_PER_THREAD
+#define EOS_TASKS_PER_THREAD 4
+#endif
+#ifndef EOS_MIN_TASK_ELEMS
+#define EOS_MIN_TASK_ELEMS 256
+#endif
+
+// Cost-weighted EOS partitioning (-part): cycles per cost measurement
+// window, and predicted max/mean thread time that triggers a new split.
+#ifndef PART_WINDOW_CYCLES
+#define PART_WINDOW_CYCLES 5
+#endif
+#ifndef PART_DRIFT_TOL
+#define PART_DRIFT_TOL 1.10
+#endif
+
+// Small regions: iterations of each overhead measurement at startup.
+// Regions below the measured cutoff are not split between threads, and
+// with -batch those of equal rep are evaluated together.
+#ifndef SMALL_REGION_CALIB_ITERS
+#define SMALL_REGION_CALIB_ITERS 200
+#endif
+
+// Task-graph mode (-tg): number of z-plane element blocks per thread.
+#ifndef TG_BLOCKS_PER_THREAD
+#define TG_BLOCKS_PER_THREAD 4
+#endif
+
+// Synchronization of the one-sided halo exchange (-rma), see lulesh-comm.cc
+#define COMM_RMA_NONE  0
+#define COMM_RMA_FENCE 1
+#define COMM_RMA_PSCW  2
+
+// Parallel backends (-par), see lulesh-thread.cc
+#define PAR_OPENMP 0
+#define PAR_POOL   1
+
+// Default number of spins before a waiting pool thread sleeps (-spin)
+#ifndef PAR_SPIN_COUNT
+#define PAR_SPIN_COUNT 20000
+#endif
+
+// Thread placement policies (-bind)
+#define BIND_NONE    0
+#define BIND_COMPACT 1
+#define BIND_SCATTER 2
+
+// Deterministic mode (-det): 3 force components x 8 local node numbers
+#define NODE_SLOTS 24
+
 /*********************************/
 /* Data structure implementation */
 /*********************************/
@@ -122,6 +297,102 @@ void Release(T **ptr)
    }
 }
 
+class Domain ;
+
+/*
+ * A piece of a region's element list evaluated by one thread.  The
+ * weight (elements x rep) is the estimated cost.
+ */
+struct EOSTask_t {
+   Int_t   reg ;
+   Index_t start ;
+   Index_t len ;
+   Int_t   rep ;
+   Int8_t  weight ;
+   Index_t *elems ;  // element list of the piece
+   Domain *domain ;
+   Real_t *vnewc ;
+} ;
+
+/*
+ * Min-loc pair used by the time constraint reduction.  Ties go to the
+ * lower element index so the reported location does not depend on how
+ * the loop was split between threads.
+ */
+struct MinLoc_t {
+   Real_t  val ;
+   Index_t loc ;
+} ;
+
+/*
+ * Element and node lists of the halo overlap (-overlap): the shell
+ * elements and face nodes take part in the halo exchange, the others
+ * are computed while the messages are in flight.
+ */
+struct HaloSplit_t {
+   std::vector<Index_t> shellElem ;
+   std::vector<Index_t> interiorElem ;
+   std::vector<Index_t> faceNode ;
+   std::vector<Index_t> interiorNode ;
+} ;
+
+/*
+ * Measured costs and cutoffs of the small region handling.
+ */
+struct SmallRegion_t {
+   double barrierCost ;    // seconds per team barrier
+   double callCost ;       // seconds per EOS task besides its elements
+   double monoqElemCost ;  // seconds per element
+   double eosElemCost ;    // seconds per element and rep
+   Index_t monoqCutoff ;
+   Index_t eosCutoff ;
+   bool measured ;         // cutoffs are set from the first cycle
+   // counts of the last cycle
+   Int_t monoqSmall ;      // regions below monoqCutoff
+   Int_t eosBatched ;      // regions merged into batch tasks (-batch)
+   Int_t eosBatches ;      // batch tasks (-batch)
+} ;
+
+/*
+ * Cost-weighted static EOS partition (-part); empty until the first
+ * EOS evaluation.
+ */
+struct EOSPartition_t {
+   std::vector<EOSTask_t> piece ;  // region pieces of all threads
+   std::vector<Int_t> first ;      // thread t owns piece[first[t]..first[t+1])
+   std::vector<double> regTime ;   // [t*numReg + r] seconds in this window
+   std::vector<double> thrTime ;   // seconds per thread in this window
+   std::vector<double> cost ;      // seconds per element and cycle, per region
+   Int_t windowCycles ;
+   Int_t numRebuild ;
+   bool weighted ;
+   double imbalanceCount ;         // measured with the count-based cut
+   double imbalanceCost ;          // measured with the cost-weighted cut
+} ;
+
+/*
+ * Task graph of the element phase (-tg), rebuilt by thread 0 every
+ * cycle; the blocks are contiguous ranges of element planes.
+ */
+struct TaskGraphBlock_t ;
+
+struct TaskGraph_t {
+   Domain *domain ;
+   Real_t *vnewc ;
+   Int_t numBlock ;
+   bool chained ;                  // grad tasks spawn the q tasks
+   std::atomic<Int_t> *gradWait ;  // missing neighbor gradients
+   TaskGraphBlock_t *block ;
+   MinLoc_t *dt ;                  // courant, hydro per block
+} ;
+
+struct TaskGraphBlock_t {
+   TaskGraph_t *graph ;
+   Int_t b ;
+   Index_t begin ;
+   Index_t end ;
+} ;
+
 //////////////////////////////////////////////////////
 // Primary data structure
 //////////////////////////////////////////////////////
@@ -152,7 +423,8 @@ class Domain {
    // Constructor
    Domain(Int_t numRanks, Index_t colLoc,
           Index_t rowLoc, Index_t planeLoc,
-          Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost);
+          Index_t nx, Int_t tpx, Int_t tpy, Int_t tpz,
+          Int_t nr, Int_t balance, Int_t cost);
 
    // Destructor
    ~Domain();
@@ -171,10 +443,6 @@ class Domain {
       m_yd.resize(numNode);
       m_zd.resize(numNode);
 
-      m_xdd.resize(numNode); // accelerations
-      m_ydd.resize(numNode);
-      m_zdd.resize(numNode);
-
       m_fx.resize(numNode);  // forces
       m_fy.resize(numNode);
       m_fz.resize(numNode);
@@ -182,6 +450,25 @@ class Domain {
       m_nodalMass.resize(numNode);  // mass
    }
 
+   void AllocateNodeHalfStep(Int_t numNode) // optional, see -hs
+   {
+      m_xh.resize(numNode);  // half-step coordinates
+      m_yh.resize(numNode);
+      m_zh.resize(numNode);
+   }
+
+   void AllocateCornerForces(Int_t numElem) // optional, see -det
+   {
+      m_fxCorner.resize(8*numElem);  // per element-corner forces
+      m_fyCorner.resize(8*numElem);
+      m_fzCorner.resize(8*numElem);
+   }
+
+   void AllocateNodeSlots(Int_t numNode) // optional, see -det
+   {
+      m_nodeSlot.resize(NODE_SLOTS*numNode);
+   }
+
    void AllocateElemPersistent(Int_t numElem) // Elem-centered
    {
       m_nodelist.resize(8*numElem);
@@ -272,26 +559,34 @@ class Domain {
    Real_t& yd(Index_t idx)   { return m_yd[idx] ; }
    Real_t& zd(Index_t idx)   { return m_zd[idx] ; }
 
-   // Nodal accelerations
-   Real_t& xdd(Index_t idx)  { return m_xdd[idx] ; }
-   Real_t& ydd(Index_t idx)  { return m_ydd[idx] ; }
-   Real_t& zdd(Index_t idx)  { return m_zdd[idx] ; }
-
    // Nodal forces
    Real_t& fx(Index_t idx)   { return m_fx[idx] ; }
    Real_t& fy(Index_t idx)   { return m_fy[idx] ; }
    Real_t& fz(Index_t idx)   { return m_fz[idx] ; }
 
+   // Nodal coordinates shifted back half a step, x - dt/2 * xd
+   // (only allocated when halfStepCoords() is set)
+   Real_t& xh(Index_t idx)   { return m_xh[idx] ; }
+   Real_t& yh(Index_t idx)   { return m_yh[idx] ; }
+   Real_t& zh(Index_t idx)   { return m_zh[idx] ; }
+
+   // Element-corner forces, indexed elem*8 + local node
+   // (only allocated when deterministic() is set)
+   Real_t& fxCorner(Index_t idx) { return m_fxCorner[idx] ; }
+   Real_t& fyCorner(Index_t idx) { return m_fyCorner[idx] ; }
+   Real_t& fzCorner(Index_t idx) { return m_fzCorner[idx] ; }
+
+   // Per-node contributions of the surrounding elements, one slot per
+   // (component, local node number of the node in that element), used
+   // to exchange node sums exactly between ranks in deterministic mode
+   template<Int_t S>
+   Real_t& nodeSlot(Index_t idx) { return m_nodeSlot[S*m_numNode + idx] ; }
+
    // Nodal mass
    Real_t& nodalMass(Index_t idx) { return m_nodalMass[idx] ; }
 
-   // Nodes on symmertry planes
-   Index_t symmX(Index_t idx) { return m_symmX[idx] ; }
-   Index_t symmY(Index_t idx) { return m_symmY[idx] ; }
-   Index_t symmZ(Index_t idx) { return m_symmZ[idx] ; }
-   bool symmXempty()          { return m_symmX.empty(); }
-   bool symmYempty()          { return m_symmY.empty(); }
-   bool symmZempty()          { return m_symmZ.empty(); }
+   // Symmetry planes a node lies on (SYMM_X | SYMM_Y | SYMM_Z)
+   uint8_t& nodeSymm(Index_t idx) { return m_nodeSymm[idx] ; }
 
    //
    // Element-centered
@@ -302,6 +597,23 @@ class Domain {
    Index_t*  regElemlist(Int_t r)    { return m_regElemlist[r] ; }
    Index_t&  regElemlist(Int_t r, Index_t idx) { return m_regElemlist[r][idx] ; }
 
+   // EOS tasks over the regions, and the concatenated element lists of
+   // the small regions batched together (-batch) the tasks point into;
+   // empty until BuildEOSTasks
+   std::vector<EOSTask_t>& eosTasks()      { return m_eosTasks ; }
+   std::vector<Index_t>&   eosBatchElems() { return m_eosBatchElems ; }
+
+   // per-thread (or, with -tg, per-block) courant and hydro minima
+   std::vector<MinLoc_t>&  dtPartial()     { return m_dtPartial ; }
+
+   // run state of the small region cutoffs, the -part partition, the
+   // -overlap lists and the -tg graph, shared by the thread team
+   SmallRegion_t&  smallRegions()      { return m_smallReg ; }
+   EOSPartition_t& eosPartitionState() { return m_eosPart ; }
+   HaloSplit_t&    haloSplit()         { return m_haloSplit ; }
+   TaskGraph_t&    taskGraphState()    { return m_taskGraphState ; }
+   std::vector<TaskGraphBlock_t>& taskGraphBlocks() { return m_taskGraphBlocks ; }
+
    Index_t*  nodelist(Index_t idx)    { return &m_nodelist[Index_t(8)*idx] ; }
 
    // elem connectivities through face
@@ -372,6 +684,9 @@ class Domain {
    Index_t *nodeElemCornerList(Index_t idx)
    { return &m_nodeElemCornerList[m_nodeElemStart[idx]] ; }
 
+   // Builds the node to element-corner index used above, if not yet built
+   void SetupNodeElemCornerList();
+
    // Parameters 
 
    // Cutoffs
@@ -415,7 +730,10 @@ class Domain {
    Index_t&  colLoc()             { return m_colLoc ; }
    Index_t&  rowLoc()             { return m_rowLoc ; }
    Index_t&  planeLoc()           { return m_planeLoc ; }
-   Index_t&  tp()                 { return m_tp ; }
+   // Process grid: number of domains along x, y and z
+   Index_t&  tpx()                { return m_tpx ; }
+   Index_t&  tpy()                { return m_tpy ; }
+   Index_t&  tpz()                { return m_tpz ; }
 
    Index_t&  sizeX()              { return m_sizeX ; }
    Index_t&  sizeY()              { return m_sizeY ; }
@@ -427,6 +745,22 @@ class Domain {
    
    Index_t&  maxPlaneSize()       { return m_maxPlaneSize ; }
    Index_t&  maxEdgeSize()        { return m_maxEdgeSize ; }
+
+   // Run-time algorithm selections
+   Int_t&  halfStepCoords()       { return m_halfStepCoords ; }
+   Int_t&  taskGraph()            { return m_taskGraph ; }
+   Int_t&  deterministic()        { return m_deterministic ; }
+   Int_t&  commHybrid()           { return m_commHybrid ; }
+   Int_t&  eosPartition()         { return m_eosPartition ; }
+   Int_t&  regionBatch()          { return m_regionBatch ; }
+   Int_t&  commPersistent()       { return m_commPersistent ; }
+   Int_t&  commDatatypes()        { return m_commDatatypes ; }
+   Int_t&  commNeighbor()         { return m_commNeighbor ; }
+   Int_t&  haloOverlap()          { return m_haloOverlap ; }
+   Int_t&  commShared()           { return m_commShared ; }
+   Int_t&  commRma()              { return m_commRma ; }
+   Int_t&  commTeamPack()         { return m_commTeamPack ; }
+   Int_t&  commSweep()            { return m_commSweep ; }
    
    //
    // MPI-Related additional data
@@ -436,10 +770,21 @@ class Domain {
    // Communication Work space 
    Real_t *commDataSend ;
    Real_t *commDataRecv ;
+   Index_t commBufSize ;   // length of each of the two
    
    // Maximum number of block neighbors 
    MPI_Request recvRequest[26] ; // 6 faces + 12 edges + 8 corners 
    MPI_Request sendRequest[26] ; // 6 faces + 12 edges + 8 corners 
+
+   // Global time step reduction, in flight from the end of one cycle
+   // until the velocity update of the next
+   MPI_Request dtRequest ;
+   Real_t dtLocal ;
+   Real_t dtGlobal ;
+
+   // Communicator of the exchanges and reductions: MPI_COMM_WORLD, or
+   // the Cartesian communicator of the process grid with -neighbor
+   MPI_Comm comm ;
 #endif
 
   private:
@@ -465,19 +810,23 @@ class Domain {
    std::vector<Real_t> m_yd ;
    std::vector<Real_t> m_zd ;
 
-   std::vector<Real_t> m_xdd ; /* accelerations */
-   std::vector<Real_t> m_ydd ;
-   std::vector<Real_t> m_zdd ;
-
    std::vector<Real_t> m_fx ;  /* forces */
    std::vector<Real_t> m_fy ;
    std::vector<Real_t> m_fz ;
 
+   std::vector<Real_t> m_xh ;  /* half-step coordinates */
+   std::vector<Real_t> m_yh ;
+   std::vector<Real_t> m_zh ;
+
+   std::vector<Real_t> m_fxCorner ;  /* element-corner forces */
+   std::vector<Real_t> m_fyCorner ;
+   std::vector<Real_t> m_fzCorner ;
+
+   std::vector<Real_t> m_nodeSlot ;  /* node sum slots */
+
    std::vector<Real_t> m_nodalMass ;  /* mass */
 
-   std::vector<Index_t> m_symmX ;  /* symmetry plane nodesets */
-   std::vector<Index_t> m_symmY ;
-   std::vector<Index_t> m_symmZ ;
+   std::vector<uint8_t> m_nodeSymm ;  /* per-node symmetry plane mask */
 
    // Element-centered
 
@@ -488,6 +837,15 @@ class Domain {
    Index_t *m_regNumList ;    // Region number per domain element
    Index_t **m_regElemlist ;  // region indexset 
 
+   std::vector<EOSTask_t> m_eosTasks ;      // EOS tasks, heaviest first
+   std::vector<Index_t>   m_eosBatchElems ; // batched small region elements
+   std::vector<MinLoc_t>  m_dtPartial ;     // per-thread time constraints
+   SmallRegion_t          m_smallReg ;
+   EOSPartition_t         m_eosPart ;
+   HaloSplit_t            m_haloSplit ;
+   TaskGraph_t            m_taskGraphState ;
+   std::vector<TaskGraphBlock_t> m_taskGraphBlocks ;
+
    std::vector<Index_t>  m_nodelist ;     /* elemToNode connectivity */
 
    std::vector<Index_t>  m_lxim ;  /* element connectivity across each face */
@@ -572,7 +930,9 @@ class Domain {
    Index_t m_colLoc ;
    Index_t m_rowLoc ;
    Index_t m_planeLoc ;
-   Index_t m_tp ;
+   Index_t m_tpx ;
+   Index_t m_tpy ;
+   Index_t m_tpz ;
 
    Index_t m_sizeX ;
    Index_t m_sizeY ;
@@ -583,6 +943,21 @@ class Domain {
    Index_t m_maxPlaneSize ;
    Index_t m_maxEdgeSize ;
 
+   Int_t   m_halfStepCoords ;
+   Int_t   m_taskGraph ;
+   Int_t   m_deterministic ;
+   Int_t   m_commHybrid ;
+   Int_t   m_eosPartition ;
+   Int_t   m_regionBatch ;
+   Int_t   m_commPersistent ;
+   Int_t   m_commDatatypes ;
+   Int_t   m_commNeighbor ;
+   Int_t   m_haloOverlap ;
+   Int_t   m_commShared ;
+   Int_t   m_commRma ;
+   Int_t   m_commTeamPack ;
+   Int_t   m_commSweep ;
+
    // OMP hack 
    Index_t *m_nodeElemStart ;
    Index_t *m_nodeElemCornerList ;
@@ -606,6 +981,27 @@ struct cmdLineOpts {
    Int_t viz; // -v 
    Int_t cost; // -c
    Int_t balance; // -b
+   Int_t halfStep; // -hs
+   Int_t taskGraph; // -tg
+   Int_t deterministic; // -det
+   Int_t bind; // -bind
+   Int_t par; // -par
+   Int_t spin; // -spin
+   Int_t hybrid; // -hybrid
+   Int_t part; // -part
+   Int_t batch; // -batch
+   Int_t persist; // -persist
+   Int_t dtype; // -dtype
+   Int_t neighbor; // -neighbor
+   Int_t overlap; // -overlap
+   Int_t shm; // -shm
+   Int_t rma; // -rma, COMM_RMA_NONE when not given
+   Int_t commBench; // -commbench
+   Int_t teamPack; // -tpack
+   Int_t packBench; // -packbench
+   Int_t sweep; // -sweep
+   Int_t grid[3]; // -grid, 0 picks the process grid from the rank count
+   const char *dumpFile; // -dump, NULL when not given
 };
 
 
@@ -624,6 +1020,7 @@ void VerifyAndWriteFinalOutput(Real_t elapsed_time,
                                Domain& locDom,
                                Int_t nx,
                                Int_t numRanks);
+void DumpElemEnergy(Domain& locDom, const char *name, Int_t myRank);
 
 // lulesh-viz
 void DumpToVisit(Domain& domain, int numFiles, int myRank, int numRanks);
@@ -636,10 +1033,60 @@ void CommSend(Domain& domain, Int_t msgType,
               Index_t xferFields, Domain_member *fieldData,
               Index_t dx, Index_t dy, Index_t dz,
               bool doSend, bool planeOnly);
+void CommSendStart(Domain& domain, Int_t msgType,
+                   Index_t xferFields, Domain_member *fieldData,
+                   Index_t dx, Index_t dy, Index_t dz,
+                   bool doSend, bool planeOnly);
+void CommSendFinish(Domain& domain);
 void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData);
 void CommSyncPosVel(Domain& domain);
 void CommMonoQ(Domain& domain);
+#if USE_MPI
+MPI_Comm CommCreateCart(const Int_t side[3]);
+#endif
+void CommSetupNeighborhood(Domain& domain);
+void CommSetupShared(Domain& domain);
+void CommSetupRma(Domain& domain, Int_t sync);
+void CommSetupSweep(Domain& domain);
+void CommFreeResources(Domain& domain);
+void CommBenchmark(Domain& domain, Int_t iters, Int_t myRank);
+void CommPackBenchmark(Domain& domain, Int_t iters, Int_t myRank);
+
+// lulesh-thread
+void  ParInit(Int_t backend, Int_t numThreads, Int_t spinCount);
+void  ParFinalize();
+Int_t ParBackend();
+Int_t ParNumThreads();
+Int_t ParThreadId();
+Int_t ParTeamSize();
+void  ParRun(void (*fn)(void *), void *arg);
+void  ParBarrier();
+void  ParRange(Index_t begin, Index_t end, Index_t *myBegin, Index_t *myEnd);
+void *ParBroadcast(void *value);
+void  ParTaskSpawn(void (*fn)(void *), void *arg);
+void  ParTaskBarrier();
+
+/* Allocates on thread 0 and hands the pointer to every thread of the
+ * team.  Release from one thread only. */
+template <typename T>
+T *ParAllocate(size_t size)
+{
+   T *ptr = (ParThreadId() == 0) ? Allocate<T>(size) : NULL ;
+   return static_cast<T *>(ParBroadcast(ptr)) ;
+}
+
+/* True on the threads that make the halo exchange calls: thread 0, or
+ * every thread with the hybrid exchange (-hybrid) or the team packing
+ * (-tpack) */
+inline bool CommThread(Domain& domain)
+{
+   return (domain.commHybrid() != 0) || (domain.commTeamPack() != 0) ||
+          (ParThreadId() == 0) ;
+}
+
+// lulesh-topo
+void SetupThreadBinding(Int_t policy, Int_t myRank, Int_t numRanks, bool report);
 
 // lulesh-init
-void InitMeshDecomp(Int_t numRanks, Int_t myRank,
-                    Int_t *col, Int_t *row, Int_t *plane, Int_t *side);
+void InitMeshDecomp(Int_t numRanks, Int_t myRank, const Int_t grid[3],
+                    Int_t *col, Int_t *row, Int_t *plane, Int_t side[3]);
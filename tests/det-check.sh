@@ -0,0 +1,78 @@
+#!/bin/sh
+#
+# Checks that -det gives bitwise identical energies for any thread and
+# rank count.  Usage:
+#
+#   det-check.sh <lulesh binary> [<mpiexec> [<numproc flag>]]
+#
+# Every run writes the final e of each element with -dump; the sorted
+# dumps must be identical.  Without an mpiexec only the thread counts
+# are compared.  The rank comparison uses one region (-r 1), because
+# the region layout is drawn per rank.
+
+LULESH=$1
+MPIEXEC=$2
+NPFLAG=${3:--np}
+SIZE=8
+ITERS=40
+
+if [ -z "$LULESH" ] || [ ! -x "$LULESH" ]; then
+   echo "usage: $0 <lulesh binary> [<mpiexec> [<numproc flag>]]"
+   exit 2
+fi
+
+# Open MPI refuses to run as root or to oversubscribe by default
+if [ -n "$MPIEXEC" ]; then
+   if [ "$(id -u)" = 0 ]; then
+      export OMPI_ALLOW_RUN_AS_ROOT=1 OMPI_ALLOW_RUN_AS_ROOT_CONFIRM=1
+   fi
+   export OMPI_MCA_rmaps_base_oversubscribe=${OMPI_MCA_rmaps_base_oversubscribe:-1}
+fi
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/lulesh-det.XXXXXX") || exit 2
+trap 'rm -rf "$WORK"' EXIT
+
+# run <name> <ranks> <threads> <lulesh options>
+run() {
+   name=$1 ; ranks=$2 ; threads=$3 ; shift 3
+   if [ -n "$MPIEXEC" ]; then
+      OMP_NUM_THREADS=$threads "$MPIEXEC" $NPFLAG $ranks "$LULESH" -q -det \
+         -dump "$WORK/$name" "$@" || return 1
+   else
+      OMP_NUM_THREADS=$threads "$LULESH" -q -det -dump "$WORK/$name" "$@" || return 1
+   fi
+   cat "$WORK/$name".* | sort -n > "$WORK/$name.all"
+   if [ ! -s "$WORK/$name.all" ]; then
+      echo "FAIL: $name wrote no dump"
+      return 1
+   fi
+}
+
+# same <reference> <name>
+same() {
+   if cmp -s "$WORK/$1.all" "$WORK/$2.all"; then
+      echo "ok: $2 matches $1"
+   else
+      echo "FAIL: $2 differs from $1"
+      diff "$WORK/$1.all" "$WORK/$2.all" | head -5
+      STATUS=1
+   fi
+}
+
+STATUS=0
+
+for t in 1 2 4; do
+   run t$t 1 $t -s $SIZE -i $ITERS || exit 1
+done
+same t1 t2
+same t1 t4
+
+if [ -n "$MPIEXEC" ]; then
+   run r1 1 1 -s $SIZE -i $ITERS -r 1 || exit 1
+   run r8 8 1 -s $((SIZE/2)) -i $ITERS -r 1 || exit 1
+   run r8t2 8 2 -s $((SIZE/2)) -i $ITERS -r 1 || exit 1
+   same r1 r8
+   same r1 r8t2
+fi
+
+exit $STATUS